@@ -170,7 +170,8 @@ typedef struct cg_import_s {
 	thread_t *(*Thread)(const char *name, ThreadRunFunc run, void *data, thread_options_t options);
 
 	/**
-	 * @brief Waits for the previously started thread, blocking the calling thread.
+	 * @brief Waits for the previously started thread. The calling thread runs other
+	 * pending jobs while it waits.
 	 * @param thread The thread.
 	 */
 	void (*Wait)(thread_t *thread);
@@ -483,7 +484,7 @@ typedef struct cg_import_s {
 	vec3_t (*ReadPosition)(void);
 
 	/**
-	 * @brief Reads a 32 bit precision directional vector from the last received network message.
+	 * @brief Reads a 16 bit octahedral encoded directional vector from the last received network message.
 	 */
 	vec3_t (*ReadDir)(void);
 
@@ -21,6 +21,30 @@
 
 #include "cl_local.h"
 
+/**
+ * @brief Writes a record containing `msg` to the demo file, and clears `msg`.
+ */
+static void Cl_WriteDemoRecord(mem_buf_t *msg, demo_record_type_t type, uint32_t time) {
+
+	const demo_record_t record = {
+		.length = LittleLong((int32_t) msg->size),
+		.time = LittleLong((int32_t) time),
+		.type = LittleLong(type)
+	};
+
+	Fs_Write(cls.demo_file, &record, sizeof(record), 1);
+	Fs_Write(cls.demo_file, msg->data, msg->size, 1);
+
+	Mem_ClearBuffer(msg);
+}
+
+/**
+ * @return The demo time of the current frame.
+ */
+static uint32_t Cl_DemoTime(void) {
+	return (uint32_t) (cl.frame.frame_num - cls.demo_frame_num) * QUETOO_TICK_MILLIS;
+}
+
 /**
  * @brief Writes server_data, config_strings, and baselines once a non-delta
  * compressed frame arrives from the server.
@@ -46,10 +70,7 @@ static void Cl_WriteDemoHeader(void) {
 	for (int32_t i = 0; i < MAX_CONFIG_STRINGS; i++) {
 		if (*cl.config_strings[i] != '\0') {
 			if (msg.size + strlen(cl.config_strings[i]) + 32 > msg.max_size) { // write it out
-				const int32_t len = LittleLong((int32_t) msg.size);
-				Fs_Write(cls.demo_file, &len, sizeof(len), 1);
-				Fs_Write(cls.demo_file, msg.data, msg.size, 1);
-				msg.size = 0;
+				Cl_WriteDemoRecord(&msg, DEMO_RECORD_MESSAGE, 0);
 			}
 
 			Net_WriteByte(&msg, SV_CMD_CONFIG_STRING);
@@ -66,10 +87,7 @@ static void Cl_WriteDemoHeader(void) {
 		}
 
 		if (msg.size + 64 > msg.max_size) { // write it out
-			const int32_t len = LittleLong((int32_t) msg.size);
-			Fs_Write(cls.demo_file, &len, sizeof(len), 1);
-			Fs_Write(cls.demo_file, msg.data, msg.size, 1);
-			msg.size = 0;
+			Cl_WriteDemoRecord(&msg, DEMO_RECORD_MESSAGE, 0);
 		}
 
 		Net_WriteByte(&msg, SV_CMD_BASELINE);
@@ -80,18 +98,100 @@ static void Cl_WriteDemoHeader(void) {
 	Net_WriteString(&msg, "precache 0\n");
 
 	// write it to the demo file
+	Cl_WriteDemoRecord(&msg, DEMO_RECORD_MESSAGE, 0);
 
-	const int32_t len = LittleLong((int32_t) msg.size);
-
-	Fs_Write(cls.demo_file, &len, sizeof(len), 1);
-	Fs_Write(cls.demo_file, msg.data, msg.size, 1);
+	cls.demo_frame_num = cl.frame.frame_num;
 
 	Com_Debug(DEBUG_CLIENT, "Demo started\n");
 	// the rest of the demo file will be individual frames
 }
 
 /**
- * @brief Dumps the current net message, prefixed by the length.
+ * @brief Writes the config strings which have changed since recording began, as
+ * keyframe records. If `original` is true, their values at the beginning of the
+ * demo are written, otherwise their current values are written.
+ */
+static void Cl_WriteDemoConfigStrings(uint32_t time, bool original) {
+	mem_buf_t msg;
+	byte buffer[MAX_MSG_SIZE];
+
+	Mem_InitBuffer(&msg, buffer, sizeof(buffer));
+
+	for (int32_t i = 0; i < MAX_CONFIG_STRINGS; i++) {
+		if (cls.demo_config_strings[i]) {
+
+			const char *s = original ? cls.demo_config_strings[i] : cl.config_strings[i];
+
+			if (msg.size + strlen(s) + 32 > msg.max_size) { // write it out
+				Cl_WriteDemoRecord(&msg, DEMO_RECORD_KEYFRAME, time);
+			}
+
+			Net_WriteByte(&msg, SV_CMD_CONFIG_STRING);
+			Net_WriteShort(&msg, i);
+			Net_WriteString(&msg, s);
+		}
+	}
+
+	if (msg.size) {
+		Cl_WriteDemoRecord(&msg, DEMO_RECORD_KEYFRAME, time);
+	}
+}
+
+/**
+ * @brief Adds a keyframe to the demo index. The current message contains an
+ * uncompressed frame, and is preceded by the config strings which have changed
+ * since recording began, so that playback may begin from here.
+ */
+static void Cl_WriteDemoKeyframe(uint32_t time) {
+
+	const demo_keyframe_t keyframe = {
+		.time = (int32_t) time,
+		.offset = (int32_t) Fs_Tell(cls.demo_file)
+	};
+
+	g_array_append_val(cls.demo_keyframes, keyframe);
+
+	Cl_WriteDemoConfigStrings(time, false);
+
+	cls.demo_keyframe_time = time + DEMO_KEYFRAME_INTERVAL;
+
+	Com_Debug(DEBUG_CLIENT, "Demo keyframe at %ums\n", time);
+}
+
+/**
+ * @return True if the client should request an uncompressed frame from the server,
+ * to begin recording or to write the next keyframe.
+ */
+bool Cl_DemoKeyframePending(void) {
+
+	if (!cls.demo_file) {
+		return false;
+	}
+
+	if (cls.demo_frame_num == -1) {
+		return true;
+	}
+
+	return Cl_DemoTime() >= cls.demo_keyframe_time;
+}
+
+/**
+ * @brief Saves the original value of the config string at `index`, which is about
+ * to change, so that seeking within the demo may restore it.
+ */
+void Cl_TouchDemoConfigString(int32_t index) {
+
+	if (!cls.demo_file || cls.demo_frame_num == -1) {
+		return;
+	}
+
+	if (!cls.demo_config_strings[index]) {
+		cls.demo_config_strings[index] = Mem_TagCopyString(cl.config_strings[index], MEM_TAG_CLIENT);
+	}
+}
+
+/**
+ * @brief Dumps the current net message, prefixed by a record.
  */
 void Cl_WriteDemoMessage(void) {
 
@@ -99,7 +199,7 @@ void Cl_WriteDemoMessage(void) {
 		return;
 	}
 
-	if (!Fs_Tell(cls.demo_file)) {
+	if (cls.demo_frame_num == -1) {
 		if (cl.frame.delta_frame_num < 0) {
 			Com_Debug(DEBUG_CLIENT, "Received uncompressed frame, writing demo header..\n");
 			Cl_WriteDemoHeader();
@@ -108,29 +208,71 @@ void Cl_WriteDemoMessage(void) {
 		}
 	}
 
+	const uint32_t time = Cl_DemoTime();
+
+	if (cl.frame.delta_frame_num < 0 && time >= cls.demo_keyframe_time) {
+		Cl_WriteDemoKeyframe(time);
+	}
+
 	// the first eight bytes are just packet sequencing stuff
-	const int32_t len = LittleLong((int32_t) (net_message.size - 8));
+	mem_buf_t msg = {
+		.data = net_message.data + 8,
+		.size = net_message.size - 8,
+	};
 
-	Fs_Write(cls.demo_file, &len, sizeof(len), 1);
-	Fs_Write(cls.demo_file, net_message.data + 8, len, 1);
+	Cl_WriteDemoRecord(&msg, DEMO_RECORD_MESSAGE, time);
 }
 
 /**
  * @brief Stop recording a demo
  */
 void Cl_Stop_f(void) {
-	int32_t len = -1;
 
 	if (!cls.demo_file) {
 		Com_Print("Not recording a demo\n");
 		return;
 	}
 
-	// finish up
-	Fs_Write(cls.demo_file, &len, sizeof(len), 1);
+	// terminate the messages
+	const demo_record_t record = {
+		.length = LittleLong(-1)
+	};
+
+	Fs_Write(cls.demo_file, &record, sizeof(record), 1);
+
+	// write the original config strings, the index and the trailer
+	const demo_trailer_t trailer = {
+		.num_keyframes = LittleLong(cls.demo_keyframes->len),
+		.offset = LittleLong((int32_t) Fs_Tell(cls.demo_file)),
+		.ident = LittleLong(DEMO_IDENT)
+	};
+
+	Cl_WriteDemoConfigStrings(0, true);
+
+	for (guint i = 0; i < cls.demo_keyframes->len; i++) {
+		const demo_keyframe_t *in = &g_array_index(cls.demo_keyframes, demo_keyframe_t, i);
+		const demo_keyframe_t out = {
+			.time = LittleLong(in->time),
+			.offset = LittleLong(in->offset)
+		};
+		Fs_Write(cls.demo_file, &out, sizeof(out), 1);
+	}
+
+	Fs_Write(cls.demo_file, &trailer, sizeof(trailer), 1);
 	Fs_Close(cls.demo_file);
 
 	cls.demo_file = NULL;
+
+	g_array_free(cls.demo_keyframes, true);
+	cls.demo_keyframes = NULL;
+
+	for (int32_t i = 0; i < MAX_CONFIG_STRINGS; i++) {
+		if (cls.demo_config_strings[i]) {
+			Mem_Free(cls.demo_config_strings[i]);
+			cls.demo_config_strings[i] = NULL;
+		}
+	}
+
 	Com_Print("Stopped demo\n");
 }
 
@@ -164,6 +306,17 @@ void Cl_Record_f(void) {
 		return;
 	}
 
+	const int32_t header[] = {
+		LittleLong(DEMO_IDENT),
+		LittleLong(DEMO_VERSION)
+	};
+
+	Fs_Write(cls.demo_file, header, sizeof(header), 1);
+
+	cls.demo_frame_num = -1;
+	cls.demo_keyframe_time = 0;
+	cls.demo_keyframes = g_array_new(false, false, sizeof(demo_keyframe_t));
+
 	Com_Print("Recording to %s\n", cls.demo_filename);
 }
 
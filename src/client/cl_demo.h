@@ -24,6 +24,8 @@
 #include "cl_types.h"
 
 #ifdef __CL_LOCAL_H__
+bool Cl_DemoKeyframePending(void);
+void Cl_TouchDemoConfigString(int32_t index);
 void Cl_WriteDemoMessage(void);
 void Cl_Record_f(void);
 void Cl_Stop_f(void);
@@ -169,7 +169,7 @@ static void Cl_ParseEntities(const cl_frame_t *delta_frame, cl_frame_t *frame) {
 		}
 
 		// now deal with the new entity
-		const uint16_t bits = Net_ReadShort(&net_message);
+		const uint16_t bits = Net_ReadVarLong(&net_message);
 
 		if (bits & U_REMOVE) { // remove it, no delta
 
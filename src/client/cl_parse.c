@@ -141,7 +141,7 @@ static void Cl_ParseBaseline(void) {
 	static entity_state_t null_state;
 
 	const uint16_t number = Net_ReadShort(&net_message);
-	const uint16_t bits = Net_ReadShort(&net_message);
+	const uint16_t bits = Net_ReadVarLong(&net_message);
 
 	cl_entity_t *ent = &cl.entities[number];
 
@@ -166,10 +166,12 @@ static const char *Cl_ParseCbufText(void) {
 int32_t Cl_ParseConfigString(void) {
 	const int32_t i = Net_ReadShort(&net_message);
 
-	if (i >= MAX_CONFIG_STRINGS) {
+	if (i < 0 || i >= MAX_CONFIG_STRINGS) {
 		Com_Error(ERROR_DROP, "Invalid index %i\n", i);
 	}
 
+	Cl_TouchDemoConfigString(i);
+
 	strcpy(cl.config_strings[i], Net_ReadString(&net_message));
 	const char *s = cl.config_strings[i];
 
@@ -445,6 +445,10 @@ typedef struct {
 
 	char demo_filename[MAX_OS_PATH];
 	file_t *demo_file;
+	int32_t demo_frame_num; // the frame at which recording began, or -1 until the header is written
+	uint32_t demo_keyframe_time; // the demo time at which the next keyframe is due
+	GArray *demo_keyframes; // the demo index
+	char *demo_config_strings[MAX_CONFIG_STRINGS]; // original values of changed config strings
 
 	GList *servers; // list of cl_server_info_t from all sources
 
@@ -48,7 +48,8 @@ static bsp_lump_meta_t bsp_lump_meta[BSP_LUMP_LAST] = {
 	BSP_LUMP_NUM_STRUCT(models, MAX_BSP_MODELS),
 	BSP_LUMP_NUM_STRUCT(lights, MAX_BSP_LIGHTS),
 	BSP_LUMP_SIZE_STRUCT(lightmap, MAX_BSP_LIGHTMAP_SIZE),
-	BSP_LUMP_SIZE_STRUCT(lightgrid, MAX_BSP_LIGHTGRID_SIZE)
+	BSP_LUMP_SIZE_STRUCT(lightgrid, MAX_BSP_LIGHTGRID_SIZE),
+	BSP_LUMP_SIZE_STRUCT(vis, MAX_BSP_VIS_SIZE)
 };
 
 /**
@@ -342,6 +343,29 @@ static void Bsp_SwapLightgrid(void *lump, const int32_t num) {
 	lightgrid->size = LittleVec3i(lightgrid->size);
 }
 
+/**
+ * @brief Swap function.
+ */
+static void Bsp_SwapVis(void *lump, const int32_t num) {
+
+	bsp_vis_t *vis = (bsp_vis_t *) lump;
+
+	if (num < (int32_t) sizeof(int32_t)) {
+		return;
+	}
+
+	vis->num_clusters = LittleLong(vis->num_clusters);
+
+	// the cluster count is not yet validated, so swap only the offsets the lump holds
+	const int32_t num_clusters = Mini(vis->num_clusters,
+		(int32_t) ((num - sizeof(int32_t)) / (2 * sizeof(int32_t))));
+
+	for (int32_t i = 0; i < num_clusters; i++) {
+		vis->bit_offsets[i][BSP_VIS_PVS] = LittleLong(vis->bit_offsets[i][BSP_VIS_PVS]);
+		vis->bit_offsets[i][BSP_VIS_PHS] = LittleLong(vis->bit_offsets[i][BSP_VIS_PHS]);
+	}
+}
+
 /**
  * @brief Swap entry point.
  */
@@ -365,6 +389,7 @@ static void Bsp_SwapLump(const bsp_lump_id_t lump_id, void *lump, int32_t count)
 		Bsp_SwapLights,
 		Bsp_SwapLightmap,
 		Bsp_SwapLightgrid,
+		Bsp_SwapVis,
 	};
 
 	if (swap[lump_id]) {
@@ -374,13 +399,27 @@ static void Bsp_SwapLump(const bsp_lump_id_t lump_id, void *lump, int32_t count)
 	}
 }
 
+/**
+ * @return The number of lumps present in the header of the specified BSP file.
+ * @remarks Older versions have shorter headers, as lumps are only ever appended.
+ */
+static bsp_lump_id_t Bsp_NumLumps(const bsp_header_t *file) {
+
+	switch (LittleLong(file->version)) {
+		case 71:
+			return BSP_LUMP_VIS;
+		default:
+			return BSP_LUMP_LAST;
+	}
+}
+
 /**
  * @brief Calculates the effective size of the BSP file.
  */
 int64_t Bsp_Size(const bsp_header_t *file) {
 	int64_t total = 0;
 
-	for (bsp_lump_id_t lump = BSP_LUMP_FIRST; lump < BSP_LUMP_LAST; lump++) {
+	for (bsp_lump_id_t lump = BSP_LUMP_FIRST; lump < Bsp_NumLumps(file); lump++) {
 		total += LittleLong(file->lumps[lump].file_len);
 	}
 
@@ -397,11 +436,13 @@ int32_t Bsp_Verify(const bsp_header_t *file) {
 		return -1;
 	}
 
-	if (LittleLong(file->version) != BSP_VERSION) {
+	const int32_t version = LittleLong(file->version);
+
+	if (version < BSP_VERSION_MIN || version > BSP_VERSION) {
 		return -1;
 	}
 
-	return BSP_VERSION;
+	return version;
 }
 
 /**
@@ -409,6 +450,11 @@ int32_t Bsp_Verify(const bsp_header_t *file) {
  */
 static void Bsp_GetLumpPosition(const bsp_header_t *file, const bsp_lump_id_t lump_id, bsp_lump_t *lump) {
 
+	if (lump_id >= Bsp_NumLumps(file)) {
+		memset(lump, 0, sizeof(*lump));
+		return;
+	}
+
 	*lump = file->lumps[lump_id];
 	lump->file_len = LittleLong(lump->file_len);
 	lump->file_ofs = LittleLong(lump->file_ofs);
@@ -27,7 +27,13 @@
  * @brief BSP file identification.
  */
 #define BSP_IDENT (('P' << 24) + ('S' << 16) + ('B' << 8) + 'I') // "IBSP"
-#define BSP_VERSION	71
+#define BSP_VERSION	72
+
+/**
+ * @brief The oldest BSP version that may still be loaded. Version 71 files predate
+ * the visibility lump, and are treated as having no visibility information.
+ */
+#define BSP_VERSION_MIN 71
 
 /**
  * @brief BSP file format limits.
@@ -46,10 +52,17 @@
 #define MAX_BSP_LEAF_BRUSHES 		0x20000
 #define MAX_BSP_LEAF_FACES			0x20000
 #define MAX_BSP_LEAFS				0x20000
+#define MAX_BSP_CLUSTERS			MAX_BSP_LEAFS
 #define MAX_BSP_MODELS				0x400
 #define MAX_BSP_LIGHTS				0x1000
 #define MAX_BSP_LIGHTMAP_SIZE		0x60000000
 #define MAX_BSP_LIGHTGRID_SIZE		0x2400000
+#define MAX_BSP_VIS_SIZE			0x1000000
+
+/**
+ * @brief The size in bytes of a cluster visibility bit set.
+ */
+#define MAX_BSP_CLUSTER_BYTES		(MAX_BSP_CLUSTERS >> 3)
 
 /**
  * @brief Lightmap luxel size in world units.
@@ -128,6 +141,7 @@ typedef enum {
 	BSP_LUMP_LIGHTS,
 	BSP_LUMP_LIGHTMAP,
 	BSP_LUMP_LIGHTGRID,
+	BSP_LUMP_VIS,
 	BSP_LUMP_LAST
 } bsp_lump_id_t;
 
@@ -340,6 +354,25 @@ typedef struct {
 	vec3i_t size;
 } bsp_lightgrid_t;
 
+/**
+ * @brief Offsets into the visibility lump for the potentially visible and potentially
+ * hearable sets of each cluster.
+ */
+typedef enum {
+	BSP_VIS_PVS,
+	BSP_VIS_PHS
+} bsp_vis_set_t;
+
+/**
+ * @brief Cluster visibility is stored as run-length encoded bit sets, in which runs of
+ * zero bytes are written as a zero followed by the run length. The bit offsets are
+ * relative to the start of the lump.
+ */
+typedef struct bsp_vis_s {
+	int32_t num_clusters;
+	int32_t bit_offsets[][2]; // [num_clusters][BSP_VIS_PVS, BSP_VIS_PHS]
+} bsp_vis_t;
+
 /**
  * @brief BSP file lumps in their native file formats. The data is stored as pointers
  * so that we don't take up an ungodly amount of space (285 MB of memory!).
@@ -398,6 +431,9 @@ typedef struct bsp_file_s {
 	int32_t lightgrid_size;
 	bsp_lightgrid_t *lightgrid;
 
+	int32_t vis_size;
+	bsp_vis_t *vis;
+
 	bsp_lump_id_t loaded_lumps;
 } bsp_file_t;
 
@@ -93,6 +93,8 @@ static void Cm_LoadBspLeafs(cm_bsp_t *bsp) {
 		out->cluster = in->cluster;
 		out->first_leaf_brush = in->first_leaf_brush;
 		out->num_leaf_brushes = in->num_leaf_brushes;
+
+		bsp->num_clusters = Maxi(bsp->num_clusters, out->cluster + 1);
 	}
 }
 
@@ -184,6 +186,65 @@ static void Cm_LoadBspInlineModels(cm_bsp_t *bsp) {
 	}
 }
 
+/**
+ * @return True if the visibility lump holds a pair of offsets for every cluster, and
+ * every offset lies within the lump, past the offset table.
+ */
+static bool Cm_ValidateBspVis(const cm_bsp_t *bsp) {
+
+	if (bsp->vis->num_clusters != bsp->num_clusters) {
+		Com_Warn("Visibility has %d clusters, expected %d\n", bsp->vis->num_clusters, bsp->num_clusters);
+		return false;
+	}
+
+	const size_t offsets_size = sizeof(int32_t) + (size_t) bsp->num_clusters * 2 * sizeof(int32_t);
+
+	if ((size_t) bsp->vis_size < offsets_size) {
+		Com_Warn("Visibility lump is too small for %d clusters\n", bsp->num_clusters);
+		return false;
+	}
+
+	for (int32_t i = 0; i < bsp->num_clusters; i++) {
+		for (int32_t j = 0; j < 2; j++) {
+			const int32_t offset = bsp->vis->bit_offsets[i][j];
+			if (offset < (int32_t) offsets_size || offset >= bsp->vis_size) {
+				Com_Warn("Visibility offset %d for cluster %d is out of bounds\n", offset, i);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief
+ */
+static void Cm_LoadBspVis(cm_bsp_t *bsp) {
+
+	bsp->vis_size = bsp->file->vis_size;
+
+	if (bsp->vis_size == 0) {
+		Com_Debug(DEBUG_COLLISION, "No visibility information, all clusters are visible\n");
+		return;
+	}
+
+	if (bsp->vis_size < (int32_t) sizeof(int32_t)) {
+		Com_Warn("Visibility lump is truncated\n");
+		bsp->vis_size = 0;
+		return;
+	}
+
+	bsp->vis = Mem_TagMalloc(bsp->vis_size, MEM_TAG_COLLISION);
+	memcpy(bsp->vis, bsp->file->vis, bsp->vis_size);
+
+	if (Cm_ValidateBspVis(bsp) == false) {
+		Mem_Free(bsp->vis);
+		bsp->vis = NULL;
+		bsp->vis_size = 0;
+	}
+}
+
 /**
  * @brief
  */
@@ -233,7 +294,8 @@ static void Cm_LoadBspMaterials(cm_bsp_t *bsp) {
 	(1 << BSP_LUMP_LEAF_BRUSHES) | \
 	(1 << BSP_LUMP_BRUSHES) | \
 	(1 << BSP_LUMP_BRUSH_SIDES) | \
-	(1 << BSP_LUMP_MODELS)
+	(1 << BSP_LUMP_MODELS) | \
+	(1 << BSP_LUMP_VIS)
 
 /**
  * @brief Loads in the BSP and all sub-models for collision detection. This
@@ -242,6 +304,7 @@ static void Cm_LoadBspMaterials(cm_bsp_t *bsp) {
  */
 cm_bsp_model_t *Cm_LoadBspModel(const char *name, int64_t *size) {
 	static bsp_file_t file;
+	static uint32_t generation;
 
 	Bsp_UnloadLumps(&file, BSP_LUMPS_ALL);
 
@@ -255,9 +318,11 @@ cm_bsp_model_t *Cm_LoadBspModel(const char *name, int64_t *size) {
 	Mem_Free(cm_bsp.models);
 	Mem_Free(cm_bsp.entities);
 	Mem_Free(cm_bsp.materials);
+	Mem_Free(cm_bsp.vis);
 
 	memset(&cm_bsp, 0, sizeof(cm_bsp));
 	cm_bsp.file = &file;
+	cm_bsp.generation = ++generation;
 
 	// clean up and return
 	if (!name) {
@@ -304,6 +369,7 @@ cm_bsp_model_t *Cm_LoadBspModel(const char *name, int64_t *size) {
 	Cm_LoadBspBrushSides(&cm_bsp);
 	Cm_LoadBspBrushes(&cm_bsp);
 	Cm_LoadBspInlineModels(&cm_bsp);
+	Cm_LoadBspVis(&cm_bsp);
 
 	Cm_InitBoxHull(&cm_bsp);
 
@@ -373,6 +439,127 @@ int32_t Cm_LeafCluster(const int32_t leaf_num) {
 	return cm_bsp.leafs[leaf_num].cluster;
 }
 
+/**
+ * @return The number of visibility clusters in the world model.
+ */
+int32_t Cm_NumClusters(void) {
+	return cm_bsp.num_clusters;
+}
+
+/**
+ * @brief Decompresses the run-length encoded visibility set at `offset` into `out`.
+ */
+static void Cm_DecompressVis(const int32_t offset, byte *out) {
+
+	const int32_t row = (cm_bsp.num_clusters + 7) >> 3;
+
+	if (offset <= 0 || offset >= cm_bsp.vis_size) {
+		Com_Warn("Bad visibility offset: %d\n", offset);
+		memset(out, 0xff, row);
+		return;
+	}
+
+	const byte *in = (byte *) cm_bsp.vis + offset;
+	const byte *end = (byte *) cm_bsp.vis + cm_bsp.vis_size;
+
+	byte *out_p = out;
+
+	while (out_p - out < row && in < end) {
+
+		if (*in) {
+			*out_p++ = *in++;
+			continue;
+		}
+
+		if (in + 1 == end) {
+			break;
+		}
+
+		int32_t count = in[1];
+		in += 2;
+
+		if ((out_p - out) + count > row) {
+			Com_Debug(DEBUG_COLLISION, "Visibility overrun\n");
+			count = row - (int32_t) (out_p - out);
+		}
+
+		memset(out_p, 0, count);
+		out_p += count;
+	}
+
+	if (out_p - out < row) {
+		Com_Warn("Truncated visibility at offset %d\n", offset);
+		memset(out_p, 0xff, row - (out_p - out));
+	}
+}
+
+/**
+ * @brief Resolves the visibility set of the given type for the specified cluster.
+ */
+static void Cm_ClusterVis(const int32_t cluster, const bsp_vis_set_t set, byte *out) {
+
+	const int32_t row = (cm_bsp.num_clusters + 7) >> 3;
+
+	if (cluster < 0 || cluster >= cm_bsp.num_clusters) {
+		memset(out, 0, row);
+	} else if (cm_bsp.vis == NULL) {
+		memset(out, 0xff, row);
+	} else {
+		Cm_DecompressVis(cm_bsp.vis->bit_offsets[cluster][set], out);
+	}
+}
+
+/**
+ * @brief Resolves the potentially visible set for the given cluster into `pvs`, which
+ * must be at least `(Cm_NumClusters() + 7) >> 3` bytes.
+ * @remarks If the BSP was compiled without visibility, every cluster is visible.
+ */
+void Cm_ClusterPVS(const int32_t cluster, byte *pvs) {
+	Cm_ClusterVis(cluster, BSP_VIS_PVS, pvs);
+}
+
+/**
+ * @brief Resolves the potentially hearable set for the given cluster into `phs`, which
+ * must be at least `(Cm_NumClusters() + 7) >> 3` bytes. The hearable set is the union of
+ * the visible sets of all clusters visible from `cluster`.
+ * @remarks If the BSP was compiled without visibility, every cluster is hearable.
+ */
+void Cm_ClusterPHS(const int32_t cluster, byte *phs) {
+	Cm_ClusterVis(cluster, BSP_VIS_PHS, phs);
+}
+
+/**
+ * @return True if the given cluster is set in the specified visibility bit set.
+ */
+bool Cm_ClusterVisible(const int32_t cluster, const byte *pvs) {
+
+	if (cluster < 0 || cluster >= cm_bsp.num_clusters) {
+		return false;
+	}
+
+	return pvs[cluster >> 3] & (1 << (cluster & 7));
+}
+
+/**
+ * @return True if any leaf beneath the given node is in a cluster that is set in the
+ * specified visibility bit set. This is used for entities spanning too many clusters
+ * to enumerate.
+ */
+bool Cm_HeadnodeVisible(const int32_t node_num, const byte *pvs) {
+
+	if (node_num < 0) {
+		return Cm_ClusterVisible(cm_bsp.leafs[-1 - node_num].cluster, pvs);
+	}
+
+	const cm_bsp_node_t *node = &cm_bsp.nodes[node_num];
+
+	if (Cm_HeadnodeVisible(node->children[0], pvs)) {
+		return true;
+	}
+
+	return Cm_HeadnodeVisible(node->children[1], pvs);
+}
+
 /**
  * @brief
  */
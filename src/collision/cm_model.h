@@ -34,6 +34,12 @@ cm_entity_t *Cm_Worldspawn(void);
 int32_t Cm_LeafContents(const int32_t leaf_num);
 int32_t Cm_LeafCluster(const int32_t leaf_num);
 
+int32_t Cm_NumClusters(void);
+void Cm_ClusterPVS(const int32_t cluster, byte *pvs);
+void Cm_ClusterPHS(const int32_t cluster, byte *phs);
+bool Cm_ClusterVisible(const int32_t cluster, const byte *pvs);
+bool Cm_HeadnodeVisible(const int32_t node_num, const byte *pvs);
+
 const cm_bsp_t *Cm_Bsp(void);
 
 #ifdef __CM_LOCAL_H__
@@ -19,8 +19,129 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  */
 
+#include <stdatomic.h>
+
 #include "cm_local.h"
 
+/**
+ * @brief The number of traces of a batch which descend the tree together.
+ */
+#define CM_TRACE_PACKET 32
+
+/**
+ * @brief The number of inline model transforms each thread's brush cache remembers.
+ */
+#define MAX_CM_TRANSFORMS 64
+
+/**
+ * @brief A brush, transformed by the matrix of the inline model it was last traced in.
+ */
+typedef struct {
+	/**
+	 * @brief The stamp of the transform these bounds, and the brush's planes, reflect.
+	 */
+	uint32_t stamp;
+
+	/**
+	 * @brief The transformed brush bounds.
+	 */
+	box3_t bounds;
+} cm_transformed_brush_t;
+
+/**
+ * @brief An inline model's transform, and the stamp identifying brushes transformed by it.
+ */
+typedef struct {
+	int32_t head_node;
+	mat4_t matrix;
+	uint32_t stamp;
+} cm_transform_t;
+
+/**
+ * @brief Each thread caches the brushes of the inline models it traces, transformed by
+ * their matrices. Each brush belongs to exactly one inline model, so the cache is indexed
+ * by brush and stamped with the transform it was built for. When a model moves, it
+ * receives a new stamp, and its brushes are transformed again on first use. Every other
+ * trace against the model until it moves again reuses them.
+ */
+typedef struct {
+	/**
+	 * @brief The BSP generation that the cache was allocated for.
+	 */
+	uint32_t generation;
+
+	/**
+	 * @brief The most recently issued transform stamp.
+	 */
+	uint32_t stamp;
+
+	/**
+	 * @brief The most recent transforms, two per hash of the head node, so that the client
+	 * and server of a listen server may trace the same model without thrashing.
+	 */
+	cm_transform_t transforms[MAX_CM_TRANSFORMS];
+
+	/**
+	 * @brief The transformed brushes, indexed by brush number.
+	 */
+	cm_transformed_brush_t *brushes;
+
+	/**
+	 * @brief The transformed brush side planes, indexed by brush side number.
+	 */
+	cm_bsp_plane_t *planes;
+} cm_transform_cache_t;
+
+static __thread cm_transform_cache_t cm_transform_cache;
+
+/**
+ * @brief Each thread marks the brushes tested by its traces, so that brushes referenced by
+ * several leafs are tested only once per trace. Marks are stamped with the trace that made
+ * them, so that they need never be cleared.
+ * @remarks Traces which are in flight together, as in a packet of Cm_BoxTraces, may
+ * overwrite one another's marks. This costs a redundant test, but never a missed one.
+ */
+typedef struct {
+	/**
+	 * @brief The BSP generation that the marks were allocated for.
+	 */
+	uint32_t generation;
+
+	/**
+	 * @brief The most recently issued trace stamp.
+	 */
+	uint32_t stamp;
+
+	/**
+	 * @brief The stamp of the trace which last tested each brush, including the box hull.
+	 */
+	uint32_t *brushes;
+} cm_brush_marks_t;
+
+static __thread cm_brush_marks_t cm_brush_marks;
+
+/**
+ * @brief A thread's trace counters. Only the owning thread writes them, so counting a trace
+ * needs no read-modify-write. These outlive their thread, so that its traces remain counted.
+ */
+typedef struct cm_trace_counters_s {
+	atomic_llong traces;
+	atomic_llong brushes;
+	atomic_llong duplicate_brushes;
+	struct cm_trace_counters_s *next;
+} cm_trace_counters_t;
+
+/**
+ * @brief The counters of all threads which have traced, summed by Cm_TraceStats.
+ */
+static struct {
+	SDL_SpinLock lock;
+	cm_trace_counters_t *counters;
+	cm_trace_stats_t reset; // the sums at the last reset
+} cm_trace_stats;
+
+static __thread cm_trace_counters_t *cm_trace_counters;
+
 /**
  * @brief Box trace data encapsulation and context management.
  */
@@ -76,9 +197,34 @@ typedef struct {
 	bool is_transformed;
 
 	/**
-	 * @brief The brush cache, to avoid multiple tests against the same brush.
+	 * @brief The stamp of this trace's transform in the brush cache, or 0 if uncached.
+	 */
+	uint32_t stamp;
+
+	/**
+	 * @brief The thread's transformed brushes, if this trace is cached.
+	 */
+	cm_transformed_brush_t *brushes;
+
+	/**
+	 * @brief The thread's transformed brush side planes, if this trace is cached.
+	 */
+	cm_bsp_plane_t *planes;
+
+	/**
+	 * @brief The thread's brush marks, to avoid multiple tests against the same brush.
+	 */
+	uint32_t *marks;
+
+	/**
+	 * @brief The stamp marking brushes tested by this trace.
 	 */
-	int32_t brush_cache[128];
+	uint32_t mark;
+
+	/**
+	 * @brief The number of brushes tested, and of duplicate tests avoided.
+	 */
+	int32_t num_brushes, num_duplicate_brushes;
 
 	/**
 	 * @brief The trace result.
@@ -92,32 +238,125 @@ typedef struct {
 } cm_trace_data_t;
 
 /**
- * @brief
+ * @return True if the brush has already been tested by this trace, marking it if not.
  */
 static inline bool Cm_BrushAlreadyTested(cm_trace_data_t *data, int32_t brush_num) {
-	const int32_t hash = brush_num & (lengthof(data->brush_cache) - 1);
 
-	const bool skip = (data->brush_cache[hash] == brush_num);
+	if (data->marks[brush_num] == data->mark) {
+		data->num_duplicate_brushes++;
+		return true;
+	}
 
-	data->brush_cache[hash] = brush_num;
+	data->marks[brush_num] = data->mark;
+	data->num_brushes++;
 
-	return skip;
+	return false;
 }
 
 /**
- * @brief 
+ * @brief Resolves the stamp for the trace's head node and matrix, issuing a new one if
+ * the model has moved since it was last traced by this thread. Only the inline models of
+ * the loaded BSP are cached; the box hull is rewritten for every entity it represents.
  */
-static inline bool Cm_TraceIntersect(cm_trace_data_t *data, const cm_bsp_brush_t *brush) {
+static void Cm_TransformCache(cm_trace_data_t *data) {
 
-	box3_t brush_bounds;
+	if (data->head_node < 0 || data->head_node >= cm_bsp.num_nodes) {
+		return;
+	}
 
-	if (data->is_transformed) {
-		brush_bounds = Mat4_TransformBounds(data->matrix, brush->bounds);
+	cm_transform_cache_t *cache = &cm_transform_cache;
+
+	if (cache->generation != cm_bsp.generation || !cache->brushes) {
+		Mem_Free(cache->brushes);
+
+		memset(cache, 0, sizeof(*cache));
+
+		cache->generation = cm_bsp.generation;
+		cache->brushes = Mem_TagMalloc(sizeof(cm_transformed_brush_t) * cm_bsp.num_brushes, MEM_TAG_COLLISION);
+		cache->planes = Mem_LinkMalloc(sizeof(cm_bsp_plane_t) * cm_bsp.num_brush_sides, cache->brushes);
+	}
+
+	cm_transform_t *transform = &cache->transforms[(data->head_node << 1) & (MAX_CM_TRANSFORMS - 1)];
+
+	if (transform->head_node != data->head_node || !Mat4_Equal(transform->matrix, data->matrix)) {
+		cm_transform_t *other = transform + 1;
+
+		if (other->stamp && other->head_node == data->head_node && Mat4_Equal(other->matrix, data->matrix)) {
+			transform = other;
+		} else {
+			if (other->stamp < transform->stamp) {
+				transform = other;
+			}
+
+			// should the stamps wrap, every cached brush must be invalidated
+			if (++cache->stamp == 0) {
+				for (int32_t i = 0; i < cm_bsp.num_brushes; i++) {
+					cache->brushes[i].stamp = 0;
+				}
+				memset(cache->transforms, 0, sizeof(cache->transforms));
+				cache->stamp = 1;
+			}
+
+			transform->head_node = data->head_node;
+			transform->matrix = data->matrix;
+			transform->stamp = cache->stamp;
+		}
+	}
+
+	data->stamp = transform->stamp;
+	data->brushes = cache->brushes;
+	data->planes = cache->planes;
+}
+
+/**
+ * @return The bounds of the brush, transformed by the trace's matrix. Cached brushes are
+ * transformed, along with their planes, only once per transform.
+ */
+static inline box3_t Cm_TraceBrushBounds(cm_trace_data_t *data, const cm_bsp_brush_t *brush) {
+
+	if (data->stamp) {
+		cm_transformed_brush_t *out = &data->brushes[brush - cm_bsp.brushes];
+
+		if (out->stamp != data->stamp) {
+			out->stamp = data->stamp;
+			out->bounds = Mat4_TransformBounds(data->matrix, brush->bounds);
+
+			const cm_bsp_brush_side_t *side = brush->brush_sides;
+			cm_bsp_plane_t *plane = data->planes + (side - cm_bsp.brush_sides);
+
+			for (int32_t i = 0; i < brush->num_brush_sides; i++, side++, plane++) {
+				*plane = Cm_TransformPlane(data->matrix, *side->plane);
+			}
+		}
+
+		return out->bounds;
+	} else if (data->is_transformed) {
+		return Mat4_TransformBounds(data->matrix, brush->bounds);
 	} else {
-		brush_bounds = brush->bounds;
+		return brush->bounds;
 	}
+}
 
-	return Box3_Intersects(data->abs_bounds, brush_bounds);
+/**
+ * @return The plane of the brush side, transformed by the trace's matrix.
+ * @remarks The side's brush must have been resolved by Cm_TraceBrushBounds.
+ */
+static inline cm_bsp_plane_t Cm_TracePlane(const cm_trace_data_t *data, const cm_bsp_brush_side_t *side) {
+
+	if (data->stamp) {
+		return data->planes[side - cm_bsp.brush_sides];
+	} else if (data->is_transformed) {
+		return Cm_TransformPlane(data->matrix, *side->plane);
+	} else {
+		return *side->plane;
+	}
+}
+
+/**
+ * @brief 
+ */
+static inline bool Cm_TraceIntersect(cm_trace_data_t *data, const cm_bsp_brush_t *brush) {
+	return Box3_Intersects(data->abs_bounds, Cm_TraceBrushBounds(data, brush));
 }
 
 /**
@@ -145,13 +384,7 @@ static void Cm_TraceToBrush(cm_trace_data_t *data, const cm_bsp_brush_t *brush)
 	const cm_bsp_brush_side_t *s = brush->brush_sides + brush->num_brush_sides - 1;
 	for (int32_t i = brush->num_brush_sides - 1; i >= 0; i--, s--) {
 
-		cm_bsp_plane_t p;
-
-		if (data->is_transformed) {
-			p = Cm_TransformPlane(data->matrix, *s->plane);
-		} else {
-			p = *s->plane;
-		}
+		const cm_bsp_plane_t p = Cm_TracePlane(data, s);
 
 		const float dist = p.dist - Vec3_Dot(data->offsets[p.sign_bits], p.normal);
 
@@ -235,13 +468,7 @@ static void Cm_TestBoxInBrush(cm_trace_data_t *data, const cm_bsp_brush_t *brush
 	const cm_bsp_brush_side_t *side = brush->brush_sides;
 	for (int32_t i = 0; i < brush->num_brush_sides; i++, side++) {
 
-		cm_bsp_plane_t plane;
-
-		if (data->is_transformed) {
-			plane = Cm_TransformPlane(data->matrix, *side->plane);
-		} else {
-			plane = *side->plane;
-		}
+		const cm_bsp_plane_t plane = Cm_TracePlane(data, side);
 
 		const float dist = plane.dist - Vec3_Dot(data->offsets[plane.sign_bits], plane.normal);
 
@@ -326,6 +553,26 @@ static void Cm_TestInLeaf(cm_trace_data_t *data, int32_t leaf_num) {
 	}
 }
 
+/**
+ * @brief Resolves the distances of the trace segment to the node plane, and the offset
+ * for the size of the box.
+ */
+static inline void Cm_TraceNodeDistances(const cm_trace_data_t *data, const cm_bsp_plane_t *plane,
+										 const vec3_t p1, const vec3_t p2, float *d1, float *d2, float *offset) {
+
+	if (AXIAL(plane)) {
+		*d1 = p1.xyz[plane->type] - plane->dist;
+		*d2 = p2.xyz[plane->type] - plane->dist;
+		*offset = data->size.xyz[plane->type];
+	} else {
+		*d1 = Vec3_Dot(plane->normal, p1) - plane->dist;
+		*d2 = Vec3_Dot(plane->normal, p2) - plane->dist;
+		*offset = (fabsf(data->size.x * plane->normal.x) +
+				   fabsf(data->size.y * plane->normal.y) +
+				   fabsf(data->size.z * plane->normal.z)) * 3.f;
+	}
+}
+
 /**
  * @brief
  */
@@ -336,20 +583,9 @@ next:;
 	// find the point distances to the separating plane
 	// and the offset for the size of the box
 	const cm_bsp_node_t *node = cm_bsp.nodes + num;
-	const cm_bsp_plane_t plane = *node->plane;
 
 	float d1, d2, offset;
-	if (AXIAL(&plane)) {
-		d1 = p1.xyz[plane.type] - plane.dist;
-		d2 = p2.xyz[plane.type] - plane.dist;
-		offset = data->size.xyz[plane.type];
-	} else {
-		d1 = Vec3_Dot(plane.normal, p1) - plane.dist;
-		d2 = Vec3_Dot(plane.normal, p2) - plane.dist;
-		offset = (fabsf(data->size.x * plane.normal.x) +
-				  fabsf(data->size.y * plane.normal.y) +
-				  fabsf(data->size.z * plane.normal.z)) * 3.f;
-	}
+	Cm_TraceNodeDistances(data, node->plane, p1, p2, &d1, &d2, &offset);
 
 	// see which sides we need to consider
 	if (d1 >= offset && d2 >= offset) {
@@ -432,6 +668,159 @@ next:;
 }
 
 
+/**
+ * @brief Clips a packet of untransformed traces to the tree. While every trace of the
+ * packet falls to the same side of a node, they descend together, visiting each node only
+ * once. Traces which straddle a node diverge there, and continue individually. Each trace
+ * therefore visits exactly the nodes and leafs that it would have visited alone.
+ */
+static void Cm_TraceToNodes(cm_trace_data_t **packet, size_t count, int32_t num) {
+
+	while (count) {
+
+		if (num < 0) {
+			for (size_t i = 0; i < count; i++) {
+				Cm_TraceToLeaf(packet[i], -1 - num);
+			}
+			return;
+		}
+
+		const cm_bsp_node_t *node = cm_bsp.nodes + num;
+
+		// partition the packet into front [0, front), straddling, and back [back, count)
+		size_t front = 0, back = count;
+
+		for (size_t i = 0; i < back;) {
+			cm_trace_data_t *data = packet[i];
+
+			float d1, d2, offset;
+			Cm_TraceNodeDistances(data, node->plane, data->start, data->end, &d1, &d2, &offset);
+
+			if (d1 >= offset && d2 >= offset) {
+				packet[i++] = packet[front];
+				packet[front++] = data;
+			} else if (d1 < -offset && d2 < -offset) {
+				packet[i] = packet[--back];
+				packet[back] = data;
+			} else {
+				i++;
+			}
+		}
+
+		for (size_t i = front; i < back; i++) {
+			Cm_TraceToNode(packet[i], num, 0.f, 1.f, packet[i]->start, packet[i]->end);
+		}
+
+		if (back < count) {
+			Cm_TraceToNodes(packet + back, count - back, node->children[1]);
+		}
+
+		count = front;
+		num = node->children[0];
+	}
+}
+
+/**
+ * @brief Prepares the trace for testing against brushes.
+ */
+static inline void Cm_PrepareTrace(cm_trace_data_t *data) {
+
+	Box3_ToPoints(data->bounds, data->offsets);
+
+	cm_brush_marks_t *marks = &cm_brush_marks;
+
+	if (marks->generation != cm_bsp.generation || !marks->brushes) {
+		Mem_Free(marks->brushes);
+
+		marks->generation = cm_bsp.generation;
+		marks->stamp = 0;
+		marks->brushes = Mem_TagMalloc(sizeof(uint32_t) * (cm_bsp.num_brushes + 1), MEM_TAG_COLLISION);
+	}
+
+	// should the stamps wrap, every mark must be cleared
+	if (++marks->stamp == 0) {
+		memset(marks->brushes, 0, sizeof(uint32_t) * (cm_bsp.num_brushes + 1));
+		marks->stamp = 1;
+	}
+
+	data->marks = marks->brushes;
+	data->mark = marks->stamp;
+}
+
+/**
+ * @brief Accumulates the trace's counters, for Cm_TraceStats.
+ */
+static inline void Cm_CountTrace(const cm_trace_data_t *data) {
+
+	cm_trace_counters_t *counters = cm_trace_counters;
+	if (counters == NULL) {
+
+		if (!(counters = calloc(1, sizeof(*counters)))) {
+			Com_Error(ERROR_FATAL, "Failed to allocate trace counters\n");
+		}
+
+		SDL_AtomicLock(&cm_trace_stats.lock);
+
+		counters->next = cm_trace_stats.counters;
+		cm_trace_stats.counters = counters;
+
+		SDL_AtomicUnlock(&cm_trace_stats.lock);
+
+		cm_trace_counters = counters;
+	}
+
+	atomic_store_explicit(&counters->traces,
+		atomic_load_explicit(&counters->traces, memory_order_relaxed) + 1, memory_order_relaxed);
+	atomic_store_explicit(&counters->brushes,
+		atomic_load_explicit(&counters->brushes, memory_order_relaxed) + data->num_brushes, memory_order_relaxed);
+	atomic_store_explicit(&counters->duplicate_brushes,
+		atomic_load_explicit(&counters->duplicate_brushes, memory_order_relaxed) + data->num_duplicate_brushes, memory_order_relaxed);
+}
+
+/**
+ * @brief Tests the box at the trace's start point, for traces which do not move.
+ */
+static void Cm_TestPosition(cm_trace_data_t *data) {
+	static __thread int32_t leafs[MAX_BSP_LEAFS];
+	box3_t abs_bounds = data->abs_bounds;
+
+	if (data->is_transformed) {
+		abs_bounds = Mat4_TransformBounds(data->inverse_matrix, abs_bounds);
+	}
+
+	const size_t num_leafs = Cm_BoxLeafnums(abs_bounds,
+											leafs,
+											lengthof(leafs),
+											NULL,
+											data->head_node);
+
+	for (size_t i = 0; i < num_leafs; i++) {
+		Cm_TestInLeaf(data, leafs[i]);
+
+		if (data->trace.all_solid) {
+			break;
+		}
+	}
+
+	data->trace.end = data->start;
+}
+
+/**
+ * @brief Resolves the end point of a trace which has been clipped to the tree.
+ */
+static inline void Cm_FinishTrace(cm_trace_data_t *data) {
+
+	data->trace.fraction = Maxf(0.f, data->trace.fraction);
+
+	if (data->trace.fraction == 0.f) {
+		data->trace.end = data->start;
+	} else if (data->trace.fraction == 1.f) {
+		data->trace.end = data->end;
+	} else {
+		data->trace.end = Vec3_Mix(data->start, data->end, data->trace.fraction);
+	}
+}
+
 /**
  * @brief Primary collision detection entry point. This function recurses down
  * the BSP tree from the specified head node, clipping the desired movement to
@@ -454,34 +843,12 @@ static inline cm_trace_t Cm_BoxTrace_(cm_trace_data_t *data) {
 		return data->trace;
 	}
 
-	Box3_ToPoints(data->bounds, data->offsets);
-
-	memset(data->brush_cache, 0xff, sizeof(data->brush_cache));
+	Cm_PrepareTrace(data);
 
 	// check for position test special case
 	if (Vec3_Equal(data->start, data->end)) {
-		static __thread int32_t leafs[MAX_BSP_LEAFS];
-		box3_t abs_bounds = data->abs_bounds;
-
-		if (data->is_transformed) {
-			abs_bounds = Mat4_TransformBounds(data->inverse_matrix, abs_bounds);
-		}
-
-		const size_t num_leafs = Cm_BoxLeafnums(abs_bounds,
-												leafs,
-												lengthof(leafs),
-												NULL,
-												data->head_node);
-
-		for (size_t i = 0; i < num_leafs; i++) {
-			Cm_TestInLeaf(data, leafs[i]);
-
-			if (data->trace.all_solid) {
-				break;
-			}
-		}
-
-		data->trace.end = data->start;
+		Cm_TestPosition(data);
+		Cm_CountTrace(data);
 		return data->trace;
 	}
 
@@ -493,15 +860,8 @@ static inline cm_trace_t Cm_BoxTrace_(cm_trace_data_t *data) {
 		Cm_TraceToNode(data, data->head_node, 0.f, 1.f, data->start, data->end);
 	}
 
-	data->trace.fraction = Maxf(0.f, data->trace.fraction);
-
-	if (data->trace.fraction == 0.f) {
-		data->trace.end = data->start;
-	} else if (data->trace.fraction == 1.f) {
-		data->trace.end = data->end;
-	} else {
-		data->trace.end = Vec3_Mix(data->start, data->end, data->trace.fraction);
-	}
+	Cm_FinishTrace(data);
+	Cm_CountTrace(data);
 
 	return data->trace;
 }
@@ -526,7 +886,7 @@ static inline cm_trace_t Cm_BoxTrace_(cm_trace_data_t *data) {
 cm_trace_t Cm_TransformedBoxTrace(const vec3_t start, const vec3_t end, const box3_t bounds, int32_t head_node,
 					              int32_t contents, const mat4_t matrix, const mat4_t inverse_matrix) {
 
-	return Cm_BoxTrace_(&(cm_trace_data_t) {
+	cm_trace_data_t data = {
 		.start = start,
 		.end = end,
 		.bounds = bounds,
@@ -540,7 +900,11 @@ cm_trace_t Cm_TransformedBoxTrace(const vec3_t start, const vec3_t end, const bo
 			.fraction = 1.f
 		},
 		.unnudged_fraction = 1.f + TRACE_EPSILON
-	});
+	};
+
+	Cm_TransformCache(&data);
+
+	return Cm_BoxTrace_(&data);
 }
 
 /**
@@ -575,6 +939,144 @@ cm_trace_t Cm_BoxTrace(const vec3_t start, const vec3_t end, const box3_t bounds
 	});
 }
 
+/**
+ * @brief Cm_BoxTraces context.
+ */
+typedef struct {
+	const cm_box_trace_t *traces;
+	cm_trace_t *results;
+	size_t count;
+	int32_t head_node;
+	int32_t contents;
+} cm_box_traces_t;
+
+/**
+ * @brief ThreadParallelFunc for Cm_BoxTraces, clipping one packet of traces.
+ */
+static void Cm_BoxTraces_(int32_t index, void *data) {
+
+	const cm_box_traces_t *batch = data;
+
+	const size_t first = (size_t) index * CM_TRACE_PACKET;
+	const size_t count = MIN(batch->count - first, CM_TRACE_PACKET);
+
+	cm_trace_data_t traces[CM_TRACE_PACKET];
+	cm_trace_data_t *packet[CM_TRACE_PACKET];
+	size_t num_packet = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		const cm_box_trace_t *in = &batch->traces[first + i];
+
+		cm_trace_data_t *trace = &traces[i];
+
+		*trace = (cm_trace_data_t) {
+			.start = in->start,
+			.end = in->end,
+			.bounds = in->bounds,
+			.head_node = batch->head_node,
+			.abs_bounds = Cm_TraceBounds(in->start, in->end, in->bounds),
+			.contents = batch->contents,
+			.size = Box3_Symetrical(Box3_Expand(in->bounds, BOX_EPSILON)),
+			.trace = (cm_trace_t) {
+				.fraction = 1.f
+			},
+			.unnudged_fraction = 1.f + TRACE_EPSILON
+		};
+
+		Cm_PrepareTrace(trace);
+
+		if (Vec3_Equal(trace->start, trace->end)) {
+			Cm_TestPosition(trace);
+		} else {
+			packet[num_packet++] = trace;
+		}
+	}
+
+	Cm_TraceToNodes(packet, num_packet, batch->head_node);
+
+	for (size_t i = 0; i < num_packet; i++) {
+		Cm_FinishTrace(packet[i]);
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		Cm_CountTrace(&traces[i]);
+		batch->results[first + i] = traces[i].trace;
+	}
+}
+
+/**
+ * @brief Clips a batch of traces to the tree, with results identical to calling
+ * Cm_BoxTrace for each. Consecutive traces are clipped in packets which share their
+ * traversal of the tree for as long as they remain coherent, so callers should order
+ * traces that are near to one another together. Large batches are distributed across
+ * the thread pool.
+ *
+ * @param traces The traces.
+ * @param results The resulting traces, one per input trace.
+ * @param count The number of traces.
+ * @param head_node The BSP head node to recurse down.
+ * @param contents The contents mask to clip to.
+ */
+void Cm_BoxTraces(const cm_box_trace_t *traces, cm_trace_t *results, size_t count, int32_t head_node,
+				  int32_t contents) {
+
+	if (!cm_bsp.num_nodes) { // map not loaded
+		for (size_t i = 0; i < count; i++) {
+			results[i] = (cm_trace_t) {
+				.fraction = 1.f
+			};
+		}
+		return;
+	}
+
+	cm_box_traces_t batch = {
+		.traces = traces,
+		.results = results,
+		.count = count,
+		.head_node = head_node,
+		.contents = contents
+	};
+
+	const int32_t num_packets = (int32_t) ((count + CM_TRACE_PACKET - 1) / CM_TRACE_PACKET);
+
+	if (num_packets > 1) {
+		Thread_ParallelFor(num_packets, 1, Cm_BoxTraces_, &batch);
+	} else if (num_packets == 1) {
+		Cm_BoxTraces_(0, &batch);
+	}
+}
+
+/**
+ * @return The trace counters accumulated since they were last reset.
+ * @param reset True to reset the counters.
+ */
+cm_trace_stats_t Cm_TraceStats(bool reset) {
+
+	cm_trace_stats_t stats = { 0 };
+
+	SDL_AtomicLock(&cm_trace_stats.lock);
+
+	for (const cm_trace_counters_t *c = cm_trace_stats.counters; c; c = c->next) {
+		stats.traces += atomic_load_explicit(&c->traces, memory_order_relaxed);
+		stats.brushes += atomic_load_explicit(&c->brushes, memory_order_relaxed);
+		stats.duplicate_brushes += atomic_load_explicit(&c->duplicate_brushes, memory_order_relaxed);
+	}
+
+	const cm_trace_stats_t since = {
+		.traces = stats.traces - cm_trace_stats.reset.traces,
+		.brushes = stats.brushes - cm_trace_stats.reset.brushes,
+		.duplicate_brushes = stats.duplicate_brushes - cm_trace_stats.reset.duplicate_brushes
+	};
+
+	if (reset) {
+		cm_trace_stats.reset = stats;
+	}
+
+	SDL_AtomicUnlock(&cm_trace_stats.lock);
+
+	return since;
+}
+
 /**
  * @brief Calculates a suitable bounding box for tracing to an entity.
  * @param solid The entity's solid type.
@@ -30,6 +30,11 @@ __attribute__ ((warn_unused_result))
 cm_trace_t Cm_TransformedBoxTrace(const vec3_t start, const vec3_t end, const box3_t bounds, int32_t head_node,
 					              int32_t contents, const mat4_t matrix, const mat4_t inverse_matrix);
 
+void Cm_BoxTraces(const cm_box_trace_t *traces, cm_trace_t *results, size_t count, int32_t head_node,
+				  int32_t contents);
+
+cm_trace_stats_t Cm_TraceStats(bool reset);
+
 __attribute__ ((warn_unused_result))
 box3_t Cm_EntityBounds(const solid_t solid, const mat4_t matrix, const box3_t bounds);
 
@@ -352,6 +352,11 @@ typedef struct {
 	int64_t size;
 	int64_t mod_time;
 
+	/**
+	 * @brief Incremented each time a BSP is loaded, so that derived data may be invalidated.
+	 */
+	uint32_t generation;
+
 	int32_t num_planes;
 	cm_bsp_plane_t *planes;
 
@@ -361,6 +366,17 @@ typedef struct {
 	int32_t num_leafs;
 	cm_bsp_leaf_t *leafs;
 
+	/**
+	 * @brief The number of visibility clusters, derived from the leafs.
+	 */
+	int32_t num_clusters;
+
+	/**
+	 * @brief The compressed cluster visibility, or NULL if the BSP was compiled without it.
+	 */
+	int32_t vis_size;
+	struct bsp_vis_s *vis;
+
 	int32_t num_brushes;
 	cm_bsp_brush_t *brushes;
 
@@ -449,3 +465,39 @@ typedef struct {
 	struct g_entity_s *ent;
 } cm_trace_t;
 
+/**
+ * @brief A single trace of a batch, as submitted to Cm_BoxTraces.
+ */
+typedef struct {
+	/**
+	 * @brief The trace start and end points.
+	 */
+	vec3_t start, end;
+
+	/**
+	 * @brief The bounding box, in model space.
+	 */
+	box3_t bounds;
+} cm_box_trace_t;
+
+/**
+ * @brief Trace counters, as returned by Cm_TraceStats.
+ */
+typedef struct {
+	/**
+	 * @brief The number of traces clipped to the tree.
+	 */
+	int64_t traces;
+
+	/**
+	 * @brief The number of brushes tested.
+	 */
+	int64_t brushes;
+
+	/**
+	 * @brief The number of tests avoided because the brush, referenced by more than one
+	 * leaf, had already been tested by the same trace.
+	 */
+	int64_t duplicate_brushes;
+} cm_trace_stats_t;
+
@@ -20,6 +20,7 @@
  */
 
 #include <signal.h>
+#include <stdatomic.h>
 #include <SDL_thread.h>
 
 #include "mem.h"
@@ -41,12 +42,67 @@
 #define MEM_MAGIC 0x69696969
 typedef uint32_t mem_magic_t;
 
+#define MEM_BLOCK_MAGIC 0x6969
+
+/**
+ * @brief Root blocks are kept in lists sharded by allocating thread, so that threads
+ * rarely contend for the same lock.
+ */
+#define MEM_SHARDS 16
+
+/**
+ * @brief Each shard keeps its root blocks in lists bucketed by tag, so that freeing a
+ * tag visits only the blocks which may bear it.
+ */
+#define MEM_TAG_BUCKETS 64
+
+/**
+ * @brief Blocks, including their header and footer, of up to this size are allocated
+ * from size-class pools.
+ */
+#define MEM_POOL_MAX 4096
+#define MEM_POOL_NONE -1
+#define MEM_POOL_ARENA -2
+
+/**
+ * @brief The size of the slabs which pooled blocks are carved from.
+ */
+#define MEM_POOL_SLAB 0x10000
+
+/**
+ * @brief The number of free blocks moved between a thread's cache and the shared pool.
+ */
+#define MEM_POOL_BATCH 64
+
+/**
+ * @brief The size of arena chunks, and the largest block allocated from them.
+ */
+#define MEM_ARENA_CHUNK 0x100000
+#define MEM_ARENA_MAX (MEM_ARENA_CHUNK / 16)
+
+/**
+ * @brief The number of distinct tags which may be accounted for. Must be a power of two.
+ */
+#define MEM_TAGS 256
+
+/**
+ * @brief The header of every managed allocation, which is 32 bytes, so that the memory
+ * following it remains 16 byte aligned. Root blocks are doubly linked into their shard's
+ * lists, and each block is immediately followed by its descendants, in pre-order. A block
+ * and its descendants may therefore be unlinked without visiting any other block, and
+ * no link to the parent or to the children is needed. Lean builds omit the magic and the
+ * footer, but keep the links, so that freeing a tag or a parent costs the same in both.
+ */
 typedef struct mem_block_s {
-	mem_magic_t magic;
-	mem_tag_t tag; // for group free
-	struct mem_block_s *parent;
-	GSList *children;
+	_Alignas(16) int16_t tag; // for group free
+	int8_t pool; // the size class, MEM_POOL_NONE, or MEM_POOL_ARENA
+	uint8_t shard; // the shard guarding this block's list
+	uint16_t depth; // the number of ancestors
+#if !defined(LEAN_MEMORY)
+	uint16_t magic;
+#endif
 	size_t size;
+	struct mem_block_s *prev, *next; // root blocks and their descendants, in pre-order
 #if defined(SUPER_MEMORY_CHECKS)
 	void *stack[MAX_MEMORY_STACK];
 #endif
@@ -56,14 +112,97 @@ typedef struct {
 	mem_magic_t magic;
 } mem_footer_t;
 
+/**
+ * @brief A shard of root blocks, bucketed by tag.
+ */
+typedef struct {
+	SDL_SpinLock lock;
+	mem_block_t *blocks[MEM_TAG_BUCKETS];
+} mem_shard_t;
+
+/**
+ * @brief A size class, holding the free blocks returned by thread caches.
+ */
 typedef struct {
-	GHashTable *blocks;
+	SDL_SpinLock lock;
 	size_t size;
+	mem_block_t *blocks;
+	GSList *slabs;
+} mem_pool_t;
+
+/**
+ * @brief A bump allocator for a single tag. Its chunks are released wholesale once all
+ * of its blocks have been freed, typically by Mem_FreeTag.
+ */
+typedef struct {
 	SDL_SpinLock lock;
+	mem_tag_t tag;
+	byte *chunk;
+	size_t offset;
+	size_t count;
+	GSList *chunks;
+} mem_arena_t;
+
+/**
+ * @brief Per-tag accounting. Each counter is written only by its owning thread, and
+ * frees are accounted to the thread performing them, so a single thread's counters may
+ * wrap. Only their sum across all threads is meaningful.
+ */
+typedef struct {
+	atomic_size_t size;
+	atomic_size_t count;
+	atomic_size_t allocs;
+} mem_counter_t;
+
+/**
+ * @brief A thread's accounting, indexed by Mem_TagIndex, and its total size across all
+ * tags. These outlive their thread, so that its allocations remain accounted for.
+ */
+typedef struct mem_counters_s {
+	mem_counter_t tags[MEM_TAGS];
+	atomic_size_t size;
+	struct mem_counters_s *next;
+} mem_counters_t;
+
+/**
+ * @brief Each thread caches free pooled blocks, so that most allocations and frees need
+ * not take any lock.
+ */
+typedef struct {
+	uint32_t generation;
+	uint8_t shard;
+	mem_counters_t *counters;
+	mem_block_t *blocks[MEM_POOL_MAX / 64 * 2];
+	int32_t num_blocks[MEM_POOL_MAX / 64 * 2];
+} mem_cache_t;
+
+typedef struct {
+	uint32_t generation;
+	atomic_uint next_shard;
+
+	atomic_int tags[MEM_TAGS]; // tag + 1, or 0 if unused
+
+	SDL_SpinLock counters_lock;
+	mem_counters_t *counters;
+
+	SDL_SpinLock stats_lock;
+	size_t stats_allocs[MEM_TAGS];
+	size_t stats_peak; // the largest total size sampled by Mem_Stats
+	gint64 stats_time;
+
+	mem_shard_t shards[MEM_SHARDS];
+
+	mem_pool_t pools[MEM_POOL_MAX / 64 * 2];
+	int32_t num_pools;
+	int8_t pool_for_size[MEM_POOL_MAX / 16 + 1];
+
+	mem_arena_t *arenas[MEM_TAG_BUCKETS];
 } mem_state_t;
 
 static mem_state_t mem_state;
 
+static _Thread_local mem_cache_t mem_cache;
+
 #if defined(SUPER_MEMORY_CHECKS)
 /**
  * @brief
@@ -97,7 +236,7 @@ static void Mem_Print(const mem_block_t *block, const char *why) {
 
 /**
  * @brief Throws a fatal error if the specified memory block is non-NULL but
- * not owned by the memory subsystem.
+ * not owned by the memory subsystem. Lean builds do not check.
  */
 static mem_block_t *Mem_CheckMagic(void *p) {
 	mem_block_t *b = NULL;
@@ -105,7 +244,8 @@ static mem_block_t *Mem_CheckMagic(void *p) {
 	if (p) {
 		b = ((mem_block_t *) p) - 1;
 
-		if (b->magic != MEM_MAGIC) {
+#if !defined(LEAN_MEMORY)
+		if (b->magic != MEM_BLOCK_MAGIC) {
 			fprintf(stderr, "Invalid magic (%d) for %p\n", b->magic, p);
 			raise(SIGABRT);
 		}
@@ -116,6 +256,7 @@ static mem_block_t *Mem_CheckMagic(void *p) {
 			fprintf(stderr, "Invalid footer magic (%d) for %p\n", b->magic, p);
 			raise(SIGABRT);
 		}
+#endif
 	}
 
 	return b;
@@ -129,23 +270,402 @@ void Mem_Check(void *p) {
 }
 
 /**
- * @brief Recursively frees linked managed memory.
+ * @return The calling thread's pool cache, discarding it if the memory subsystem has
+ * been reinitialized since it was last used. Allocations made before Mem_Init, or after
+ * Mem_Shutdown, are accounted too.
+ */
+static mem_cache_t *Mem_Cache(void) {
+
+	mem_cache_t *cache = &mem_cache;
+
+	if (cache->generation != mem_state.generation || !cache->counters) {
+		memset(cache, 0, sizeof(*cache));
+
+		cache->generation = mem_state.generation;
+		cache->shard = atomic_fetch_add(&mem_state.next_shard, 1) % MEM_SHARDS;
+
+		if (!(cache->counters = calloc(1, sizeof(mem_counters_t)))) {
+			fprintf(stderr, "Failed to allocate %u bytes\n", (uint32_t) sizeof(mem_counters_t));
+			raise(SIGABRT);
+		}
+
+		SDL_AtomicLock(&mem_state.counters_lock);
+
+		cache->counters->next = mem_state.counters;
+		mem_state.counters = cache->counters;
+
+		SDL_AtomicUnlock(&mem_state.counters_lock);
+	}
+
+	return cache;
+}
+
+/**
+ * @return The accounting index of the specified tag, claiming one if necessary.
+ * @remarks Should more than MEM_TAGS distinct tags be used, the excess share an index.
  */
-static void Mem_Free_(mem_block_t *b) {
+static int32_t Mem_TagIndex(mem_tag_t tag) {
+
+	const int32_t key = tag + 1;
+
+	for (int32_t i = 0; i < MEM_TAGS; i++) {
+		const int32_t index = (tag + i) & (MEM_TAGS - 1);
+
+		int32_t slot = atomic_load_explicit(&mem_state.tags[index], memory_order_acquire);
+		if (slot == 0) {
+			atomic_compare_exchange_strong(&mem_state.tags[index], &slot, key);
+			if (slot == 0) {
+				return index;
+			}
+		}
+
+		if (slot == key) {
+			return index;
+		}
+	}
+
+	return tag & (MEM_TAGS - 1);
+}
+
+/**
+ * @brief Adds to a counter owned by the calling thread. No read-modify-write is needed,
+ * as other threads only ever read it.
+ */
+static inline void Mem_Count(atomic_size_t *counter, size_t value) {
+	atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+/**
+ * @brief Accounts for a change in the size and number of blocks of the specified tag,
+ * in the calling thread's counters.
+ */
+static void Mem_Account(mem_cache_t *cache, mem_tag_t tag, ptrdiff_t size, int32_t count) {
+
+	mem_counter_t *counter = &cache->counters->tags[Mem_TagIndex(tag)];
+
+	Mem_Count(&counter->size, (size_t) size);
+	Mem_Count(&counter->count, (size_t) (ptrdiff_t) count);
+
+	Mem_Count(&cache->counters->size, (size_t) size);
+
+	if (count > 0) {
+		Mem_Count(&counter->allocs, (size_t) count);
+	}
+}
+
+/**
+ * @brief Moves a batch of free blocks from the shared pool, or from a new slab, into the
+ * calling thread's cache.
+ */
+static void Mem_FillCache(mem_cache_t *cache, int32_t pool) {
+
+	mem_pool_t *p = &mem_state.pools[pool];
+
+	SDL_AtomicLock(&p->lock);
+
+	if (p->blocks) {
+		for (int32_t i = 0; i < MEM_POOL_BATCH && p->blocks; i++) {
+			mem_block_t *b = p->blocks;
+			p->blocks = b->next;
+
+			b->next = cache->blocks[pool];
+			cache->blocks[pool] = b;
+			cache->num_blocks[pool]++;
+		}
+	} else {
+		byte *slab = malloc(MEM_POOL_SLAB);
+		if (!slab) {
+			fprintf(stderr, "Failed to allocate %u bytes\n", (uint32_t) MEM_POOL_SLAB);
+			raise(SIGABRT);
+		}
+
+		p->slabs = g_slist_prepend(p->slabs, slab);
+
+		for (size_t offset = 0; offset + p->size <= MEM_POOL_SLAB; offset += p->size) {
+			mem_block_t *b = (mem_block_t *) (slab + offset);
+
+			b->next = cache->blocks[pool];
+			cache->blocks[pool] = b;
+			cache->num_blocks[pool]++;
+		}
+	}
+
+	SDL_AtomicUnlock(&p->lock);
+}
+
+/**
+ * @brief Returns a batch of the calling thread's free blocks to the shared pool.
+ */
+static void Mem_DrainCache(mem_cache_t *cache, int32_t pool) {
+
+	mem_pool_t *p = &mem_state.pools[pool];
+
+	SDL_AtomicLock(&p->lock);
+
+	for (int32_t i = 0; i < MEM_POOL_BATCH; i++) {
+		mem_block_t *b = cache->blocks[pool];
+		cache->blocks[pool] = b->next;
+		cache->num_blocks[pool]--;
+
+		b->next = p->blocks;
+		p->blocks = b;
+	}
+
+	SDL_AtomicUnlock(&p->lock);
+}
+
+/**
+ * @return The arena for the specified tag, or NULL.
+ */
+static mem_arena_t *Mem_Arena(mem_tag_t tag) {
+
+	mem_arena_t *arena = mem_state.arenas[tag & (MEM_TAG_BUCKETS - 1)];
+	if (arena && arena->tag == tag) {
+		return arena;
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Bump allocates a block of the specified total size from the arena.
+ */
+static mem_block_t *Mem_ArenaMalloc(mem_arena_t *arena, size_t s) {
+
+	s = (s + 15) & ~15;
+
+	SDL_AtomicLock(&arena->lock);
+
+	if (!arena->chunk || arena->offset + s > MEM_ARENA_CHUNK) {
+		if (!(arena->chunk = malloc(MEM_ARENA_CHUNK))) {
+			fprintf(stderr, "Failed to allocate %u bytes\n", (uint32_t) MEM_ARENA_CHUNK);
+			raise(SIGABRT);
+		}
+
+		arena->chunks = g_slist_prepend(arena->chunks, arena->chunk);
+		arena->offset = 0;
+	}
+
+	mem_block_t *b = (mem_block_t *) (arena->chunk + arena->offset);
+
+	arena->offset += s;
+	arena->count++;
+
+	SDL_AtomicUnlock(&arena->lock);
+
+	return b;
+}
+
+/**
+ * @brief Releases a block to its arena. Once the arena holds no blocks, its chunks are
+ * freed wholesale.
+ */
+static void Mem_ArenaFree(mem_arena_t *arena) {
+
+	SDL_AtomicLock(&arena->lock);
+
+	if (--arena->count == 0) {
+		g_slist_free_full(arena->chunks, free);
+
+		arena->chunks = NULL;
+		arena->chunk = NULL;
+		arena->offset = 0;
+	}
+
+	SDL_AtomicUnlock(&arena->lock);
+}
+
+/**
+ * @brief Allocates a zeroed block of the specified total size, from the tag's arena, a
+ * size-class pool, or the system allocator. The pools are unavailable until Mem_Init.
+ */
+static mem_block_t *Mem_AllocBlock(size_t s, mem_tag_t tag) {
+
+	mem_block_t *b;
+
+	mem_arena_t *arena = Mem_Arena(tag);
+	if (arena && s <= MEM_ARENA_MAX) {
+		b = Mem_ArenaMalloc(arena, s);
+		memset(b, 0, s);
+
+		b->pool = MEM_POOL_ARENA;
+	} else if (s <= MEM_POOL_MAX && mem_state.num_pools) {
+		const int32_t pool = mem_state.pool_for_size[(s + 15) / 16];
+
+		mem_cache_t *cache = Mem_Cache();
+		if (!cache->blocks[pool]) {
+			Mem_FillCache(cache, pool);
+		}
+
+		b = cache->blocks[pool];
+		cache->blocks[pool] = b->next;
+		cache->num_blocks[pool]--;
+
+		memset(b, 0, s);
+
+		b->pool = (int8_t) pool;
+	} else {
+		if (!(b = calloc(1, s))) {
+			fprintf(stderr, "Failed to allocate %u bytes\n", (uint32_t) s);
+			raise(SIGABRT);
+			return NULL;
+		}
+
+		b->pool = MEM_POOL_NONE;
+	}
+
+	return b;
+}
+
+/**
+ * @brief Returns the memory of a block to wherever it was allocated from.
+ */
+static void Mem_FreeBlock(mem_block_t *b) {
+
+#if !defined(LEAN_MEMORY)
+	b->magic = 0;
+#endif
+
+	if (b->pool == MEM_POOL_ARENA) {
+		Mem_ArenaFree(Mem_Arena(b->tag));
+	} else if (b->pool != MEM_POOL_NONE) {
+		const int32_t pool = b->pool;
+
+		mem_cache_t *cache = Mem_Cache();
+
+		b->next = cache->blocks[pool];
+		cache->blocks[pool] = b;
+
+		if (++cache->num_blocks[pool] >= MEM_POOL_BATCH * 2) {
+			Mem_DrainCache(cache, pool);
+		}
+	} else {
+		free(b);
+	}
+}
+
+/**
+ * @brief Returns the total size of a memory block.
+ */
+static size_t Mem_BlockSize(const size_t size) {
+#if defined(LEAN_MEMORY)
+	return sizeof(mem_block_t) + size;
+#else
+	return sizeof(mem_block_t) + size + sizeof(mem_footer_t);
+#endif
+}
+
+/**
+ * @return The lock guarding the list that the specified block, and its descendants, are
+ * linked into.
+ */
+static SDL_SpinLock *Mem_ListLock(const mem_block_t *b) {
+	return &mem_state.shards[b->shard].lock;
+}
+
+/**
+ * @return The head of the list that the specified root block is linked into.
+ */
+static mem_block_t **Mem_ListHead(const mem_block_t *b) {
+	return &mem_state.shards[b->shard].blocks[b->tag & (MEM_TAG_BUCKETS - 1)];
+}
+
+/**
+ * @return The last of the block's descendants, or the block itself if it has none. The
+ * list's lock must be held.
+ */
+static mem_block_t *Mem_LastDescendant(mem_block_t *b) {
+
+	mem_block_t *last = b;
+
+	while (last->next && last->next->depth > b->depth) {
+		last = last->next;
+	}
+
+	return last;
+}
+
+/**
+ * @brief Links the block, and the descendants which follow it through `last`, after
+ * `prev`, or at the head of the block's list. The list's lock must be held.
+ */
+static void Mem_InsertBlocks(mem_block_t *b, mem_block_t *last, mem_block_t *prev) {
+
+	mem_block_t **head = prev ? &prev->next : Mem_ListHead(b);
+
+	b->prev = prev;
+	last->next = *head;
+
+	if (*head) {
+		(*head)->prev = last;
+	}
+
+	*head = b;
+}
+
+/**
+ * @brief Unlinks the block, and the descendants which follow it through `last`, from
+ * their list. The list's lock must be held.
+ */
+static void Mem_RemoveBlocks(mem_block_t *b, mem_block_t *last) {
+
+	if (b->prev) {
+		b->prev->next = last->next;
+	} else {
+		*Mem_ListHead(b) = last->next;
+	}
+
+	if (last->next) {
+		last->next->prev = b->prev;
+	}
+
+	b->prev = last->next = NULL;
+}
+
+/**
+ * @brief Re-seats a block which has moved in its list. Its descendants needn't know. The
+ * list's lock must be held.
+ */
+static void Mem_ReseatBlock(const mem_block_t *b, mem_block_t *new_b) {
+
+	if (new_b->prev) {
+		new_b->prev->next = new_b;
+	} else {
+		*Mem_ListHead(new_b) = new_b;
+	}
+
+	if (new_b->next) {
+		new_b->next->prev = new_b;
+	}
+}
+
+/**
+ * @brief Frees the specified block, which must already be unlinked.
+ */
+static void Mem_Free_(mem_cache_t *cache, mem_block_t *b) {
 
 #if defined(SUPER_MEMORY_CHECKS)
 	Mem_Print(b, "Freeing");
 #endif
 
-	// recurse down the tree, freeing children
-	if (b->children) {
-		g_slist_free_full(b->children, (GDestroyNotify) Mem_Free_);
-	}
+	Mem_Account(cache, b->tag, -(ptrdiff_t) b->size, -1);
+
+	Mem_FreeBlock(b);
+}
+
+/**
+ * @brief Frees the specified blocks, which must already be unlinked, following their
+ * next links.
+ */
+static void Mem_FreeBlocks(mem_block_t *b) {
 
-	// decrement the pool size and free the memory
-	mem_state.size -= b->size;
+	mem_cache_t *cache = Mem_Cache();
 
-	free(b);
+	while (b) {
+		mem_block_t *next = b->next;
+		Mem_Free_(cache, b);
+		b = next;
+	}
 }
 
 /**
@@ -156,17 +676,13 @@ void Mem_Free(void *p) {
 	if (p) {
 		mem_block_t *b = Mem_CheckMagic(p);
 
-		SDL_AtomicLock(&mem_state.lock);
-
-		if (b->parent) {
-			b->parent->children = g_slist_remove(b->parent->children, b);
-		} else {
-			g_hash_table_remove(mem_state.blocks, (gconstpointer) b);
-		}
+		SDL_SpinLock *lock = Mem_ListLock(b);
 
-		Mem_Free_(b);
+		SDL_AtomicLock(lock);
+		Mem_RemoveBlocks(b, Mem_LastDescendant(b));
+		SDL_AtomicUnlock(lock);
 
-		SDL_AtomicUnlock(&mem_state.lock);
+		Mem_FreeBlocks(b);
 	}
 }
 
@@ -174,30 +690,57 @@ void Mem_Free(void *p) {
  * @brief Free all managed items allocated with the specified tag.
  */
 void Mem_FreeTag(mem_tag_t tag) {
-	GHashTableIter it;
-	gpointer key, value;
 
-	SDL_AtomicLock(&mem_state.lock);
+	for (int32_t i = 0; i < MEM_SHARDS; i++) {
+		mem_shard_t *shard = &mem_state.shards[i];
+
+		mem_block_t *blocks = NULL;
+
+		SDL_AtomicLock(&shard->lock);
 
-	g_hash_table_iter_init(&it, mem_state.blocks);
+		for (int32_t j = 0; j < MEM_TAG_BUCKETS; j++) {
 
-	while (g_hash_table_iter_next(&it, &key, &value)) {
-		mem_block_t *b = (mem_block_t *) key;
+			if (tag != MEM_TAG_ALL && j != (tag & (MEM_TAG_BUCKETS - 1))) {
+				continue;
+			}
+
+			// visit only the root blocks, skipping over their descendants
+			mem_block_t *b = shard->blocks[j];
+			while (b) {
+				mem_block_t *last = Mem_LastDescendant(b);
+				mem_block_t *next = last->next;
+
+				if (tag == MEM_TAG_ALL || b->tag == tag) {
+					Mem_RemoveBlocks(b, last);
 
-		if (tag == MEM_TAG_ALL || b->tag == tag) {
-			g_hash_table_iter_remove(&it);
-			Mem_Free_(b);
+					last->next = blocks;
+					blocks = b;
+				}
+
+				b = next;
+			}
 		}
-	}
 
-	SDL_AtomicUnlock(&mem_state.lock);
+		SDL_AtomicUnlock(&shard->lock);
+
+		// free the blocks outside of the lock
+		Mem_FreeBlocks(blocks);
+	}
 }
 
 /**
- * @brief Returns the total size of a memory block.
+ * @brief Writes the footer of the specified block.
  */
-static size_t Mem_BlockSize(const size_t size) {
-	return sizeof(mem_block_t) + size + sizeof(mem_footer_t);
+static void *Mem_SetFooter(mem_block_t *b) {
+
+	void *data = (void *) (b + 1);
+
+#if !defined(LEAN_MEMORY)
+	mem_footer_t *footer = (mem_footer_t *) (((byte *) data) + b->size);
+	footer->magic = (mem_magic_t) (MEM_MAGIC + b->size);
+#endif
+
+	return data;
 }
 
 /**
@@ -212,43 +755,44 @@ static size_t Mem_BlockSize(const size_t size) {
  * @return A block of managed memory initialized to 0x0.
  */
 static void *Mem_Malloc_(size_t size, mem_tag_t tag, void *parent) {
-	mem_block_t *b, *p = Mem_CheckMagic(parent);
+	mem_block_t *p = Mem_CheckMagic(parent);
 
-	// allocate the block plus the desired size
-	const size_t s = Mem_BlockSize(size);
+	mem_cache_t *cache = Mem_Cache();
 
-	if (!(b = calloc(1, s))) {
-		fprintf(stderr, "Failed to allocate %u bytes\n", (uint32_t) s);
-		raise(SIGABRT);
+	// allocate the block plus the desired size
+	mem_block_t *b = Mem_AllocBlock(Mem_BlockSize(size), tag);
+	if (!b) {
 		return NULL;
 	}
 
-	b->magic = MEM_MAGIC;
-	b->tag = tag;
-	b->parent = p;
+#if !defined(LEAN_MEMORY)
+	b->magic = MEM_BLOCK_MAGIC;
+#endif
+	b->tag = (int16_t) tag;
 	b->size = size;
 
-	void *data = (void *) (b + 1);
-
-	mem_footer_t *footer = (mem_footer_t *) (((byte *) data) + size);
-	footer->magic = (mem_magic_t) (MEM_MAGIC + b->size);
-
-	// insert it into the managed memory structures
-	SDL_AtomicLock(&mem_state.lock);
-
-	if (b->parent) {
-		b->parent->children = g_slist_prepend(b->parent->children, b);
+	// children share their parent's list, and immediately follow it
+	if (p) {
+		b->shard = p->shard;
+		b->depth = p->depth + 1;
 	} else {
-		g_hash_table_add(mem_state.blocks, b);
+		b->shard = cache->shard;
 	}
 
-	mem_state.size += size;
-	
+	void *data = Mem_SetFooter(b);
+
 #if defined(SUPER_MEMORY_CHECKS)
 	Mem_SetStack(b);
 #endif
 
-	SDL_AtomicUnlock(&mem_state.lock);
+	// insert it into the managed memory structures
+	SDL_SpinLock *lock = Mem_ListLock(b);
+
+	SDL_AtomicLock(lock);
+	Mem_InsertBlocks(b, b, p);
+	SDL_AtomicUnlock(lock);
+
+	Mem_Account(cache, tag, (ptrdiff_t) size, 1);
 
 	// return the address in front of the block
 	return data;
@@ -314,45 +858,46 @@ void *Mem_Realloc(void *p, size_t size) {
 	const size_t old_size = b->size;
 	const size_t s = Mem_BlockSize(size);
 
-	b->size = size;
-
 #if defined(SUPER_MEMORY_PRINTS)
 	Mem_Print(b, "Reallocating");
 #endif
 
-	if (!(new_b = realloc(b, s))) {
-		fprintf(stderr, "Failed to re-allocate %u bytes\n", (uint32_t) s);
-		raise(SIGABRT);
-		return NULL;
-	}
-
-	void *data = (void *) (new_b + 1);
+	SDL_SpinLock *lock = Mem_ListLock(b);
 
-	mem_footer_t *footer = (mem_footer_t *) (((byte *) data) + size);
-	footer->magic = (mem_magic_t) (MEM_MAGIC + new_b->size);
+	SDL_AtomicLock(lock);
 
-	SDL_AtomicLock(&mem_state.lock);
+	mem_block_t *old_b = NULL;
 
-	// re-seat us in our parent or in global hash list
-	if (new_b->parent) {
-		new_b->parent->children = g_slist_remove(new_b->parent->children, b);
-		new_b->parent->children = g_slist_prepend(new_b->parent->children, new_b);
+	if (b->pool >= 0 && s <= MEM_POOL_MAX && mem_state.pool_for_size[(s + 15) / 16] == b->pool) {
+		new_b = b;
+	} else if (b->pool == MEM_POOL_NONE && s > MEM_POOL_MAX) {
+		if (!(new_b = realloc(b, s))) {
+			fprintf(stderr, "Failed to re-allocate %u bytes\n", (uint32_t) s);
+			raise(SIGABRT);
+			return NULL;
+		}
 	} else {
-		g_hash_table_remove(mem_state.blocks, b);
-		g_hash_table_add(mem_state.blocks, new_b);
+		if (!(new_b = Mem_AllocBlock(s, b->tag))) {
+			return NULL;
+		}
+
+		const int8_t pool = new_b->pool;
+
+		memcpy(new_b, b, sizeof(mem_block_t) + MIN(old_size, size));
+
+		new_b->pool = pool;
+
+		old_b = b;
 	}
 
-	// change our childrens' parent pointers
-	if (new_b->children) {
-		for (GSList *children = new_b->children; children; children = children->next) {
-			mem_block_t *child = (mem_block_t *) children->data;
-			child->parent = new_b;
-		}
+	new_b->size = size;
+
+	void *data = Mem_SetFooter(new_b);
+
+	if (new_b != b) {
+		Mem_ReseatBlock(b, new_b);
 	}
 
-	mem_state.size -= old_size;
-	mem_state.size += size;
-	
 #if defined(SUPER_MEMORY_CHECKS)
 	Mem_SetStack(new_b);
 
@@ -361,7 +906,13 @@ void *Mem_Realloc(void *p, size_t size) {
 #endif
 #endif
 
-	SDL_AtomicUnlock(&mem_state.lock);
+	SDL_AtomicUnlock(lock);
+
+	if (old_b) {
+		Mem_FreeBlock(old_b);
+	}
+
+	Mem_Account(Mem_Cache(), new_b->tag, (ptrdiff_t) size - (ptrdiff_t) old_size, 0);
 
 	return data;
 }
@@ -379,27 +930,71 @@ void *Mem_Link(void *child, void *parent) {
 	mem_block_t *c = Mem_CheckMagic(child);
 	mem_block_t *p = Mem_CheckMagic(parent);
 
-	SDL_AtomicLock(&mem_state.lock);
+	SDL_SpinLock *lock = Mem_ListLock(c);
 
-	if (c->parent) {
-		c->parent->children = g_slist_remove(c->parent->children, c);
-	} else {
-		g_hash_table_remove(mem_state.blocks, c);
+	SDL_AtomicLock(lock);
+
+	mem_block_t *last = Mem_LastDescendant(c);
+	Mem_RemoveBlocks(c, last);
+
+	SDL_AtomicUnlock(lock);
+
+	// the child and its descendants move to the parent's list
+	const int32_t depth = p->depth + 1 - c->depth;
+
+	for (mem_block_t *b = c; b; b = b->next) {
+		b->depth += depth;
+		b->shard = p->shard;
 	}
 
-	c->parent = p;
-	p->children = g_slist_prepend(p->children, c);
+	lock = Mem_ListLock(p);
 
-	SDL_AtomicUnlock(&mem_state.lock);
+	SDL_AtomicLock(lock);
+	Mem_InsertBlocks(c, last, p);
+	SDL_AtomicUnlock(lock);
 
 	return child;
 }
 
+/**
+ * @brief Allocations with the specified tag are bump allocated from an arena, rather
+ * than from the size-class pools. The arena's memory is released wholesale once all of
+ * its blocks are freed, typically by Mem_FreeTag. This suits tags whose allocations
+ * live and die together.
+ * @remarks This should be called before any allocations are made with the tag. Each
+ * bucket of tags may hold only one arena; tags which collide are simply not arena
+ * allocated.
+ */
+void Mem_TagArena(mem_tag_t tag) {
+
+	mem_arena_t **arena = &mem_state.arenas[tag & (MEM_TAG_BUCKETS - 1)];
+	if (*arena) {
+		if ((*arena)->tag != tag) {
+			fprintf(stderr, "Arena for tag %d collides with tag %d\n", tag, (*arena)->tag);
+		}
+		return;
+	}
+
+	*arena = calloc(1, sizeof(mem_arena_t));
+	(*arena)->tag = tag;
+}
+
 /**
  * @return The current size (user bytes) of the zone allocation pool.
  */
 size_t Mem_Size(void) {
-	return mem_state.size;
+
+	size_t size = 0;
+
+	SDL_AtomicLock(&mem_state.counters_lock);
+
+	for (const mem_counters_t *c = mem_state.counters; c; c = c->next) {
+		size += atomic_load_explicit(&c->size, memory_order_relaxed);
+	}
+
+	SDL_AtomicUnlock(&mem_state.counters_lock);
+
+	return size;
 }
 
 /**
@@ -426,70 +1021,143 @@ char *Mem_CopyString(const char *in) {
  * @brief
  */
 static gint Mem_Stats_Sort(gconstpointer a, gconstpointer b) {
-	return (gint) (((const mem_stat_t *) b)->size - ((const mem_stat_t *) a)->size);
+
+	const mem_stat_t *sa = (const mem_stat_t *) a, *sb = (const mem_stat_t *) b;
+
+	if (sa->tag == MEM_TAG_ALL || sb->tag == MEM_TAG_ALL) {
+		return (sb->tag == MEM_TAG_ALL) - (sa->tag == MEM_TAG_ALL);
+	}
+
+	return (gint) (sb->size - sa->size);
 }
 
 /**
- * @brief
+ * @return The stats for the specified tag, appending them if necessary.
  */
-static size_t Mem_CalculateBlockSize(const mem_block_t *b) {
+static mem_stat_t *Mem_Stat(GArray *stat_array, mem_tag_t tag) {
 
-	size_t size = b->size;
+	for (size_t i = 0; i < stat_array->len; i++) {
 
-	for (GSList *child = b->children; child; child = child->next) {
-		size += Mem_CalculateBlockSize((const mem_block_t *) child->data);
+		mem_stat_t *stat_i = &g_array_index(stat_array, mem_stat_t, i);
+
+		if (stat_i->tag == tag) {
+			return stat_i;
+		}
 	}
 
-	return size;
+	g_array_append_vals(stat_array, &(const mem_stat_t) {
+		.tag = tag
+	}, 1);
+
+	return &g_array_index(stat_array, mem_stat_t, stat_array->len - 1);
 }
 
 /**
- * @brief Fetches stats about allocated memory to the console.
+ * @brief Fetches stats about allocated memory to the console. The first element holds
+ * the totals, including the high-water mark, which is sampled by each call rather than
+ * by each allocation. Allocation rates are measured since the previous call.
+ * @remarks Lean builds report each tag from the per-thread counters alone, without
+ * walking any blocks; children are then accounted to their own tag rather than to that
+ * of their root block, and counted as blocks.
  */
 GArray *Mem_Stats(void) {
 
-	GHashTableIter it;
-	gpointer key, value;
+	GArray *stat_array = g_array_new(false, true, sizeof(mem_stat_t));
 
-	SDL_AtomicLock(&mem_state.lock);
+	Mem_Stat(stat_array, MEM_TAG_ALL);
 
-	GArray *stat_array = g_array_new(false, true, sizeof(mem_stat_t));
+	size_t size[MEM_TAGS] = { 0 }, count[MEM_TAGS] = { 0 }, allocs[MEM_TAGS] = { 0 };
+	size_t total_size = 0;
 
-	stat_array = g_array_append_vals(stat_array, &(const mem_stat_t) {
-		.tag = -1,
-		 .size = mem_state.size,
-		  .count = 0
-	}, 1);
+	SDL_AtomicLock(&mem_state.counters_lock);
+
+	for (const mem_counters_t *c = mem_state.counters; c; c = c->next) {
+		total_size += atomic_load_explicit(&c->size, memory_order_relaxed);
+		for (int32_t i = 0; i < MEM_TAGS; i++) {
+			size[i] += atomic_load_explicit(&c->tags[i].size, memory_order_relaxed);
+			count[i] += atomic_load_explicit(&c->tags[i].count, memory_order_relaxed);
+			allocs[i] += atomic_load_explicit(&c->tags[i].allocs, memory_order_relaxed);
+		}
+	}
 
-	g_hash_table_iter_init(&it, mem_state.blocks);
+	SDL_AtomicUnlock(&mem_state.counters_lock);
 
-	while (g_hash_table_iter_next(&it, &key, &value)) {
-		const mem_block_t *b = (const mem_block_t *) key;
-		mem_stat_t *stats = NULL;
+	SDL_AtomicLock(&mem_state.stats_lock);
 
-		for (size_t i = 0; i < stat_array->len; i++) {
+	const gint64 now = g_get_monotonic_time();
+	const float seconds = MAX(now - mem_state.stats_time, 1) / 1000000.f;
 
-			mem_stat_t *stat_i = &g_array_index(stat_array, mem_stat_t, i);
+	mem_state.stats_time = now;
+	mem_state.stats_peak = MAX(mem_state.stats_peak, total_size);
 
-			if (stat_i->tag == b->tag) {
-				stats = stat_i;
-				break;
-			}
+	const size_t peak = mem_state.stats_peak;
+
+	for (int32_t i = 0; i < MEM_TAGS; i++) {
+		const size_t previous = mem_state.stats_allocs[i];
+		mem_state.stats_allocs[i] = allocs[i];
+		allocs[i] -= previous;
+	}
+
+	SDL_AtomicUnlock(&mem_state.stats_lock);
+
+	size_t total_count = 0, total_allocs = 0;
+
+	for (int32_t i = 0; i < MEM_TAGS; i++) {
+
+		const int32_t key = atomic_load(&mem_state.tags[i]);
+		if (key == 0) {
+			continue;
 		}
 
-		if (stats == NULL) {
-			stat_array = g_array_append_vals(stat_array, &(const mem_stat_t) {
-				.tag = b->tag,
-				 .size = Mem_CalculateBlockSize(b),
-				  .count = 1
-			}, 1);
-		} else {
-			stats->size += Mem_CalculateBlockSize(b);
-			stats->count++;
+		total_count += count[i];
+		total_allocs += allocs[i];
+
+		if (count[i] == 0 && allocs[i] == 0) {
+			continue;
+		}
+
+		mem_stat_t *stat = Mem_Stat(stat_array, key - 1);
+
+#if defined(LEAN_MEMORY)
+		stat->size += size[i];
+		stat->count += count[i];
+#endif
+
+		stat->rate += allocs[i] / seconds;
+	}
+
+#if !defined(LEAN_MEMORY)
+	// descendants are accounted to the tag of their root block
+	for (int32_t i = 0; i < MEM_SHARDS; i++) {
+		mem_shard_t *shard = &mem_state.shards[i];
+
+		SDL_AtomicLock(&shard->lock);
+
+		for (int32_t j = 0; j < MEM_TAG_BUCKETS; j++) {
+
+			mem_stat_t *stat = NULL;
+
+			for (const mem_block_t *b = shard->blocks[j]; b; b = b->next) {
+
+				if (b->depth == 0) {
+					stat = Mem_Stat(stat_array, b->tag);
+					stat->count++;
+				}
+
+				stat->size += b->size;
+			}
 		}
+
+		SDL_AtomicUnlock(&shard->lock);
 	}
+#endif
 
-	SDL_AtomicUnlock(&mem_state.lock);
+	mem_stat_t *total = &g_array_index(stat_array, mem_stat_t, 0);
+
+	total->size = total_size;
+	total->count = total_count;
+	total->peak = peak;
+	total->rate = total_allocs / seconds;
 
 	g_array_sort(stat_array, Mem_Stats_Sort);
 
@@ -501,10 +1169,33 @@ GArray *Mem_Stats(void) {
  * subsystems initialized by Quetoo.
  */
 void Mem_Init(void) {
+	static uint32_t generation;
 
 	memset(&mem_state, 0, sizeof(mem_state));
 
-	mem_state.blocks = g_hash_table_new(NULL, NULL);
+	// thread caches from any previous initialization are discarded on next use
+	mem_state.generation = ++generation;
+
+	mem_state.stats_time = g_get_monotonic_time();
+
+	// size classes step by 16 bytes up to 256, and then by quarter powers of two
+	size_t size = 32;
+	while (size <= MEM_POOL_MAX) {
+		mem_state.pools[mem_state.num_pools++].size = size;
+
+		if (size < 256) {
+			size += 16;
+		} else {
+			size += (size_t) 1 << (31 - __builtin_clz((uint32_t) size) - 2);
+		}
+	}
+
+	for (int32_t i = 0, pool = 0; i <= MEM_POOL_MAX / 16; i++) {
+		while (mem_state.pools[pool].size < (size_t) i * 16) {
+			pool++;
+		}
+		mem_state.pool_for_size[i] = (int8_t) pool;
+	}
 }
 
 /**
@@ -515,5 +1206,22 @@ void Mem_Shutdown(void) {
 
 	Mem_FreeTag(MEM_TAG_ALL);
 
-	g_hash_table_destroy(mem_state.blocks);
+	for (int32_t i = 0; i < mem_state.num_pools; i++) {
+		g_slist_free_full(mem_state.pools[i].slabs, free);
+	}
+
+	for (int32_t i = 0; i < MEM_TAG_BUCKETS; i++) {
+		if (mem_state.arenas[i]) {
+			g_slist_free_full(mem_state.arenas[i]->chunks, free);
+			free(mem_state.arenas[i]);
+		}
+	}
+
+	while (mem_state.counters) {
+		mem_counters_t *next = mem_state.counters->next;
+		free(mem_state.counters);
+		mem_state.counters = next;
+	}
+
+	memset(&mem_state, 0, sizeof(mem_state));
 }
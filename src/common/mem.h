@@ -34,6 +34,7 @@ size_t Mem_Size(void);
 char *Mem_TagCopyString(const char *in, mem_tag_t tag);
 char *Mem_CopyString(const char *in);
 void Mem_Check(void *p);
+void Mem_TagArena(mem_tag_t tag);
 
 /**
  * @brief Struct used for return values of Mem_Stats
@@ -42,6 +43,8 @@ typedef struct {
 	mem_tag_t	tag; // tag
 	size_t		size; // total size in bytes
 	size_t		count; // number of blocks
+	size_t		peak; // high-water mark in bytes, as sampled by Mem_Stats, for the total only
+	float		rate; // allocations per second since the previous call
 } mem_stat_t;
 
 GArray *Mem_Stats(void);
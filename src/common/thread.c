@@ -24,36 +24,82 @@
 
 #include "thread.h"
 
+/**
+ * @brief The capacity of each worker's job deque. Must be a power of two.
+ */
+#define THREAD_DEQUE_SIZE 4096
+
+/**
+ * @brief A unit of work.
+ */
+typedef struct {
+	ThreadRunFunc Run;
+	void *data;
+	thread_counter_t *counter;
+} thread_job_t;
+
+/**
+ * @brief A deque slot. Thieves may read a slot while its owner rewrites it, in which case
+ * the thief's claim fails, so the fields are accessed atomically to avoid torn reads.
+ */
+typedef struct {
+	_Atomic(ThreadRunFunc) Run;
+	_Atomic(void *) data;
+	_Atomic(thread_counter_t *) counter;
+} thread_slot_t;
+
+/**
+ * @brief A Chase-Lev work-stealing deque. The owning worker pushes and pops jobs at the
+ * bottom, while other workers steal them from the top, without locking.
+ */
+typedef struct {
+	_Atomic int64_t top;
+	_Atomic int64_t bottom;
+	thread_slot_t slots[THREAD_DEQUE_SIZE];
+} thread_deque_t;
+
+/**
+ * @brief A worker thread and its deque. The first worker is the main thread, which
+ * participates in job execution whenever it waits.
+ */
+typedef struct {
+	SDL_Thread *thread;
+	thread_deque_t deque;
+} thread_worker_t;
+
 typedef struct {
 
 	/**
-	 * @brief The lock governing global thread pool access.
+	 * @brief The number of threads in the pool, not including the main thread.
 	 */
-	SDL_SpinLock lock;
+	size_t num_threads;
 
 	/**
-	 * @brief The thread dispatch identifier.
+	 * @brief The workers, including the main thread at index 0.
 	 */
-	SDL_atomic_t id;
+	thread_worker_t *workers;
 
 	/**
-	 * @brief The number of threads in the pool.
+	 * @brief Jobs submitted by threads which are not workers.
 	 */
-	size_t num_threads;
+	GQueue external;
+	SDL_SpinLock external_lock;
+	atomic_int num_external;
+
+	/**
+	 * @brief Idle workers sleep on this semaphore until jobs are submitted.
+	 */
+	SDL_sem *sem;
+	atomic_int sleeping;
 
 	/**
-	 * @brief The threads.
+	 * @brief Set to terminate the workers.
 	 */
-	thread_t *threads;
+	atomic_bool shutdown;
 } thread_pool_t;
 
 static thread_pool_t thread_pool;
 
-/**
- * @brief A sentinel thread function to indicate thread termination.
- */
-static ThreadRunFunc ThreadTerminate = (ThreadRunFunc) &ThreadTerminate;
-
 /**
  * @brief The main thread ID.
  */
@@ -65,134 +111,417 @@ SDL_threadID thread_main;
 _Thread_local SDL_threadID thread_id;
 
 /**
- * @brief Wrap the user's function in our own for introspection.
+ * @brief The worker index of the current thread, or -1 if it is not a worker.
+ */
+static _Thread_local int32_t thread_worker = -1;
+
+/**
+ * @brief Writes the job to the specified slot.
+ */
+static void Thread_Store(thread_slot_t *slot, const thread_job_t *job) {
+
+	atomic_store_explicit(&slot->Run, job->Run, memory_order_relaxed);
+	atomic_store_explicit(&slot->data, job->data, memory_order_relaxed);
+	atomic_store_explicit(&slot->counter, job->counter, memory_order_relaxed);
+}
+
+/**
+ * @brief Reads the job at the specified slot.
+ */
+static void Thread_Load(thread_slot_t *slot, thread_job_t *job) {
+
+	job->Run = atomic_load_explicit(&slot->Run, memory_order_relaxed);
+	job->data = atomic_load_explicit(&slot->data, memory_order_relaxed);
+	job->counter = atomic_load_explicit(&slot->counter, memory_order_relaxed);
+}
+
+/**
+ * @brief Pushes a job onto the bottom of the deque. Only the owning worker may push.
+ * @return False if the deque is full.
+ */
+static bool Thread_Push(thread_deque_t *deque, const thread_job_t *job) {
+
+	const int64_t b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+	const int64_t t = atomic_load_explicit(&deque->top, memory_order_acquire);
+
+	if (b - t >= THREAD_DEQUE_SIZE) {
+		return false;
+	}
+
+	Thread_Store(&deque->slots[b & (THREAD_DEQUE_SIZE - 1)], job);
+
+	atomic_store_explicit(&deque->bottom, b + 1, memory_order_release);
+
+	return true;
+}
+
+/**
+ * @brief Pops a job from the bottom of the deque. Only the owning worker may pop.
+ * @return True if a job was popped.
+ */
+static bool Thread_Pop(thread_deque_t *deque, thread_job_t *job) {
+
+	const int64_t b = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+	atomic_store_explicit(&deque->bottom, b, memory_order_relaxed);
+
+	atomic_thread_fence(memory_order_seq_cst);
+
+	int64_t t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+	if (t > b) {
+		atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+		return false;
+	}
+
+	Thread_Load(&deque->slots[b & (THREAD_DEQUE_SIZE - 1)], job);
+
+	if (t == b) { // the last job, race any thieves for it
+		const bool won = atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+		                                                         memory_order_seq_cst,
+		                                                         memory_order_relaxed);
+		atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+		return won;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Steals a job from the top of the deque. Any thread may steal.
+ * @return True if a job was stolen.
+ */
+static bool Thread_Steal(thread_deque_t *deque, thread_job_t *job) {
+
+	int64_t t = atomic_load_explicit(&deque->top, memory_order_acquire);
+
+	atomic_thread_fence(memory_order_seq_cst);
+
+	const int64_t b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+	if (t >= b) {
+		return false;
+	}
+
+	Thread_Load(&deque->slots[t & (THREAD_DEQUE_SIZE - 1)], job);
+
+	return atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+	                                               memory_order_seq_cst,
+	                                               memory_order_relaxed);
+}
+
+/**
+ * @return True if any job is queued anywhere in the pool.
+ */
+static bool Thread_Pending(void) {
+
+	for (size_t i = 0; i <= thread_pool.num_threads; i++) {
+		const thread_deque_t *deque = &thread_pool.workers[i].deque;
+
+		if (atomic_load(&deque->top) < atomic_load(&deque->bottom)) {
+			return true;
+		}
+	}
+
+	return atomic_load(&thread_pool.num_external) > 0;
+}
+
+/**
+ * @brief Wakes a single sleeping worker, if any.
+ */
+static void Thread_Wake(void) {
+
+	int32_t sleeping = atomic_load(&thread_pool.sleeping);
+
+	while (sleeping > 0) {
+		if (atomic_compare_exchange_weak(&thread_pool.sleeping, &sleeping, sleeping - 1)) {
+			SDL_SemPost(thread_pool.sem);
+			break;
+		}
+	}
+}
+
+/**
+ * @brief Runs the job, and then signals its counter.
+ */
+static void Thread_Execute(const thread_job_t *job) {
+
+	job->Run(job->data);
+
+	if (job->counter) {
+		atomic_fetch_sub(job->counter, 1);
+	}
+}
+
+/**
+ * @brief Fetches the next job for the calling thread: its own jobs first, then the
+ * external queue, and finally jobs stolen from the other workers.
+ * @return True if a job was fetched.
+ */
+static bool Thread_Next(thread_job_t *job) {
+
+	const int32_t self = thread_worker;
+
+	if (self != -1 && Thread_Pop(&thread_pool.workers[self].deque, job)) {
+		return true;
+	}
+
+	if (atomic_load(&thread_pool.num_external) > 0) {
+		SDL_AtomicLock(&thread_pool.external_lock);
+
+		thread_job_t *external = g_queue_pop_head(&thread_pool.external);
+		if (external) {
+			atomic_fetch_sub(&thread_pool.num_external, 1);
+		}
+
+		SDL_AtomicUnlock(&thread_pool.external_lock);
+
+		if (external) {
+			*job = *external;
+			g_slice_free(thread_job_t, external);
+			return true;
+		}
+	}
+
+	const size_t count = thread_pool.num_threads + 1;
+	const size_t start = (size_t) (self + 1);
+
+	for (size_t i = 0; i < count; i++) {
+		const size_t victim = (start + i) % count;
+
+		if ((int32_t) victim == self) {
+			continue;
+		}
+
+		if (Thread_Steal(&thread_pool.workers[victim].deque, job)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief The worker thread loop. Workers execute jobs until none remain, and then sleep
+ * until more are submitted.
  */
 static int32_t Thread_Run(void *data) {
-	thread_t *t = (thread_t *) data;
 
+	thread_worker = (int32_t) (intptr_t) data;
 	thread_id = SDL_ThreadID();
 
-	while (t->Run != ThreadTerminate) {
+	thread_job_t job;
+
+	while (!atomic_load(&thread_pool.shutdown)) {
+
+		if (Thread_Next(&job)) {
+			Thread_Execute(&job);
+			continue;
+		}
+
+		atomic_fetch_add(&thread_pool.sleeping, 1);
 
-		SDL_LockMutex(t->mutex);
+		// re-check after announcing ourselves, so that we can not miss a wake up
+		if (Thread_Pending() || atomic_load(&thread_pool.shutdown)) {
 
-		if (t->status == THREAD_RUNNING) {
-			t->Run(t->data);
-			if (t->options & THREAD_NO_WAIT) {
-				t->status = THREAD_IDLE;
-			} else {
-				t->status = THREAD_WAITING;
+			int32_t sleeping = atomic_load(&thread_pool.sleeping);
+			while (sleeping > 0) {
+				if (atomic_compare_exchange_weak(&thread_pool.sleeping, &sleeping, sleeping - 1)) {
+					break;
+				}
+			}
+
+			if (sleeping > 0) {
+				continue;
 			}
-			SDL_CondBroadcast(t->cond);
-		} else {
-			SDL_CondWait(t->cond, t->mutex);
+
+			// a submitter has already claimed us, so consume its wake up
 		}
 
-		SDL_UnlockMutex(t->mutex);
+		SDL_SemWait(thread_pool.sem);
 	}
 
 	return 0;
 }
 
 /**
- * @brief Initializes the threads backing the thread pool.
+ * @brief Submits a job to the pool. If `counter` is not NULL, it is incremented now, and
+ * decremented once the job has run; use `Thread_Join` to wait on it. Jobs submitted by
+ * workers, including the main thread, are pushed to the worker's own deque without locking.
  */
-static void Thread_Init_(ssize_t num_threads) {
+void Thread_Submit(ThreadRunFunc run, void *data, thread_counter_t *counter) {
 
-	if (num_threads == 0) {
-		num_threads = SDL_GetCPUCount();
-	} else if (num_threads == -1) {
-		num_threads = 0;
-	} else if (num_threads > MAX_THREADS) {
-		num_threads = MAX_THREADS;
+	const thread_job_t job = {
+		.Run = run,
+		.data = data,
+		.counter = counter
+	};
+
+	if (counter) {
+		atomic_fetch_add(counter, 1);
 	}
 
-	thread_pool.num_threads = num_threads;
+	// without threads, or with a full deque, run the job immediately
+	if (thread_pool.num_threads == 0) {
+		Thread_Execute(&job);
+		return;
+	}
+
+	if (thread_worker != -1) {
+		if (!Thread_Push(&thread_pool.workers[thread_worker].deque, &job)) {
+			Thread_Execute(&job);
+			return;
+		}
+	} else {
+		thread_job_t *external = g_slice_dup(thread_job_t, &job);
+
+		SDL_AtomicLock(&thread_pool.external_lock);
+
+		g_queue_push_tail(&thread_pool.external, external);
+		atomic_fetch_add(&thread_pool.num_external, 1);
+
+		SDL_AtomicUnlock(&thread_pool.external_lock);
+	}
+
+	atomic_thread_fence(memory_order_seq_cst);
+
+	Thread_Wake();
+}
+
+/**
+ * @brief Waits for all jobs submitted with `counter` to complete. Rather than blocking,
+ * the calling thread executes pending jobs while it waits. Jobs may therefore depend on
+ * other jobs by joining their counters, without idling a worker.
+ */
+void Thread_Join(thread_counter_t *counter) {
 
-	if (thread_pool.num_threads) {
-		thread_pool.threads = Mem_Malloc(sizeof(thread_t) * thread_pool.num_threads);
+	thread_job_t job;
+	uint32_t spins = 0;
 
-		thread_t *t = thread_pool.threads;
+	while (atomic_load(counter) > 0) {
 
-		for (size_t i = 0; i < thread_pool.num_threads; i++, t++) {
-			t->cond = SDL_CreateCond();
-			t->mutex = SDL_CreateMutex();
-			t->thread = SDL_CreateThread(Thread_Run, __func__, t);
+		if (thread_pool.num_threads && Thread_Next(&job)) {
+			Thread_Execute(&job);
+			spins = 0;
+			continue;
+		}
+
+		if (++spins > 64) {
+			SDL_Delay(0);
 		}
 	}
 }
 
 /**
- * Thread_Shutdown_
+ * @brief State shared by the jobs of a single `Thread_ParallelFor`.
+ */
+typedef struct {
+	ThreadParallelFunc func;
+	void *data;
+	int32_t count;
+	int32_t batch;
+	atomic_int next;
+} thread_parallel_t;
+
+/**
+ * @brief Claims and runs batches of the parallel loop until none remain.
  */
-static void Thread_Shutdown_(void) {
+static void Thread_ParallelRun(void *data) {
 
-	if (thread_pool.num_threads) {
-		thread_t *t = thread_pool.threads;
+	thread_parallel_t *parallel = data;
 
-		for (size_t i = 0; i < thread_pool.num_threads; i++, t++) {
-			Thread_Wait(t);
-			t->Run = ThreadTerminate;
-			SDL_CondSignal(t->cond);
-			SDL_WaitThread(t->thread, NULL);
-			SDL_DestroyCond(t->cond);
-			SDL_DestroyMutex(t->mutex);
+	while (true) {
+		const int32_t start = atomic_fetch_add(&parallel->next, parallel->batch);
+		if (start >= parallel->count) {
+			break;
 		}
 
-		Mem_Free(thread_pool.threads);
+		const int32_t end = MIN(start + parallel->batch, parallel->count);
+		for (int32_t i = start; i < end; i++) {
+			parallel->func(i, parallel->data);
+		}
 	}
 }
 
 /**
- * @brief Creates a new thread to run the specified function. Callers must use
- * Thread_Wait on the returned handle to release the thread when finished.
+ * @brief Calls `func` for every index in `[0, count)`, distributing batches of `batch`
+ * indices across the pool. The calling thread participates, and this returns once all
+ * indices have been processed. Pass 0 for `batch` to choose a batch size automatically.
  */
-thread_t *Thread_Create_(const char *name, ThreadRunFunc run, void *data, thread_options_t options) {
+void Thread_ParallelFor(int32_t count, int32_t batch, ThreadParallelFunc func, void *data) {
 
-	// if threads are available, find an idle one and dispatch it
-	if (thread_pool.num_threads) {
-		SDL_AtomicLock(&thread_pool.lock);
+	if (count <= 0) {
+		return;
+	}
 
-		thread_t *t = thread_pool.threads;
-		for (size_t i = 0; i < thread_pool.num_threads; i++, t++) {
+	const int32_t num_workers = (int32_t) thread_pool.num_threads + 1;
 
-			// if the thread appears idle, lock it and check again
-			if (t->status == THREAD_IDLE) {
+	if (batch <= 0) {
+		batch = MAX(1, count / (num_workers * 8));
+	}
 
-				SDL_LockMutex(t->mutex);
+	thread_parallel_t parallel = {
+		.func = func,
+		.data = data,
+		.count = count,
+		.batch = batch
+	};
 
-				// if the thread is idle, dispatch it
-				if (t->status == THREAD_IDLE) {
-					t->status = THREAD_RUNNING;
-					t->options = options;
+	atomic_init(&parallel.next, 0);
 
-					g_strlcpy(t->name, name, sizeof(t->name));
+	const int32_t num_batches = (count + batch - 1) / batch;
+	const int32_t num_jobs = MIN(num_workers, num_batches) - 1;
 
-					t->Run = run;
-					t->data = data;
+	thread_counter_t counter = 0;
 
-					SDL_UnlockMutex(t->mutex);
-					SDL_CondSignal(t->cond);
+	for (int32_t i = 0; i < num_jobs; i++) {
+		Thread_Submit(Thread_ParallelRun, &parallel, &counter);
+	}
 
-					SDL_AtomicUnlock(&thread_pool.lock);
-					return t;
-				}
+	Thread_ParallelRun(&parallel);
 
-				SDL_UnlockMutex(t->mutex);
-			}
-		}
+	Thread_Join(&counter);
+}
+
+/**
+ * @brief Runs the job behind a `thread_t` handle, releasing it if nobody will wait.
+ */
+static void Thread_RunHandle(void *data) {
 
-		SDL_AtomicUnlock(&thread_pool.lock);
+	thread_t *t = data;
+
+	t->Run(t->data);
+
+	if (t->options & THREAD_NO_WAIT) {
+		g_slice_free(thread_t, t);
 	}
+}
+
+/**
+ * @brief Creates a new job to run the specified function. Unless `THREAD_NO_WAIT` is
+ * specified, callers must use Thread_Wait on the returned handle to release it.
+ * @return The job handle, or NULL for `THREAD_NO_WAIT` jobs.
+ */
+thread_t *Thread_Create_(const char *name, ThreadRunFunc run, void *data, thread_options_t options) {
 
-	// if we failed to allocate a thread, run the function in this thread
+	thread_t *t = g_slice_new0(thread_t);
 
-	run(data);
-	return NULL;
+	g_strlcpy(t->name, name, sizeof(t->name));
+
+	t->Run = run;
+	t->data = data;
+	t->options = options;
+
+	if (options & THREAD_NO_WAIT) {
+		Thread_Submit(Thread_RunHandle, t, NULL);
+		return NULL;
+	}
+
+	Thread_Submit(Thread_RunHandle, t, &t->counter);
+	return t;
 }
 
 /**
- * @brief Wait for the specified thread to complete.
+ * @brief Wait for the specified job to complete, and release its handle.
  */
 void Thread_Wait(thread_t *t) {
 
@@ -200,16 +529,9 @@ void Thread_Wait(thread_t *t) {
 		return;
 	}
 
-	SDL_LockMutex(t->mutex);
-
-	if (t->status == THREAD_RUNNING) {
-		SDL_CondWait(t->cond, t->mutex);
-		assert(t->status == THREAD_WAITING);
-	}
+	Thread_Join(&t->counter);
 
-	SDL_UnlockMutex(t->mutex);
-
-	t->status = THREAD_IDLE;
+	g_slice_free(thread_t, t);
 }
 
 /**
@@ -226,17 +548,58 @@ void Thread_Init(ssize_t num_threads) {
 
 	memset(&thread_pool, 0, sizeof(thread_pool));
 
-	Thread_Init_(num_threads);
+	if (num_threads == 0) {
+		num_threads = SDL_GetCPUCount();
+	} else if (num_threads == -1) {
+		num_threads = 0;
+	} else if (num_threads > MAX_THREADS) {
+		num_threads = MAX_THREADS;
+	}
+
+	thread_pool.num_threads = num_threads;
+
+	g_queue_init(&thread_pool.external);
+
+	thread_pool.workers = Mem_Malloc(sizeof(thread_worker_t) * (thread_pool.num_threads + 1));
+	thread_pool.sem = SDL_CreateSemaphore(0);
 
 	thread_main = SDL_ThreadID();
+	thread_worker = 0;
+
+	for (size_t i = 1; i <= thread_pool.num_threads; i++) {
+		thread_worker_t *worker = &thread_pool.workers[i];
+		worker->thread = SDL_CreateThread(Thread_Run, "Thread_Run", (void *) (intptr_t) i);
+	}
 }
 
 /**
- * @brief Shuts down the thread pool.
+ * @brief Shuts down the thread pool, after running any pending jobs.
  */
 void Thread_Shutdown(void) {
 
-	Thread_Shutdown_();
+	if (thread_pool.workers) {
+		thread_job_t job;
+
+		while (thread_pool.num_threads && Thread_Next(&job)) {
+			Thread_Execute(&job);
+		}
+
+		atomic_store(&thread_pool.shutdown, true);
+
+		for (size_t i = 1; i <= thread_pool.num_threads; i++) {
+			SDL_SemPost(thread_pool.sem);
+		}
+
+		for (size_t i = 1; i <= thread_pool.num_threads; i++) {
+			SDL_WaitThread(thread_pool.workers[i].thread, NULL);
+		}
+
+		SDL_DestroySemaphore(thread_pool.sem);
+
+		Mem_Free(thread_pool.workers);
+	}
+
+	thread_worker = -1;
 
 	memset(&thread_pool, 0, sizeof(thread_pool));
 }
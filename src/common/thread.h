@@ -25,13 +25,9 @@
 
 #include "mem.h"
 
-#define MAX_THREADS 128
+#include <stdatomic.h>
 
-typedef enum {
-	THREAD_IDLE,
-	THREAD_RUNNING,
-	THREAD_WAITING,
-} thread_status_t;
+#define MAX_THREADS 128
 
 typedef enum {
 	THREAD_NONE,
@@ -44,20 +40,34 @@ typedef enum {
 
 typedef void (*ThreadRunFunc)(void *data);
 
+/**
+ * @brief Counts outstanding jobs. Jobs submitted with a counter increment it, and
+ * decrement it once they have run. Zero-initialize counters before use.
+ */
+typedef atomic_int thread_counter_t;
+
+/**
+ * @brief A handle to a single job, as returned by `Thread_Create`.
+ */
 typedef struct {
-	SDL_Thread *thread;
-	SDL_cond *cond;
-	SDL_mutex *mutex;
-	thread_status_t status;
-	thread_options_t options;
 	char name[64];
 	ThreadRunFunc Run;
 	void *data;
+	thread_options_t options;
+	thread_counter_t counter;
 } thread_t;
 
+/**
+ * @brief The function type for `Thread_ParallelFor`.
+ */
+typedef void (*ThreadParallelFunc)(int32_t index, void *data);
+
 thread_t *Thread_Create_(const char *name, ThreadRunFunc run, void *data, thread_options_t options);
 #define Thread_Create(function, data, options) Thread_Create_(#function, function, data, options)
 void Thread_Wait(thread_t *t);
+void Thread_Submit(ThreadRunFunc run, void *data, thread_counter_t *counter);
+void Thread_Join(thread_counter_t *counter);
+void Thread_ParallelFor(int32_t count, int32_t batch, ThreadParallelFunc func, void *data);
 int32_t Thread_Count(void);
 void Thread_Init(ssize_t num_threads);
 void Thread_Shutdown(void);
@@ -1553,6 +1553,7 @@ static void Ai_TestPath_f(void) {
 }
 
 void Ai_OffsetNodes_f(void);
+void Ai_BenchmarkPaths_f(void);
 
 /**
  * @brief Initializes the AI subsystem.
@@ -1580,6 +1581,8 @@ void G_Ai_InitLocals(void) {
 
 	gi.AddCmd("ai_offset_nodes", Ai_OffsetNodes_f, CMD_AI, "Offset the loaded nodes by the specified translation");
 
+	gi.AddCmd("ai_benchmark_paths", Ai_BenchmarkPaths_f, CMD_AI, "Benchmark path finding between random nodes");
+
 	Ai_InitItems();
 	Ai_InitSkins();
 
@@ -1605,6 +1608,9 @@ void G_Ai_Shutdown(void) {
 
 	Ai_ShutdownSkins();
 
+	// invalidate the path states before their memory is freed with the tag
+	Ai_ShutdownNodes();
+
 	gi.FreeTag(MEM_TAG_AI);
 }
 
@@ -82,11 +82,6 @@ typedef struct {
 
 	vec3_t position;
 	GArray *links;
-
-	// only used for nav purposes
-
-	float cost;
-	ai_node_id_t came_from;
 } ai_node_t;
 
 /**
@@ -94,13 +89,6 @@ typedef struct {
  */
 static GArray *ai_nodes;
 
-/**
- * @brief
- */
-static inline ai_node_id_t Ai_Node_Index(const ai_node_t *node) {
-	return node - (ai_node_t *) ai_nodes->data;
-}
-
 /**
  * @brief
  */
@@ -867,6 +855,163 @@ void Ai_Node_Render(void) {
 	}
 }
 
+/**
+ * @brief An entry in the A* open set. The cost is that of the node when it was pushed, so that
+ * entries superseded by a cheaper path can be skipped.
+ */
+typedef struct {
+	ai_node_id_t id;
+	float cost;
+	float priority;
+} ai_node_priority_t;
+
+/**
+ * @brief Per-thread A* scratch state. Node costs and parents are only valid for nodes stamped
+ * with the current search generation, so the arrays are never cleared between searches, and
+ * searches allocate nothing but the resulting path.
+ */
+typedef struct {
+	uint32_t epoch;
+	uint32_t generation;
+
+	guint num_nodes;
+	uint32_t *generations;
+	float *costs;
+	ai_node_id_t *came_from;
+
+	ai_node_priority_t *heap;
+	guint heap_size, heap_capacity;
+} ai_path_state_t;
+
+/**
+ * @brief Incremented whenever the node graph is unloaded, invalidating all path states.
+ */
+static uint32_t ai_path_epoch = 1;
+
+/**
+ * @brief Each thread searches with its own state, so that searches may run concurrently.
+ */
+static _Thread_local ai_path_state_t ai_path_state;
+
+/**
+ * @brief Frees the calling thread's path state.
+ */
+static void Ai_Path_FreeState(void) {
+
+	ai_path_state_t *state = &ai_path_state;
+
+	if (state->epoch == ai_path_epoch) {
+		gi.Free(state->generations);
+		gi.Free(state->costs);
+		gi.Free(state->came_from);
+		gi.Free(state->heap);
+	}
+
+	memset(state, 0, sizeof(*state));
+}
+
+/**
+ * @return The calling thread's path state, sized for the current node graph.
+ */
+static ai_path_state_t *Ai_Path_State(void) {
+
+	ai_path_state_t *state = &ai_path_state;
+
+	// states from a previous node graph are released with the AI memory tag
+	if (state->epoch != ai_path_epoch) {
+		memset(state, 0, sizeof(*state));
+		state->epoch = ai_path_epoch;
+	}
+
+	if (state->num_nodes < ai_nodes->len) {
+
+		Ai_Path_FreeState();
+
+		state->epoch = ai_path_epoch;
+		state->num_nodes = ai_nodes->len * 2;
+
+		state->generations = gi.Malloc(state->num_nodes * sizeof(uint32_t), MEM_TAG_AI);
+		state->costs = gi.Malloc(state->num_nodes * sizeof(float), MEM_TAG_AI);
+		state->came_from = gi.Malloc(state->num_nodes * sizeof(ai_node_id_t), MEM_TAG_AI);
+
+		state->heap_capacity = state->num_nodes;
+		state->heap = gi.Malloc(state->heap_capacity * sizeof(ai_node_priority_t), MEM_TAG_AI);
+	}
+
+	return state;
+}
+
+/**
+ * @brief Pushes an entry onto the open set.
+ */
+static void Ai_Path_Push(ai_path_state_t *state, const ai_node_priority_t entry) {
+
+	if (state->heap_size == state->heap_capacity) {
+		ai_node_priority_t *heap = gi.Malloc(state->heap_capacity * 2 * sizeof(ai_node_priority_t), MEM_TAG_AI);
+		memcpy(heap, state->heap, state->heap_size * sizeof(ai_node_priority_t));
+
+		gi.Free(state->heap);
+
+		state->heap = heap;
+		state->heap_capacity *= 2;
+	}
+
+	ai_node_priority_t *heap = state->heap;
+
+	guint i = state->heap_size++;
+	while (i) {
+		const guint parent = (i - 1) >> 1;
+
+		if (heap[parent].priority <= entry.priority) {
+			break;
+		}
+
+		heap[i] = heap[parent];
+		i = parent;
+	}
+
+	heap[i] = entry;
+}
+
+/**
+ * @brief Pops the entry with the lowest priority from the open set.
+ */
+static ai_node_priority_t Ai_Path_Pop(ai_path_state_t *state) {
+
+	ai_node_priority_t *heap = state->heap;
+
+	const ai_node_priority_t top = heap[0];
+	const ai_node_priority_t last = heap[--state->heap_size];
+
+	const guint size = state->heap_size;
+
+	guint i = 0;
+	for (;;) {
+		guint child = (i << 1) + 1;
+
+		if (child >= size) {
+			break;
+		}
+
+		if (child + 1 < size && heap[child + 1].priority < heap[child].priority) {
+			child++;
+		}
+
+		if (last.priority <= heap[child].priority) {
+			break;
+		}
+
+		heap[i] = heap[child];
+		i = child;
+	}
+
+	if (size) {
+		heap[i] = last;
+	}
+
+	return top;
+}
+
 #define AI_NODE_MAGIC ('Q' | '2' << 8 | 'N' << 16 | 'S' << 24)
 #define AI_NODE_VERSION 2
 
@@ -1086,28 +1231,9 @@ void Ai_ShutdownNodes(void) {
 		g_array_free(ai_nodes, true);
 		ai_nodes = NULL;
 	}
-}
-
-typedef struct {
-	ai_node_id_t id;
-	float priority;
-} ai_node_priority_t;
-
-static inline float Ai_Link_Cost(const ai_node_id_t a, const ai_node_id_t b) {
-	const ai_node_t *node = &g_array_index(ai_nodes, ai_node_t, a);
-
-	assert(node->links);
-
-	for (guint i = 0; i < node->links->len; i++) {
-		const ai_link_t *link = &g_array_index(node->links, ai_link_t, i);
-
-		if (link->id == b) {
-			return link->cost;
-		}
-	}
 
-	assert(false);
-	return -1;
+	Ai_Path_FreeState();
+	ai_path_epoch++;
 }
 
 /**
@@ -1123,31 +1249,50 @@ GArray *Ai_Node_FindPath(const ai_node_id_t start, const ai_node_id_t end, const
 	if (start == AI_NODE_INVALID || end == AI_NODE_INVALID) {
 		return NULL;
 	}
-	
-	GHashTable *costs_started = g_hash_table_new(g_direct_hash, g_direct_equal);
-	GArray *queue = g_array_new(false, false, sizeof(ai_node_priority_t));
+
+	ai_path_state_t *state = Ai_Path_State();
+
+	const uint32_t generation = ++state->generation;
+
+	// the generation wrapped, so stamps from long ago may appear current
+	if (generation == 0) {
+		memset(state->generations, 0, state->num_nodes * sizeof(uint32_t));
+		return Ai_Node_FindPath(start, end, heuristic, length);
+	}
+
+	uint32_t *generations = state->generations;
+	float *costs = state->costs;
+	ai_node_id_t *came_from = state->came_from;
+
+	guint visited = 1;
 	bool finished = false;
 
-	g_array_append_vals(queue, &(ai_node_priority_t) {
+	generations[start] = generation;
+	costs[start] = 0;
+
+	state->heap_size = 0;
+
+	Ai_Path_Push(state, (ai_node_priority_t) {
 		.id = start,
+		.cost = 0,
 		.priority = 0
-	}, 1);
+	});
 
-	ai_node_t *start_node = &g_array_index(ai_nodes, ai_node_t, start);
-	start_node->cost = 0;
-	g_hash_table_add(costs_started, start_node);
+	while (state->heap_size) {
 
-	while (queue->len) {
-		
-		ai_node_priority_t current = g_array_index(queue, ai_node_priority_t, queue->len - 1);
-		queue = g_array_remove_index_fast(queue, queue->len - 1);
+		const ai_node_priority_t current = Ai_Path_Pop(state);
 
 		if (current.id == end) {
 			finished = true;
 			break;
 		}
 
-		ai_node_t *node = &g_array_index(ai_nodes, ai_node_t, current.id);
+		// a cheaper path to this node was found after this entry was pushed
+		if (current.cost > costs[current.id]) {
+			continue;
+		}
+
+		const ai_node_t *node = &g_array_index(ai_nodes, ai_node_t, current.id);
 
 		if (!node->links || !node->links->len) {
 			continue;
@@ -1155,86 +1300,97 @@ GArray *Ai_Node_FindPath(const ai_node_id_t start, const ai_node_id_t end, const
 
 		for (guint i = 0; i < node->links->len; i++) {
 			const ai_link_t *link = &g_array_index(node->links, ai_link_t, i);
-			ai_node_t *link_node = &g_array_index(ai_nodes, ai_node_t, link->id);
-			const float new_cost = node->cost + link->cost;
+			const float new_cost = current.cost + link->cost;
 
-			if (!g_hash_table_lookup(costs_started, link_node) || new_cost < link_node->cost) {
+			if (generations[link->id] != generation) {
+				generations[link->id] = generation;
+				visited++;
+			} else if (new_cost >= costs[link->id]) {
+				continue;
+			}
 
-				g_hash_table_add(costs_started, link_node);
+			costs[link->id] = new_cost;
+			came_from[link->id] = current.id;
 
-				link_node->cost = new_cost;
-				const float priority = new_cost + heuristic(link->id, end);
+			Ai_Path_Push(state, (ai_node_priority_t) {
+				.id = link->id,
+				.cost = new_cost,
+				.priority = new_cost + heuristic(link->id, end)
+			});
+		}
+	}
 
-				if (!queue->len) {
-					g_array_insert_vals(queue, 0, &(ai_node_priority_t) {
-						.id = link->id,
-						.priority = priority
-					}, 1);
-				} else {
-					for (gint x = queue->len - 1; ; x--) {
-
-						if (priority < g_array_index(queue, ai_node_priority_t, x).priority) {
-							g_array_insert_vals(queue, x + 1, &(ai_node_priority_t) {
-								.id = link->id,
-								.priority = priority
-							}, 1);
-							break;
-						}
+	GArray *return_path = NULL;
 
-						if (x == 0) {
-							g_array_insert_vals(queue, 0, &(ai_node_priority_t) {
-								.id = link->id,
-								.priority = priority
-							}, 1);
-							break;
-						}
-					}
-				}
+	if (finished) {
+		Ai_Debug("Found path from %u -> %u with %u nodes visited\n", start, end, visited);
 
-				link_node->came_from = Ai_Node_Index(node);
-			}
+		guint path_len = 1;
+		for (ai_node_id_t from = end; from != start; from = came_from[from]) {
+			path_len++;
 		}
+
+		return_path = g_array_sized_new(false, false, sizeof(ai_node_id_t), path_len);
+		g_array_set_size(return_path, path_len);
+
+		ai_node_id_t from = end;
+		for (guint i = path_len; i; i--) {
+			g_array_index(return_path, ai_node_id_t, i - 1) = from;
+			from = came_from[from];
+		}
+
+		if (length) {
+			*length = costs[end];
+		}
+	} else {
+		Ai_Debug("Couldn't find path from %u -> %u\n", start, end);
 	}
 
-	GArray *return_path = NULL;
+	return return_path;
+}
 
-	if (finished) {
-		Ai_Debug("Found path from %u -> %u with %u nodes visited\n", start, end, g_hash_table_size(costs_started));
+/**
+ * @brief Benchmarks path finding between random pairs of nodes on the loaded node graph.
+ */
+void Ai_BenchmarkPaths_f(void) {
 
-		return_path = g_array_sized_new(false, false, sizeof(ai_node_id_t), g_hash_table_size(costs_started));
+	if (!ai_nodes || !ai_nodes->len) {
+		gi.Print("No nodes loaded\n");
+		return;
+	}
 
-		g_array_prepend_val(return_path, end);
+	const int32_t count = gi.Argc() > 1 ? atoi(gi.Argv(1)) : 1000;
 
-		if (start != end) {
-			ai_node_id_t from = end;
+	GRand *rand = g_rand_new_with_seed(0);
 
-			for (;;) {
-				const ai_node_t *from_node = &g_array_index(ai_nodes, ai_node_t, from);
-				from = from_node->came_from;
-				g_array_prepend_val(return_path, from);
+	guint found = 0, nodes = 0;
+	float length = 0.f;
 
-				if (from == start) {
-					break;
-				}
-			}
+	const gint64 start = g_get_monotonic_time();
 
-			if (length) {
-				for (guint i = 0; i < return_path->len - 1; i++) {
-					const ai_node_id_t a = g_array_index(return_path, ai_node_id_t, i);
-					const ai_node_id_t b = g_array_index(return_path, ai_node_id_t, i + 1);
+	for (int32_t i = 0; i < count; i++) {
+		const ai_node_id_t a = g_rand_int_range(rand, 0, ai_nodes->len);
+		const ai_node_id_t b = g_rand_int_range(rand, 0, ai_nodes->len);
 
-					*length += Ai_Link_Cost(a, b);
-				}
-			}
+		float len;
+		GArray *path = Ai_Node_FindPath(a, b, Ai_Node_DefaultHeuristic, &len);
+
+		if (path) {
+			found++;
+			nodes += path->len;
+			length += len;
+			g_array_free(path, true);
 		}
-	} else {
-		Ai_Debug("Couldn't find path from %u -> %u\n", start, end);
 	}
 
-	g_array_free(queue, true);
-	g_hash_table_destroy(costs_started);
+	const gint64 elapsed = g_get_monotonic_time() - start;
 
-	return return_path;
+	g_rand_free(rand);
+
+	gi.Print("%d searches over %u nodes in %.2f ms (%.2f us per search)\n",
+			 count, ai_nodes->len, elapsed / 1000.0, count ? elapsed / (double) count : 0.0);
+	gi.Print("%u paths found, %.1f nodes and %.1f units on average\n",
+			 found, found ? nodes / (float) found : 0.f, found ? length / found : 0.f);
 }
 
 void Ai_OffsetNodes_f(void) {
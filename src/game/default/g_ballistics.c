@@ -974,8 +974,15 @@ static void G_BfgProjectile_Think(g_entity_t *self) {
 	const int32_t frame_damage = self->locals.damage * QUETOO_TICK_SECONDS;
 	const int32_t frame_knockback = self->locals.knockback * QUETOO_TICK_SECONDS;
 
-	g_entity_t *ent = NULL;
-	while ((ent = G_FindRadius(ent, self->s.origin, self->locals.damage_radius)) != NULL) {
+	g_entity_t *ents[MAX_ENTITIES];
+
+	const size_t len = gi.SphereEntities(self->s.origin, self->locals.damage_radius, ents, lengthof(ents), BOX_ALL);
+	for (size_t i = 0; i < len; i++) {
+		g_entity_t *ent = ents[i];
+
+		if (!ent->in_use) { // freed by prior damage
+			continue;
+		}
 
 		if (ent == self || ent == self->owner) {
 			continue;
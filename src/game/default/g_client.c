@@ -891,6 +891,7 @@ static void G_ClientRespawn_(g_entity_t *ent) {
 
 	if (ent->client->locals.persistent.spectator) { // spawn a spectator
 		ent->class_name = "spectator";
+		G_IndexEntity(ent);
 
 		ent->bounds = Box3_Zero();
 
@@ -908,6 +909,7 @@ static void G_ClientRespawn_(g_entity_t *ent) {
 		ent->client->locals.persistent.ready = false;
 	} else { // spawn an active client
 		ent->class_name = "client";
+		G_IndexEntity(ent);
 
 		ent->solid = SOLID_BOX;
 		ent->sv_flags = 0;
@@ -1361,6 +1363,8 @@ void G_ClientDisconnect(g_entity_t *ent) {
 
 	ent->class_name = "disconnected";
 	ent->in_use = false;
+
+	G_IndexEntity(ent);
 	ent->solid = SOLID_NOT;
 	ent->sv_flags = SVF_NO_CLIENT;
 
@@ -393,9 +393,15 @@ void G_Damage(g_entity_t *target, g_entity_t *inflictor, g_entity_t *attacker,
 void G_RadiusDamage(g_entity_t *inflictor, g_entity_t *attacker, g_entity_t *ignore, int32_t damage,
                     int32_t knockback, float radius, g_means_of_death mod) {
 
-	g_entity_t *ent = NULL;
+	g_entity_t *ents[MAX_ENTITIES];
 
-	while ((ent = G_FindRadius(ent, inflictor->s.origin, radius)) != NULL) {
+	const size_t len = gi.SphereEntities(inflictor->s.origin, radius, ents, lengthof(ents), BOX_ALL);
+	for (size_t i = 0; i < len; i++) {
+		g_entity_t *ent = ents[i];
+
+		if (!ent->in_use) { // freed by prior damage
+			continue;
+		}
 
 		if (ent == ignore) {
 			continue;
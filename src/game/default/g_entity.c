@@ -141,6 +141,8 @@ static bool G_SpawnEntity(g_entity_t *ent) {
 	ent->locals.command = gi.EntityValue(ent->def, "command")->nullable_string;
 	ent->locals.script = gi.EntityValue(ent->def, "script")->nullable_string;
 
+	G_IndexEntity(ent);
+
 	ent->locals.wait = gi.EntityValue(ent->def, "wait")->value;
 	ent->locals.delay = gi.EntityValue(ent->def, "delay")->value;
 	ent->locals.random = gi.EntityValue(ent->def, "random")->value;
@@ -660,6 +662,8 @@ void G_SpawnEntities(const char *name, cm_entity_t *const *entities, size_t num_
 
 	ge.num_entities = sv_max_clients->integer + 1;
 
+	G_ResetEntityIndex();
+
 	gchar **inhibit = g_strsplit(g_inhibit->string, " ", -1);
 	int32_t num_inhibited = 0;
 
@@ -789,6 +793,7 @@ static void G_worldspawn(g_entity_t *ent) {
 	ent->solid = SOLID_BSP;
 	ent->locals.move_type = MOVE_TYPE_NONE;
 	ent->in_use = true; // since the world doesn't use G_Spawn()
+	G_IndexEntity(ent);
 	ent->s.model1 = 0; // world model is always index 1
 
 	const g_map_list_map_t *map = G_MapList_Find(NULL, g_level.name);
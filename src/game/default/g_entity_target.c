@@ -172,6 +172,11 @@ void G_target_speaker(g_entity_t *ent) {
 		ent->s.sound = ent->locals.sound;
 	}
 
+	// unattenuated speakers are heard throughout the level
+	if (ent->locals.atten == SOUND_ATTEN_NONE) {
+		ent->sv_flags |= SVF_ALWAYS_SEND;
+	}
+
 	ent->locals.Use = G_target_speaker_Use;
 
 	// link the entity so the server can determine who to send updates to
@@ -818,6 +818,10 @@ g_entity_t *G_DropItem(g_entity_t *ent, const g_item_t *item) {
 
 	it->s.model1 = item->model_index;
 
+	if (item->type == ITEM_FLAG) {
+		it->sv_flags |= SVF_ALWAYS_SEND;
+	}
+
 	if (item->type == ITEM_WEAPON) {
 		const g_item_t *ammo = item->ammo_item;
 		if (ammo) {
@@ -1211,6 +1215,9 @@ void G_SpawnItem(g_entity_t *ent, const g_item_t *item) {
 	} else if (ent->locals.item->type == ITEM_FLAG) {
 		// pass flag tint over
 		ent->s.animation1 = item->tag;
+
+		// flags are objectives, and so are sent to all clients
+		ent->sv_flags |= SVF_ALWAYS_SEND;
 	}
 
 	ent->locals.next_think = g_level.time + QUETOO_TICK_MILLIS * 2;
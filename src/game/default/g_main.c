@@ -1582,6 +1582,8 @@ void G_Init(void) {
 		g_game.entities[i].client = g_game.clients + (i - 1);
 	}
 
+	G_InitEntityIndex();
+
 	G_Ai_Init(); // initialize the AI
 
 	G_MapList_Init();
@@ -1619,6 +1621,8 @@ void G_Shutdown(void) {
 	
 	G_Ai_Shutdown();
 
+	G_ShutdownEntityIndex();
+
 	gi.FreeTag(MEM_TAG_GAME_LEVEL);
 	gi.FreeTag(MEM_TAG_GAME);
 }
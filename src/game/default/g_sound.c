@@ -69,7 +69,8 @@ static void G_Sound(const g_play_sound_t *play) {
 }
 
 /**
- * @brief
+ * @brief Multicasts the sound. Sounds without an origin or attenuation are heard
+ * everywhere, and are therefore sent to all clients.
  */
 void G_MulticastSound(const g_play_sound_t *play, multicast_t to, EntityFilterFunc filter) {
 	vec3_t from = Vec3_Zero();
@@ -84,6 +85,21 @@ void G_MulticastSound(const g_play_sound_t *play, multicast_t to, EntityFilterFu
 		from = *play->origin;
 	}
 
+	if ((!play->entity && !play->origin) || play->atten == SOUND_ATTEN_NONE) {
+		switch (to) {
+			case MULTICAST_PHS:
+			case MULTICAST_PVS:
+				to = MULTICAST_ALL;
+				break;
+			case MULTICAST_PHS_R:
+			case MULTICAST_PVS_R:
+				to = MULTICAST_ALL_R;
+				break;
+			default:
+				break;
+		}
+	}
+
 	gi.Multicast(from, to, filter);
 }
 
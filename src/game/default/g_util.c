@@ -106,6 +106,191 @@ void G_InitProjectile(const g_entity_t *ent, vec3_t *forward, vec3_t *right, vec
 	}
 }
 
+/**
+ * @brief Freed entity slots are not reused until this many milliseconds have
+ * passed, so that clients do not interpolate a new entity from an old one.
+ */
+#define G_ENTITY_REUSE_DELAY 500
+
+/**
+ * @brief The free list and name index bookkeeping for a single entity slot.
+ */
+typedef struct {
+	uint16_t next_free;
+	uint32_t free_time;
+	GArray *class_name;
+	GArray *target_name;
+} g_entity_index_entry_t;
+
+/**
+ * @brief The entity free list and name indexes, which spare G_AllocEntity and
+ * G_Find from walking the entity array.
+ */
+typedef struct {
+	g_entity_index_entry_t *entries; // [g_max_entities]
+
+	uint16_t free_head, free_tail; // 0 when empty, as the world is never freed
+
+	GHashTable *class_names; // case-insensitive name to sorted entity numbers
+	GHashTable *target_names;
+} g_entity_index_t;
+
+static g_entity_index_t g_entity_index;
+
+/**
+ * @brief Case-insensitive GHashFunc for entity names.
+ */
+static guint G_EntityIndex_Hash(gconstpointer key) {
+
+	guint hash = 5381;
+	for (const char *s = key; *s; s++) {
+		hash = hash * 33 + g_ascii_tolower(*s);
+	}
+
+	return hash;
+}
+
+/**
+ * @brief Case-insensitive GEqualFunc for entity names.
+ */
+static gboolean G_EntityIndex_Equal(gconstpointer a, gconstpointer b) {
+	return g_ascii_strcasecmp(a, b) == 0;
+}
+
+/**
+ * @brief GDestroyNotify for entity name buckets.
+ */
+static void G_EntityIndex_FreeBucket(gpointer data) {
+	g_array_free(data, true);
+}
+
+/**
+ * @return The index of the first entity number in `bucket` greater than `number`.
+ */
+static guint G_EntityIndex_Search(const GArray *bucket, uint16_t number) {
+
+	guint lo = 0, hi = bucket->len;
+	while (lo < hi) {
+		const guint mid = (lo + hi) / 2;
+		if (g_array_index(bucket, uint16_t, mid) <= number) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+/**
+ * @brief Inserts the entity number into the bucket for `name`.
+ */
+static GArray *G_EntityIndex_Insert(GHashTable *table, const char *name, uint16_t number) {
+
+	GArray *bucket = g_hash_table_lookup(table, name);
+	if (!bucket) {
+		bucket = g_array_new(false, false, sizeof(uint16_t));
+		g_hash_table_insert(table, g_strdup(name), bucket);
+	}
+
+	g_array_insert_val(bucket, G_EntityIndex_Search(bucket, number), number);
+	return bucket;
+}
+
+/**
+ * @brief Removes the entity number from the specified bucket.
+ */
+static void G_EntityIndex_Remove(GArray *bucket, uint16_t number) {
+
+	const guint i = G_EntityIndex_Search(bucket, number);
+	if (i && g_array_index(bucket, uint16_t, i - 1) == number) {
+		g_array_remove_index(bucket, i - 1);
+	}
+}
+
+/**
+ * @brief Allocates the entity index. This is called once the entities are allocated.
+ */
+void G_InitEntityIndex(void) {
+
+	g_entity_index.entries = gi.Malloc(g_max_entities->integer * sizeof(g_entity_index_entry_t), MEM_TAG_GAME);
+
+	g_entity_index.class_names = g_hash_table_new_full(G_EntityIndex_Hash, G_EntityIndex_Equal, g_free, G_EntityIndex_FreeBucket);
+	g_entity_index.target_names = g_hash_table_new_full(G_EntityIndex_Hash, G_EntityIndex_Equal, g_free, G_EntityIndex_FreeBucket);
+}
+
+/**
+ * @brief Empties the entity index. This is called whenever the entities are cleared.
+ */
+void G_ResetEntityIndex(void) {
+
+	memset(g_entity_index.entries, 0, g_max_entities->integer * sizeof(g_entity_index_entry_t));
+
+	g_entity_index.free_head = g_entity_index.free_tail = 0;
+
+	g_hash_table_remove_all(g_entity_index.class_names);
+	g_hash_table_remove_all(g_entity_index.target_names);
+}
+
+/**
+ * @brief Frees the entity index.
+ */
+void G_ShutdownEntityIndex(void) {
+
+	if (g_entity_index.class_names) {
+		g_hash_table_destroy(g_entity_index.class_names);
+	}
+
+	if (g_entity_index.target_names) {
+		g_hash_table_destroy(g_entity_index.target_names);
+	}
+
+	memset(&g_entity_index, 0, sizeof(g_entity_index));
+}
+
+/**
+ * @brief Removes the entity from the name indexes.
+ */
+static void G_UnindexEntity(const g_entity_t *ent) {
+
+	const uint16_t number = (uint16_t) (ent - g_game.entities);
+	g_entity_index_entry_t *entry = &g_entity_index.entries[number];
+
+	if (entry->class_name) {
+		G_EntityIndex_Remove(entry->class_name, number);
+		entry->class_name = NULL;
+	}
+
+	if (entry->target_name) {
+		G_EntityIndex_Remove(entry->target_name, number);
+		entry->target_name = NULL;
+	}
+}
+
+/**
+ * @brief Updates the name indexes to reflect the entity's current `class_name` and
+ * `target_name`. This must be called whenever either is assigned.
+ */
+void G_IndexEntity(g_entity_t *ent) {
+
+	G_UnindexEntity(ent);
+
+	if (!ent->in_use) {
+		return;
+	}
+
+	const uint16_t number = (uint16_t) (ent - g_game.entities);
+	g_entity_index_entry_t *entry = &g_entity_index.entries[number];
+
+	if (ent->class_name) {
+		entry->class_name = G_EntityIndex_Insert(g_entity_index.class_names, ent->class_name, number);
+	}
+
+	if (ent->locals.target_name) {
+		entry->target_name = G_EntityIndex_Insert(g_entity_index.target_names, ent->locals.target_name, number);
+	}
+}
+
 /**
  * @brief Searches all active entities for the next one that holds the matching string
  * at field offset (use the ELOFS() macro) in the structure.
@@ -113,13 +298,46 @@ void G_InitProjectile(const g_entity_t *ent, vec3_t *forward, vec3_t *right, vec
  * Searches beginning at the entity after from, or the beginning if NULL
  * NULL will be returned if the end of the list is reached.
  *
+ * Searches on `class_name` and `target_name` are resolved through the entity
+ * index, and are proportional to the number of matching entities.
+ *
  * Example:
  *   G_Find(NULL, EOFS(class_name), "info_player_deathmatch");
  *
  */
 g_entity_t *G_Find(g_entity_t *from, ptrdiff_t field, const char *match) {
+	GHashTable *table = NULL;
 	char *s;
 
+	if (field == EOFS(class_name)) {
+		table = g_entity_index.class_names;
+	} else if (field == LOFS(target_name)) {
+		table = g_entity_index.target_names;
+	}
+
+	if (table) {
+		const GArray *bucket = g_hash_table_lookup(table, match);
+		if (!bucket) {
+			return NULL;
+		}
+
+		guint i = 0;
+		if (from) {
+			i = G_EntityIndex_Search(bucket, (uint16_t) (from - g_game.entities));
+		}
+
+		for (; i < bucket->len; i++) {
+			g_entity_t *ent = &g_game.entities[g_array_index(bucket, uint16_t, i)];
+
+			s = *(char **) ((byte *) ent + field);
+			if (ent->in_use && s && !g_ascii_strcasecmp(s, match)) {
+				return ent;
+			}
+		}
+
+		return NULL;
+	}
+
 	if (!from) {
 		from = g_game.entities;
 	} else {
@@ -178,41 +396,6 @@ g_entity_t *G_FindPtr(g_entity_t *from, ptrdiff_t field, const void *match) {
 	return NULL;
 }
 
-/**
- * @brief Returns entities that have origins within a spherical radius.
- */
-g_entity_t *G_FindRadius(g_entity_t *from, const vec3_t org, float rad) {
-
-	if (!from) {
-		from = g_game.entities;
-	} else {
-		from++;
-	}
-
-	for (; from < &g_game.entities[ge.num_entities]; from++) {
-
-		if (!from->in_use) {
-			continue;
-		}
-
-		if (from->solid == SOLID_NOT) {
-			continue;
-		}
-
-		if (Vec3_Distance(org, from->abs_bounds.mins) < rad) {
-			return from;
-		}
-
-		if (Vec3_Distance(org, from->abs_bounds.maxs) < rad) {
-			return from;
-		}
-
-		return from;
-	}
-
-	return NULL;
-}
-
 #define MAX_TARGETS	8
 
 /**
@@ -357,6 +540,8 @@ void G_SetMoveDir(g_entity_t *ent) {
  */
 void G_ClearEntity(g_entity_t *ent) {
 
+	G_UnindexEntity(ent);
+
 	g_client_t *client = ent->client;
 
 	memset(ent, 0, sizeof(*ent));
@@ -380,44 +565,82 @@ void G_InitEntity(g_entity_t *ent, const char *class_name) {
 	ent->locals.timestamp = g_level.time;
 	ent->s.number = ent - g_game.entities;
 	ent->s.spawn_id = g_spawn_id++;
+
+	G_IndexEntity(ent);
 }
 
 /**
- * @brief Allocates an entity for use.
+ * @return True if the free entity at the head of the free list may be reused.
  */
-g_entity_t *G_AllocEntity_(const char *class_name) {
-	uint16_t i;
+static bool G_EntityReusable(uint16_t number) {
 
-	g_entity_t *e = &g_game.entities[sv_max_clients->integer + 1];
-	for (i = sv_max_clients->integer + 1; i < ge.num_entities; i++, e++) {
-		if (!e->in_use) {
-			G_InitEntity(e, class_name);
-			return e;
-		}
+	const uint32_t free_time = g_entity_index.entries[number].free_time;
+
+	// the first couple of seconds of a level free and allocate a lot, so relax
+	if (free_time < 2000) {
+		return true;
 	}
 
-	if (i >= g_max_entities->value) {
-		gi.Error("No free entities for %s\n", class_name);
+	return g_level.time - free_time >= G_ENTITY_REUSE_DELAY;
+}
+
+/**
+ * @brief Allocates an entity for use. Freed entities are reused in the order
+ * they were freed, once they have been free for G_ENTITY_REUSE_DELAY.
+ */
+g_entity_t *G_AllocEntity_(const char *class_name) {
+	g_entity_t *ent;
+
+	const uint16_t number = g_entity_index.free_head;
+
+	if (number && (G_EntityReusable(number) || ge.num_entities >= g_max_entities->integer)) {
+		g_entity_index.free_head = g_entity_index.entries[number].next_free;
+		if (g_entity_index.free_head == 0) {
+			g_entity_index.free_tail = 0;
+		}
+		ent = &g_game.entities[number];
+	} else {
+		if (ge.num_entities >= g_max_entities->integer) {
+			gi.Error("No free entities for %s\n", class_name);
+		}
+		ent = &g_game.entities[ge.num_entities++];
 	}
 
-	ge.num_entities++;
-	G_InitEntity(e, class_name);
-	return e;
+	G_InitEntity(ent, class_name);
+	return ent;
 }
 
 /**
- * @brief Frees the specified entity.
+ * @brief Frees the specified entity, appending it to the free list.
  */
 void G_FreeEntity(g_entity_t *ent) {
 
 	gi.UnlinkEntity(ent);
 
-	if ((ent - g_game.entities) <= sv_max_clients->integer) {
+	const uint16_t number = (uint16_t) (ent - g_game.entities);
+	if (number <= sv_max_clients->integer) {
+		return;
+	}
+
+	if (!ent->in_use) { // already free
 		return;
 	}
 
 	G_ClearEntity(ent);
 	ent->class_name = "free";
+
+	g_entity_index_entry_t *entry = &g_entity_index.entries[number];
+
+	entry->next_free = 0;
+	entry->free_time = g_level.time;
+
+	if (g_entity_index.free_tail) {
+		g_entity_index.entries[g_entity_index.free_tail].next_free = number;
+	} else {
+		g_entity_index.free_head = number;
+	}
+
+	g_entity_index.free_tail = number;
 }
 
 /**
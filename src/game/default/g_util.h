@@ -30,9 +30,12 @@ void G_Explode(g_entity_t *ent, int16_t damage, int16_t knockback, float radius,
 void G_Gib(g_entity_t *ent);
 void G_InitPlayerSpawn(g_entity_t *ent);
 void G_InitProjectile(const g_entity_t *ent, vec3_t *forward, vec3_t *right, vec3_t *up, vec3_t *org, float hand);
+void G_InitEntityIndex(void);
+void G_ResetEntityIndex(void);
+void G_ShutdownEntityIndex(void);
+void G_IndexEntity(g_entity_t *ent);
 g_entity_t *G_Find(g_entity_t *from, ptrdiff_t field, const char *match);
 g_entity_t *G_FindPtr(g_entity_t *from, ptrdiff_t field, const void *match);
-g_entity_t *G_FindRadius(g_entity_t *from, const vec3_t org, float rad);
 g_entity_t *G_PickTarget(const char *target_name);
 void G_UseTargets(g_entity_t *ent, g_entity_t *activator);
 void G_SetMoveDir(g_entity_t *ent);
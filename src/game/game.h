@@ -24,13 +24,14 @@
 #include "shared/shared.h"
 #include "collision/cm_types.h"
 
-#define GAME_API_VERSION 13
+#define GAME_API_VERSION 15
 
 /**
  * @brief Server flags for g_entity_t.
  */
 #define SVF_NO_CLIENT 		(1 << 0) // don't send entity to clients
-#define SVF_GAME			(1 << 1) // game may extend from here
+#define SVF_ALWAYS_SEND		(1 << 1) // send entity to clients regardless of visibility
+#define SVF_GAME			(1 << 2) // game may extend from here
 
 /**
  * @brief Filter bits to Sv_BoxEntities / gi.BoxEntities.
@@ -615,6 +616,20 @@ typedef struct g_import_s {
 	 */
 	size_t (*BoxEntities)(const box3_t bounds, g_entity_t **list, const size_t len, uint32_t type);
 
+	/**
+	 * @brief Populates a list of entities whose bounding boxes intersect the
+	 * specified sphere, filtered by the given type (BOX_SOLID, BOX_TRIGGER, ..).
+	 *
+	 * @param origin The sphere origin in world space.
+	 * @param radius The sphere radius.
+	 * @param list The list of entities to populate.
+	 * @param len The maximum number of entities to return (lengthof(list)).
+	 * @param type The entity type to return (BOX_SOLID, BOX_TRIGGER, ..).
+	 *
+	 * @return The number of entities found.
+	 */
+	size_t (*SphereEntities)(const vec3_t origin, float radius, g_entity_t **list, const size_t len, uint32_t type);
+
 	/**
 	 * @}
 	 * @defgroup network Network messaging.
@@ -630,7 +645,7 @@ typedef struct g_import_s {
 	void (*WriteString)(const char *s);
 	void (*WriteVector)(const float v);
 	void (*WritePosition)(const vec3_t pos);
-	void (*WriteDir)(const vec3_t pos); // single byte encoded, very coarse
+	void (*WriteDir)(const vec3_t pos); // 16 bit octahedral encoding, to within about a degree
 	void (*WriteAngle)(const float v);
 	void (*WriteAngles)(const vec3_t angles);
 
@@ -251,7 +251,8 @@ static void MemStats_f(void) {
 		const char *tag_name;
 
 		if (stat_i->tag == -1) {
-			Com_Print("total: %" PRIuPTR " bytes\n", stat_i->size);
+			Com_Print("total: %" PRIuPTR " bytes - %" PRIuPTR " blocks - peak %" PRIuPTR " bytes - %.0f allocs/s\n",
+					  stat_i->size, stat_i->count, stat_i->peak, stat_i->rate);
 			reported_total = stat_i->size;
 			continue;
 		} else if (stat_i->tag < MEM_TAG_TOTAL) {
@@ -260,7 +261,8 @@ static void MemStats_f(void) {
 			tag_name = va("#%d", stat_i->tag);
 		}
 
-		Com_Print(" [%s] %" PRIuPTR " bytes - %" PRIuPTR " blocks\n", tag_name, stat_i->size, stat_i->count);
+		Com_Print(" [%s] %" PRIuPTR " bytes - %" PRIuPTR " blocks - %.0f allocs/s\n",
+				  tag_name, stat_i->size, stat_i->count, stat_i->rate);
 		sum += stat_i->size;
 	}
 
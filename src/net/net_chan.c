@@ -25,12 +25,27 @@
  *
  * packet header
  * -------------
- * 31	sequence
+ * 30	sequence
+ * 1	is this packet a fragment of a larger message
  * 1	does this message contain a reliable payload
  * 31	acknowledge sequence
  * 1	acknowledge receipt of even/odd message
  * 8	qport
  *
+ * fragment header
+ * ---------------
+ * 16	offset of this fragment within the message
+ * 16	length of this fragment
+ *
+ * Messages which would exceed MAX_MSG_SIZE_UDP are split into fragments of
+ * MAX_FRAGMENT_SIZE, all sharing the message's sequence number. The final
+ * fragment is shorter than MAX_FRAGMENT_SIZE, and may be empty. Messages of up
+ * to MAX_MSG_SIZE_FRAGMENTED may be sent this way, even over the loopback. The
+ * receiver copies fragments to their offset as they arrive, in any order, and
+ * discards the message should a fragment of a newer message arrive before it is
+ * complete. A lost fragment is therefore equivalent to a lost packet: the
+ * reliable payload, if any, is retransmitted as usual.
+ *
  * The remote connection never knows if it missed a reliable message, the
  * local side detects that it has been dropped by seeing a sequence acknowledge
  * higher than the last reliable sequence, but without the correct even/odd
@@ -78,7 +93,7 @@ static cvar_t *net_show_drop;
 
 net_addr_t net_from;
 mem_buf_t net_message;
-static byte net_message_buffer[MAX_MSG_SIZE];
+static byte net_message_buffer[MAX_MSG_SIZE_FRAGMENTED];
 
 /**
  * @brief Sends an out-of-band datagram
@@ -147,6 +162,42 @@ static bool Netchan_CheckRetransmit(net_chan_t *chan) {
 	return false;
 }
 
+#define FRAGMENT_BIT (1u << 30)
+
+/**
+ * @brief Sends the payload of the assembled message as a series of fragments.
+ */
+static void Netchan_TransmitFragments(net_chan_t *chan, uint32_t w1, uint32_t w2, const byte *payload, size_t size) {
+	mem_buf_t frag;
+	byte frag_buffer[MAX_MSG_SIZE_UDP];
+
+	size_t offset = 0;
+	while (true) {
+		const size_t length = Mini((int32_t) (size - offset), MAX_FRAGMENT_SIZE);
+
+		Mem_InitBuffer(&frag, frag_buffer, sizeof(frag_buffer));
+
+		Net_WriteLong(&frag, w1 | FRAGMENT_BIT);
+		Net_WriteLong(&frag, w2);
+
+		if (chan->source == NS_UDP_CLIENT) {
+			Net_WriteByte(&frag, chan->qport);
+		}
+
+		Net_WriteShort(&frag, (int32_t) offset);
+		Net_WriteShort(&frag, (int32_t) length);
+		Mem_WriteBuffer(&frag, payload + offset, length);
+
+		Net_SendDatagram(chan->source, &chan->remote_address, frag.data, frag.size);
+
+		offset += length;
+
+		if (length < MAX_FRAGMENT_SIZE) {
+			break;
+		}
+	}
+}
+
 /**
  * @brief Tries to send an unreliable message to a connection, and handles the
  * transmission / retransmission of the reliable messages.
@@ -155,7 +206,7 @@ static bool Netchan_CheckRetransmit(net_chan_t *chan) {
  */
 void Netchan_Transmit(net_chan_t *chan, byte *data, size_t len) {
 	mem_buf_t send;
-	byte send_buffer[MAX_MSG_SIZE];
+	byte send_buffer[MAX_MSG_SIZE_FRAGMENTED];
 
 	// check for message overflow
 	if (chan->message.overflowed) {
@@ -177,7 +228,7 @@ void Netchan_Transmit(net_chan_t *chan, byte *data, size_t len) {
 	// write the packet header
 	Mem_InitBuffer(&send, send_buffer, sizeof(send_buffer));
 
-	const uint32_t w1 = (chan->outgoing_sequence & ~(1u << 31)) | (send_reliable << 31);
+	const uint32_t w1 = (chan->outgoing_sequence & ~(3u << 30)) | (send_reliable << 31);
 	const uint32_t w2 = (chan->incoming_sequence & ~(1u << 31)) | (chan->reliable_incoming << 31);
 
 	chan->outgoing_sequence++;
@@ -204,8 +255,13 @@ void Netchan_Transmit(net_chan_t *chan, byte *data, size_t len) {
 		Com_Warn("Netchan_Transmit: dumped unreliable\n");
 	}
 
-	// send the datagram
-	Net_SendDatagram(chan->source, &chan->remote_address, send.data, send.size);
+	// send the datagram, fragmenting it if it would not fit in a single packet
+	if (send.size > (chan->remote_address.type == NA_LOOP ? MAX_MSG_SIZE : MAX_MSG_SIZE_UDP)) {
+		const size_t header_size = chan->source == NS_UDP_CLIENT ? 9 : 8;
+		Netchan_TransmitFragments(chan, w1, w2, send.data + header_size, send.size - header_size);
+	} else {
+		Net_SendDatagram(chan->source, &chan->remote_address, send.data, send.size);
+	}
 
 	if (net_show_packets->value) {
 		if (send_reliable)
@@ -218,6 +274,75 @@ void Netchan_Transmit(net_chan_t *chan, byte *data, size_t len) {
 	}
 }
 
+/**
+ * @brief Clears the fragments received for the message being reassembled.
+ */
+static void Netchan_ClearFragments(net_chan_t *chan) {
+
+	chan->fragment_received = 0;
+	chan->fragment_count = 0;
+	chan->fragment_size = 0;
+}
+
+/**
+ * @brief Accumulates the fragment at the current read position of `msg`. Once all of
+ * the fragments have arrived, `msg` is rewritten to contain the packet header followed
+ * by the reassembled message, as if it had been received in a single packet.
+ * @return True if the message is complete, false otherwise.
+ */
+static bool Netchan_ProcessFragment(net_chan_t *chan, mem_buf_t *msg, uint32_t sequence) {
+
+	const size_t header_size = msg->read;
+
+	const size_t offset = (uint16_t) Net_ReadShort(msg);
+	const size_t length = (uint16_t) Net_ReadShort(msg);
+
+	// a fragment of a newer message abandons the one being reassembled
+	if (sequence < chan->fragment_sequence) {
+		if (net_show_drop->value)
+			Com_Print("%s:Dropped fragment %u of %i at %i\n", Net_NetaddrToString(&chan->remote_address),
+			          (uint32_t) offset, sequence, chan->fragment_sequence);
+		return false;
+	}
+
+	if (sequence > chan->fragment_sequence) {
+		chan->fragment_sequence = sequence;
+		Netchan_ClearFragments(chan);
+	}
+
+	if (offset % MAX_FRAGMENT_SIZE || length > MAX_FRAGMENT_SIZE || msg->read + length > msg->size ||
+	        offset + length > sizeof(chan->fragment_buffer) || header_size + offset + length > msg->max_size) {
+		Com_Debug(DEBUG_NET, "%s: Illegal fragment\n", Net_NetaddrToString(&chan->remote_address));
+		Netchan_ClearFragments(chan);
+		return false;
+	}
+
+	const uint32_t index = (uint32_t) (offset / MAX_FRAGMENT_SIZE);
+
+	memcpy(chan->fragment_buffer + offset, msg->data + msg->read, length);
+	chan->fragment_received |= 1ull << index;
+
+	// the final fragment is short, and so reveals the size of the message
+	if (length < MAX_FRAGMENT_SIZE) {
+		chan->fragment_count = index + 1;
+		chan->fragment_size = offset + length;
+	}
+
+	const uint64_t fragments = (1ull << chan->fragment_count) - 1;
+
+	if (chan->fragment_count == 0 || (chan->fragment_received & fragments) != fragments) {
+		return false; // wait for the rest
+	}
+
+	memcpy(msg->data + header_size, chan->fragment_buffer, chan->fragment_size);
+
+	msg->size = header_size + chan->fragment_size;
+	msg->read = header_size;
+
+	Netchan_ClearFragments(chan);
+	return true;
+}
+
 /**
  * @brief Called when the current net_message is from remote_address
  * modifies net_message so that it points to the packet payload
@@ -240,7 +365,9 @@ bool Netchan_Process(net_chan_t *chan, mem_buf_t *msg) {
 	reliable_message = sequence >> 31u;
 	reliable_ack = sequence_ack >> 31u;
 
-	sequence &= ~(1u << 31);
+	const bool fragment = sequence & FRAGMENT_BIT;
+
+	sequence &= ~(3u << 30);
 	sequence_ack &= ~(1u << 31);
 
 	if (net_show_packets->value) {
@@ -260,6 +387,13 @@ bool Netchan_Process(net_chan_t *chan, mem_buf_t *msg) {
 		return false;
 	}
 
+	// fragments are accumulated until the message is complete
+	if (fragment) {
+		if (!Netchan_ProcessFragment(chan, msg, sequence)) {
+			return false;
+		}
+	}
+
 	// dropped packets don't keep the message from being used
 	chan->dropped = sequence - (chan->incoming_sequence + 1);
 	if (chan->dropped > 0) {
@@ -77,6 +77,20 @@ void Net_WriteLong(mem_buf_t *msg, int32_t c) {
 	buf[3] = c >> 24;
 }
 
+/**
+ * @brief Writes an unsigned integer in 7 bit groups, least significant first, so
+ * that small values occupy a single byte.
+ */
+void Net_WriteVarLong(mem_buf_t *msg, uint32_t c) {
+
+	while (c >= 0x80) {
+		Net_WriteByte(msg, (c & 0x7f) | 0x80);
+		c >>= 7;
+	}
+
+	Net_WriteByte(msg, c);
+}
+
 /**
  * @brief
  */
@@ -110,19 +124,25 @@ void Net_WritePosition(mem_buf_t *msg, const vec3_t pos) {
 }
 
 /**
- * @brief
+ * @return The quantized `angle`, as sent by Net_WriteAngle.
+ * @remarks The angle is wrapped to [0, 360) first, so that equivalent angles quantize alike.
  */
-void Net_WriteAngle(mem_buf_t *msg, float angle) {
+static uint16_t Net_QuantizeAngle(float angle) {
 
-	while (angle < 0.f) {
+	angle = fmodf(angle, 360.f);
+
+	if (angle < 0.f) {
 		angle += 360.f;
 	}
 
-	while (angle > 360.f) {
-		angle -= 360.f;
-	}
+	return (uint16_t) (uint32_t) ((angle / 360.f) * UINT16_MAX);
+}
 
-	Net_WriteShort(msg, (int16_t) ((angle / 360.0f) * UINT16_MAX));
+/**
+ * @brief
+ */
+void Net_WriteAngle(mem_buf_t *msg, float angle) {
+	Net_WriteShort(msg, Net_QuantizeAngle(angle));
 }
 
 /**
@@ -135,21 +155,69 @@ void Net_WriteAngles(mem_buf_t *msg, const vec3_t angles) {
 }
 
 /**
- * @brief
+ * @return The point on the octahedron for the coordinates `u` and `v`, in -127..127.
+ */
+static vec3_t Net_Octahedron(int32_t u, int32_t v) {
+
+	vec3_t dir = Vec3(u / 127.f, v / 127.f, 0.f);
+
+	dir.z = 1.f - fabsf(dir.x) - fabsf(dir.y);
+
+	if (dir.z < 0.f) {
+		const float x = dir.x;
+		dir.x = (1.f - fabsf(dir.y)) * (x >= 0.f ? 1.f : -1.f);
+		dir.y = (1.f - fabsf(x)) * (dir.y >= 0.f ? 1.f : -1.f);
+	}
+
+	return dir;
+}
+
+/**
+ * @brief Writes the unit vector `dir` in 16 bits, by projecting it onto an octahedron
+ * and unfolding that to a square. Of the four nearest points on the square, the one
+ * closest to `dir` is sent. Axial directions are represented exactly.
  */
 void Net_WriteDir(mem_buf_t *msg, const vec3_t dir) {
-	int32_t i, best = 0;
-	float best_d = 0.0;
 
-	for (i = 0; i < NUM_APPROXIMATE_NORMALS; i++) {
-		const float d = Vec3_Dot(dir, approximate_normals[i]);
+	const float l1 = fabsf(dir.x) + fabsf(dir.y) + fabsf(dir.z);
+
+	if (l1 == 0.f) { // the center of the square is up
+		Net_WriteByte(msg, 0);
+		Net_WriteByte(msg, 0);
+		return;
+	}
+
+	float u = dir.x / l1, v = dir.y / l1;
+
+	if (dir.z < 0.f) {
+		const float x = u;
+		u = (1.f - fabsf(v)) * (x >= 0.f ? 1.f : -1.f);
+		v = (1.f - fabsf(x)) * (v >= 0.f ? 1.f : -1.f);
+	}
+
+	u *= 127.f;
+	v *= 127.f;
+
+	int32_t best_u = 0, best_v = 0;
+	float best_d = -FLT_MAX;
+
+	for (int32_t i = 0; i < 4; i++) {
+		const int32_t iu = Clampf((i & 1) ? ceilf(u) : floorf(u), -127.f, 127.f);
+		const int32_t iv = Clampf((i & 2) ? ceilf(v) : floorf(v), -127.f, 127.f);
+
+		// compare the squared cosines, sparing the normalization of each candidate
+		const vec3_t p = Net_Octahedron(iu, iv);
+		const float dot = Vec3_Dot(dir, p);
+		const float d = dot * fabsf(dot) / Vec3_LengthSquared(p);
 		if (d > best_d) {
 			best_d = d;
-			best = i;
+			best_u = iu;
+			best_v = iv;
 		}
 	}
 
-	Net_WriteByte(msg, best);
+	Net_WriteByte(msg, (int8_t) best_u);
+	Net_WriteByte(msg, (int8_t) best_v);
 }
 
 /**
@@ -170,6 +238,148 @@ void Net_WriteBounds(mem_buf_t *msg, const box3_t bounds) {
 	Net_WriteShort(msg, _maxs.z);
 }
 
+/**
+ * @brief Begins reading or writing a bit stream at the current position of `msg`.
+ */
+void Net_BeginBits(net_bits_t *stream, mem_buf_t *msg) {
+
+	stream->msg = msg;
+	stream->value = 0;
+	stream->count = 0;
+}
+
+/**
+ * @brief Writes the low `count` bits of `value` to the bit stream.
+ */
+void Net_WriteBits(net_bits_t *stream, uint32_t value, uint32_t count) {
+
+	assert(count <= 32);
+
+	stream->value |= (uint64_t) (value & (uint32_t) ((1ull << count) - 1)) << stream->count;
+	stream->count += count;
+
+	while (stream->count >= 8) {
+		Net_WriteByte(stream->msg, (int32_t) (stream->value & 0xff));
+		stream->value >>= 8;
+		stream->count -= 8;
+	}
+}
+
+/**
+ * @brief Writes any pending bits, padding the bit stream to a byte boundary.
+ */
+void Net_FlushBits(net_bits_t *stream) {
+
+	if (stream->count) {
+		Net_WriteByte(stream->msg, (int32_t) (stream->value & 0xff));
+	}
+
+	stream->value = 0;
+	stream->count = 0;
+}
+
+/**
+ * @return The quantized vector component `f` at the specified fixed-point scale.
+ */
+static int32_t Net_Quantize(float f, float scale) {
+	const float max = (float) ((1 << (NET_VECTOR_BITS - 1)) - 1);
+	return (int32_t) Clampf(roundf(f * scale), -max, max);
+}
+
+/**
+ * @return True if `a` and `b` quantize to the same vector.
+ */
+static bool Net_QuantizedEqual(const vec3_t a, const vec3_t b, float scale) {
+
+	for (int32_t i = 0; i < 3; i++) {
+		if (Net_Quantize(a.xyz[i], scale) != Net_Quantize(b.xyz[i], scale)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @return True if `a` and `b` quantize to the same angles.
+ */
+static bool Net_QuantizedAnglesEqual(const vec3_t a, const vec3_t b) {
+
+	for (int32_t i = 0; i < 3; i++) {
+		if (Net_QuantizeAngle(a.xyz[i]) != Net_QuantizeAngle(b.xyz[i])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief Writes the quantized vector `to` relative to `from`. Each component is
+ * prefixed by a code: 0 for unchanged, 10 for a small delta of `delta_bits`, and
+ * 11 for the full quantized value.
+ */
+static void Net_WriteDeltaVector(net_bits_t *stream, const vec3_t from, const vec3_t to,
+								 float scale, uint32_t delta_bits) {
+
+	const int32_t max_delta = (1 << (delta_bits - 1)) - 1;
+
+	for (int32_t i = 0; i < 3; i++) {
+		const int32_t a = Net_Quantize(from.xyz[i], scale);
+		const int32_t b = Net_Quantize(to.xyz[i], scale);
+
+		const int32_t delta = b - a;
+
+		if (delta == 0) {
+			Net_WriteBits(stream, 0, 1);
+		} else if (delta >= -max_delta && delta <= max_delta) {
+			Net_WriteBits(stream, 1, 2);
+			Net_WriteBits(stream, (uint32_t) delta, delta_bits);
+		} else {
+			Net_WriteBits(stream, 3, 2);
+			Net_WriteBits(stream, (uint32_t) b, NET_VECTOR_BITS);
+		}
+	}
+}
+
+/**
+ * @brief Writes the vector `to` at full precision, prefixing each component with
+ * a changed bit.
+ */
+static void Net_WriteDeltaPosition(net_bits_t *stream, const vec3_t from, const vec3_t to) {
+
+	for (int32_t i = 0; i < 3; i++) {
+		const net_float component = {
+			.v = to.xyz[i]
+		};
+
+		if (component.v == from.xyz[i]) {
+			Net_WriteBits(stream, 0, 1);
+		} else {
+			Net_WriteBits(stream, 1, 1);
+			Net_WriteBits(stream, (uint32_t) component.i, 32);
+		}
+	}
+}
+
+/**
+ * @brief Writes the angles `to`, prefixing each axis with a changed bit.
+ */
+static void Net_WriteDeltaAngles(net_bits_t *stream, const vec3_t from, const vec3_t to) {
+
+	for (int32_t i = 0; i < 3; i++) {
+		const uint16_t a = Net_QuantizeAngle(from.xyz[i]);
+		const uint16_t b = Net_QuantizeAngle(to.xyz[i]);
+
+		if (a == b) {
+			Net_WriteBits(stream, 0, 1);
+		} else {
+			Net_WriteBits(stream, 1, 1);
+			Net_WriteBits(stream, b, 16);
+		}
+	}
+}
+
 /**
  * @brief
  */
@@ -231,7 +441,8 @@ void Net_WriteDeltaMoveCmd(mem_buf_t *msg, const pm_cmd_t *from, const pm_cmd_t
 }
 
 /**
- * @brief
+ * @brief Writes the player state changes to a net message. The delta is bit packed,
+ * and vectors are quantized and delta encoded against `from`.
  */
 void Net_WriteDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const player_state_t *to) {
 
@@ -241,11 +452,11 @@ void Net_WriteDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const
 		bits |= PS_PM_TYPE;
 	}
 
-	if (!Vec3_Equal(to->pm_state.origin, from->pm_state.origin)) {
+	if (memcmp(&to->pm_state.origin, &from->pm_state.origin, sizeof(vec3_t))) {
 		bits |= PS_PM_ORIGIN;
 	}
 
-	if (!Vec3_Equal(to->pm_state.velocity, from->pm_state.velocity)) {
+	if (!Net_QuantizedEqual(to->pm_state.velocity, from->pm_state.velocity, NET_VELOCITY_SCALE)) {
 		bits |= PS_PM_VELOCITY;
 	}
 
@@ -261,19 +472,19 @@ void Net_WriteDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const
 		bits |= PS_PM_GRAVITY;
 	}
 
-	if (!Vec3_Equal(to->pm_state.view_offset, from->pm_state.view_offset)) {
+	if (!Net_QuantizedEqual(to->pm_state.view_offset, from->pm_state.view_offset, NET_ORIGIN_SCALE)) {
 		bits |= PS_PM_VIEW_OFFSET;
 	}
 
-	if (!Vec3_Equal(to->pm_state.view_angles, from->pm_state.view_angles)) {
+	if (!Net_QuantizedAnglesEqual(to->pm_state.view_angles, from->pm_state.view_angles)) {
 		bits |= PS_PM_VIEW_ANGLES;
 	}
 
-	if (!Vec3_Equal(to->pm_state.delta_angles, from->pm_state.delta_angles)) {
+	if (!Net_QuantizedAnglesEqual(to->pm_state.delta_angles, from->pm_state.delta_angles)) {
 		bits |= PS_PM_DELTA_ANGLES;
 	}
 
-	if (!Vec3_Equal(to->pm_state.hook_position, from->pm_state.hook_position)) {
+	if (!Net_QuantizedEqual(to->pm_state.hook_position, from->pm_state.hook_position, NET_ORIGIN_SCALE)) {
 		bits |= PS_PM_HOOK_POSITION;
 	}
 
@@ -285,76 +496,83 @@ void Net_WriteDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const
 		bits |= PS_PM_STEP_OFFSET;
 	}
 
-	Net_WriteShort(msg, bits);
+	net_bits_t stream;
+	Net_BeginBits(&stream, msg);
+
+	Net_WriteBits(&stream, bits, 12);
 
 	if (bits & PS_PM_TYPE) {
-		Net_WriteByte(msg, to->pm_state.type);
+		Net_WriteBits(&stream, to->pm_state.type, 8);
 	}
 
 	if (bits & PS_PM_ORIGIN) {
-		Net_WritePosition(msg, to->pm_state.origin);
+		Net_WriteDeltaPosition(&stream, from->pm_state.origin, to->pm_state.origin);
 	}
 
 	if (bits & PS_PM_VELOCITY) {
-		Net_WritePosition(msg, to->pm_state.velocity);
+		Net_WriteDeltaVector(&stream, from->pm_state.velocity, to->pm_state.velocity,
+							 NET_VELOCITY_SCALE, NET_VELOCITY_DELTA_BITS);
 	}
 
 	if (bits & PS_PM_FLAGS) {
-		Net_WriteShort(msg, to->pm_state.flags);
+		Net_WriteBits(&stream, to->pm_state.flags, 16);
 	}
 
 	if (bits & PS_PM_TIME) {
-		Net_WriteShort(msg, to->pm_state.time);
+		Net_WriteBits(&stream, to->pm_state.time, 16);
 	}
 
 	if (bits & PS_PM_GRAVITY) {
-		Net_WriteShort(msg, to->pm_state.gravity);
+		Net_WriteBits(&stream, (uint16_t) to->pm_state.gravity, 16);
 	}
 
 	if (bits & PS_PM_VIEW_OFFSET) {
-		Net_WritePosition(msg, to->pm_state.view_offset);
+		Net_WriteDeltaVector(&stream, from->pm_state.view_offset, to->pm_state.view_offset,
+							 NET_ORIGIN_SCALE, NET_ORIGIN_DELTA_BITS);
 	}
 
 	if (bits & PS_PM_VIEW_ANGLES) {
-		Net_WriteAngles(msg, to->pm_state.view_angles);
+		Net_WriteDeltaAngles(&stream, from->pm_state.view_angles, to->pm_state.view_angles);
 	}
 
 	if (bits & PS_PM_DELTA_ANGLES) {
-		Net_WriteAngles(msg, to->pm_state.delta_angles);
+		Net_WriteDeltaAngles(&stream, from->pm_state.delta_angles, to->pm_state.delta_angles);
 	}
 
 	if (bits & PS_PM_HOOK_POSITION) {
-		Net_WritePosition(msg, to->pm_state.hook_position);
+		Net_WriteDeltaVector(&stream, from->pm_state.hook_position, to->pm_state.hook_position,
+							 NET_ORIGIN_SCALE, NET_ORIGIN_DELTA_BITS);
 	}
 
 	if (bits & PS_PM_HOOK_LENGTH) {
-		Net_WriteShort(msg, to->pm_state.hook_length);
+		Net_WriteBits(&stream, to->pm_state.hook_length, 16);
 	}
 
 	if (bits & PS_PM_STEP_OFFSET) {
-		Net_WriteFloat(msg, to->pm_state.step_offset);
+		const net_float step_offset = {
+			.v = to->pm_state.step_offset
+		};
+		Net_WriteBits(&stream, (uint32_t) step_offset.i, 32);
 	}
 
-	uint32_t stat_bits = 0;
-
+	// changed stats are sent as a list of index and value, terminated by a 0 bit
 	for (int32_t i = 0; i < MAX_STATS; i++) {
 		if (to->stats[i] != from->stats[i]) {
-			stat_bits |= 1 << i;
+			Net_WriteBits(&stream, 1, 1);
+			Net_WriteBits(&stream, i, 5);
+			Net_WriteBits(&stream, (uint16_t) to->stats[i], MAX_STAT_BITS);
 		}
 	}
 
-	Net_WriteLong(msg, stat_bits);
+	Net_WriteBits(&stream, 0, 1);
 
-	for (int32_t i = 0; i < MAX_STATS; i++) {
-		if (stat_bits & (1 << i)) {
-			Net_WriteShort(msg, to->stats[i]);
-		}
-	}
+	Net_FlushBits(&stream);
 }
 
 /**
  * @brief Writes an entity's state changes to a net message. Can delta from
- * either a baseline or a previous packet_entity
+ * either a baseline or a previous packet_entity. The entity number and change
+ * bits are byte aligned, while the delta itself is bit packed.
  */
 void Net_WriteDeltaEntity(mem_buf_t *msg, const entity_state_t *from, const entity_state_t *to,
                           bool force) {
@@ -377,15 +595,15 @@ void Net_WriteDeltaEntity(mem_buf_t *msg, const entity_state_t *from, const enti
 		bits |= U_SPAWN_ID;
 	}
 
-	if (!Vec3_Equal(to->origin, from->origin)) {
+	if (!Net_QuantizedEqual(to->origin, from->origin, NET_ORIGIN_SCALE)) {
 		bits |= U_ORIGIN;
 	}
 
-	if (!Vec3_Equal(from->termination, to->termination)) {
+	if (!Net_QuantizedEqual(to->termination, from->termination, NET_ORIGIN_SCALE)) {
 		bits |= U_TERMINATION;
 	}
 
-	if (!Vec3_Equal(to->angles, from->angles)) {
+	if (!Net_QuantizedAnglesEqual(to->angles, from->angles)) {
 		bits |= U_ANGLES;
 	}
 
@@ -437,74 +655,87 @@ void Net_WriteDeltaEntity(mem_buf_t *msg, const entity_state_t *from, const enti
 	// write the message
 
 	Net_WriteShort(msg, to->number);
-	Net_WriteShort(msg, bits);
+	Net_WriteVarLong(msg, bits);
+
+	net_bits_t stream;
+	Net_BeginBits(&stream, msg);
 
 	if (bits & U_STEP_OFFSET) {
-		Net_WriteByte(msg, to->step_offset);
+		Net_WriteBits(&stream, (uint8_t) to->step_offset, 8);
 	}
 
 	if (bits & U_SPAWN_ID) {
-		Net_WriteByte(msg, to->spawn_id);
+		Net_WriteBits(&stream, to->spawn_id, 8);
 	}
 
 	if (bits & U_ORIGIN) {
-		Net_WritePosition(msg, to->origin);
+		Net_WriteDeltaVector(&stream, from->origin, to->origin, NET_ORIGIN_SCALE, NET_ORIGIN_DELTA_BITS);
 	}
 
 	if (bits & U_TERMINATION) {
-		Net_WritePosition(msg, to->termination);
+		Net_WriteDeltaVector(&stream, from->termination, to->termination, NET_ORIGIN_SCALE, NET_ORIGIN_DELTA_BITS);
 	}
 
 	if (bits & U_ANGLES) {
-		Net_WriteAngles(msg, to->angles);
+		Net_WriteDeltaAngles(&stream, from->angles, to->angles);
 	}
 
 	if (bits & U_ANIMATIONS) {
-		Net_WriteByte(msg, to->animation1);
-		Net_WriteByte(msg, to->animation2);
+		Net_WriteBits(&stream, to->animation1, 8);
+		Net_WriteBits(&stream, to->animation2, 8);
 	}
 
 	if (bits & U_EVENT) {
-		Net_WriteByte(msg, to->event);
+		Net_WriteBits(&stream, to->event, 8);
 	}
 
 	if (bits & U_EFFECTS) {
-		Net_WriteShort(msg, to->effects);
+		Net_WriteBits(&stream, to->effects, 16);
 	}
 
 	if (bits & U_TRAIL) {
-		Net_WriteByte(msg, to->trail);
+		Net_WriteBits(&stream, to->trail, 8);
 	}
 
 	if (bits & U_MODELS) {
-		Net_WriteByte(msg, to->model1);
-		Net_WriteByte(msg, to->model2);
-		Net_WriteByte(msg, to->model3);
-		Net_WriteByte(msg, to->model4);
+		Net_WriteBits(&stream, to->model1, 8);
+		Net_WriteBits(&stream, to->model2, 8);
+		Net_WriteBits(&stream, to->model3, 8);
+		Net_WriteBits(&stream, to->model4, 8);
 	}
 
 	if (bits & U_COLOR) {
-		Net_WriteByte(msg, to->color.r);
-		Net_WriteByte(msg, to->color.g);
-		Net_WriteByte(msg, to->color.b);
-		Net_WriteByte(msg, to->color.a);
+		Net_WriteBits(&stream, to->color.r, 8);
+		Net_WriteBits(&stream, to->color.g, 8);
+		Net_WriteBits(&stream, to->color.b, 8);
+		Net_WriteBits(&stream, to->color.a, 8);
 	}
 
 	if (bits & U_CLIENT) {
-		Net_WriteByte(msg, to->client);
+		Net_WriteBits(&stream, to->client, 8);
 	}
 
 	if (bits & U_SOUND) {
-		Net_WriteByte(msg, to->sound);
+		Net_WriteBits(&stream, to->sound, 8);
 	}
 
 	if (bits & U_SOLID) {
-		Net_WriteByte(msg, to->solid);
+		Net_WriteBits(&stream, to->solid, 8);
 	}
 
 	if (bits & U_BOUNDS) {
-		Net_WriteBounds(msg, to->bounds);
+		const vec3s_t mins = Vec3_CastVec3s(to->bounds.mins);
+		const vec3s_t maxs = Vec3_CastVec3s(to->bounds.maxs);
+
+		Net_WriteBits(&stream, (uint16_t) mins.x, 16);
+		Net_WriteBits(&stream, (uint16_t) mins.y, 16);
+		Net_WriteBits(&stream, (uint16_t) mins.z, 16);
+		Net_WriteBits(&stream, (uint16_t) maxs.x, 16);
+		Net_WriteBits(&stream, (uint16_t) maxs.y, 16);
+		Net_WriteBits(&stream, (uint16_t) maxs.z, 16);
 	}
+
+	Net_FlushBits(&stream);
 }
 
 /**
@@ -591,6 +822,29 @@ int32_t Net_ReadLong(mem_buf_t *msg) {
 	return c;
 }
 
+/**
+ * @brief Reads an unsigned integer written by Net_WriteVarLong.
+ */
+uint32_t Net_ReadVarLong(mem_buf_t *msg) {
+
+	uint32_t c = 0;
+
+	for (uint32_t shift = 0; shift < 32; shift += 7) {
+		const int32_t b = Net_ReadByte(msg);
+		if (b == -1) {
+			break;
+		}
+
+		c |= (uint32_t) (b & 0x7f) << shift;
+
+		if (!(b & 0x80)) {
+			break;
+		}
+	}
+
+	return c;
+}
+
 /**
  * @brief
  */
@@ -675,17 +929,14 @@ vec3_t Net_ReadAngles(mem_buf_t *msg) {
 }
 
 /**
- * @brief
+ * @brief Reads a unit vector written by Net_WriteDir.
  */
 vec3_t Net_ReadDir(mem_buf_t *msg) {
 
-	const int32_t b = Net_ReadByte(msg);
-
-	if (b >= NUM_APPROXIMATE_NORMALS) {
-		Com_Error(ERROR_DROP, "%d out of range\n", b);
-	}
+	const int32_t u = (int8_t) Net_ReadByte(msg);
+	const int32_t v = (int8_t) Net_ReadByte(msg);
 
-	return approximate_normals[b];
+	return Vec3_Normalize(Net_Octahedron(Clampf(u, -127.f, 127.f), Clampf(v, -127.f, 127.f)));
 }
 
 /**
@@ -704,6 +955,109 @@ box3_t Net_ReadBounds(mem_buf_t *msg) {
 	return b;
 }
 
+/**
+ * @brief Reads `count` bits from the bit stream. Reading past the end of the
+ * message yields zeros, and advances the message read position beyond its size.
+ */
+uint32_t Net_ReadBits(net_bits_t *stream, uint32_t count) {
+
+	assert(count <= 32);
+
+	while (stream->count < count) {
+		const int32_t b = Net_ReadByte(stream->msg);
+		if (b != -1) {
+			stream->value |= (uint64_t) b << stream->count;
+		}
+		stream->count += 8;
+	}
+
+	const uint32_t value = (uint32_t) (stream->value & ((1ull << count) - 1));
+
+	stream->value >>= count;
+	stream->count -= count;
+
+	return value;
+}
+
+/**
+ * @brief Reads `count` bits from the bit stream, sign extending the result.
+ */
+int32_t Net_ReadSignedBits(net_bits_t *stream, uint32_t count) {
+
+	const uint32_t value = Net_ReadBits(stream, count);
+
+	if (count < 32 && (value & (1u << (count - 1)))) {
+		return (int32_t) (value | ~((1u << count) - 1));
+	}
+
+	return (int32_t) value;
+}
+
+/**
+ * @brief Reads a full precision vector written by Net_WriteDeltaPosition.
+ */
+static vec3_t Net_ReadDeltaPosition(net_bits_t *stream, const vec3_t from) {
+
+	vec3_t to = from;
+
+	for (int32_t i = 0; i < 3; i++) {
+
+		if (Net_ReadBits(stream, 1) == 0) {
+			continue;
+		}
+
+		const net_float component = {
+			.i = (int32_t) Net_ReadBits(stream, 32)
+		};
+
+		to.xyz[i] = component.v;
+	}
+
+	return to;
+}
+
+/**
+ * @brief Reads a quantized vector written by Net_WriteDeltaVector.
+ */
+static vec3_t Net_ReadDeltaVector(net_bits_t *stream, const vec3_t from, float scale, uint32_t delta_bits) {
+
+	vec3_t to = from;
+
+	for (int32_t i = 0; i < 3; i++) {
+
+		if (Net_ReadBits(stream, 1) == 0) {
+			continue;
+		}
+
+		int32_t value;
+		if (Net_ReadBits(stream, 1) == 0) {
+			value = Net_Quantize(from.xyz[i], scale) + Net_ReadSignedBits(stream, delta_bits);
+		} else {
+			value = Net_ReadSignedBits(stream, NET_VECTOR_BITS);
+		}
+
+		to.xyz[i] = value / scale;
+	}
+
+	return to;
+}
+
+/**
+ * @brief Reads angles written by Net_WriteDeltaAngles.
+ */
+static vec3_t Net_ReadDeltaAngles(net_bits_t *stream, const vec3_t from) {
+
+	vec3_t to = from;
+
+	for (int32_t i = 0; i < 3; i++) {
+		if (Net_ReadBits(stream, 1)) {
+			to.xyz[i] = (int16_t) Net_ReadBits(stream, 16) * 360.f / UINT16_MAX;
+		}
+	}
+
+	return to;
+}
+
 /**
  * @brief
  */
@@ -741,73 +1095,84 @@ void Net_ReadDeltaMoveCmd(mem_buf_t *msg, const pm_cmd_t *from, pm_cmd_t *to) {
 }
 
 /**
- * @brief
+ * @brief Reads the player state changes written by Net_WriteDeltaPlayerState.
  */
 void Net_ReadDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, player_state_t *to) {
 
 	*to = *from;
 
-	const int32_t bits = Net_ReadShort(msg);
+	net_bits_t stream;
+	Net_BeginBits(&stream, msg);
+
+	const uint32_t bits = Net_ReadBits(&stream, 12);
 
 	if (bits & PS_PM_TYPE) {
-		to->pm_state.type = Net_ReadByte(msg);
+		to->pm_state.type = Net_ReadBits(&stream, 8);
 	}
 
 	if (bits & PS_PM_ORIGIN) {
-		to->pm_state.origin = Net_ReadPosition(msg);
+		to->pm_state.origin = Net_ReadDeltaPosition(&stream, from->pm_state.origin);
 	}
 
 	if (bits & PS_PM_VELOCITY) {
-		to->pm_state.velocity = Net_ReadPosition(msg);
+		to->pm_state.velocity = Net_ReadDeltaVector(&stream, from->pm_state.velocity,
+													NET_VELOCITY_SCALE, NET_VELOCITY_DELTA_BITS);
 	}
 
 	if (bits & PS_PM_FLAGS) {
-		to->pm_state.flags = Net_ReadShort(msg);
+		to->pm_state.flags = Net_ReadBits(&stream, 16);
 	}
 
 	if (bits & PS_PM_TIME) {
-		to->pm_state.time = Net_ReadShort(msg);
+		to->pm_state.time = Net_ReadBits(&stream, 16);
 	}
 
 	if (bits & PS_PM_GRAVITY) {
-		to->pm_state.gravity = Net_ReadShort(msg);
+		to->pm_state.gravity = (int16_t) Net_ReadBits(&stream, 16);
 	}
 
 	if (bits & PS_PM_VIEW_OFFSET) {
-		to->pm_state.view_offset = Net_ReadPosition(msg);
+		to->pm_state.view_offset = Net_ReadDeltaVector(&stream, from->pm_state.view_offset,
+													   NET_ORIGIN_SCALE, NET_ORIGIN_DELTA_BITS);
 	}
 
 	if (bits & PS_PM_VIEW_ANGLES) {
-		to->pm_state.view_angles = Net_ReadAngles(msg);
+		to->pm_state.view_angles = Net_ReadDeltaAngles(&stream, from->pm_state.view_angles);
 	}
 
 	if (bits & PS_PM_DELTA_ANGLES) {
-		to->pm_state.delta_angles = Net_ReadAngles(msg);
+		to->pm_state.delta_angles = Net_ReadDeltaAngles(&stream, from->pm_state.delta_angles);
 	}
 
 	if (bits & PS_PM_HOOK_POSITION) {
-		to->pm_state.hook_position = Net_ReadPosition(msg);
+		to->pm_state.hook_position = Net_ReadDeltaVector(&stream, from->pm_state.hook_position,
+														 NET_ORIGIN_SCALE, NET_ORIGIN_DELTA_BITS);
 	}
 
 	if (bits & PS_PM_HOOK_LENGTH) {
-		to->pm_state.hook_length = Net_ReadShort(msg);
+		to->pm_state.hook_length = Net_ReadBits(&stream, 16);
 	}
 
 	if (bits & PS_PM_STEP_OFFSET) {
-		to->pm_state.step_offset = Net_ReadFloat(msg);
+		const net_float step_offset = {
+			.i = (int32_t) Net_ReadBits(&stream, 32)
+		};
+		to->pm_state.step_offset = step_offset.v;
 	}
 
-	const int32_t stat_bits = Net_ReadLong(msg);
+	while (Net_ReadBits(&stream, 1)) {
+		const uint32_t i = Net_ReadBits(&stream, 5);
+		to->stats[i] = (int16_t) Net_ReadBits(&stream, MAX_STAT_BITS);
 
-	for (int32_t i = 0; i < MAX_STATS; i++) {
-		if (stat_bits & (1 << i)) {
-			to->stats[i] = Net_ReadShort(msg);
+		if (msg->read > msg->size) {
+			break;
 		}
 	}
 }
 
 /**
- * @brief
+ * @brief Reads the entity state changes written by Net_WriteDeltaEntity. The
+ * entity number and change bits have already been read by the caller.
  */
 void Net_ReadDeltaEntity(mem_buf_t *msg, const entity_state_t *from, entity_state_t *to,
                          uint16_t number, uint16_t bits) {
@@ -816,72 +1181,80 @@ void Net_ReadDeltaEntity(mem_buf_t *msg, const entity_state_t *from, entity_stat
 
 	to->number = number;
 
+	net_bits_t stream;
+	Net_BeginBits(&stream, msg);
+
 	if (bits & U_STEP_OFFSET) {
-		to->step_offset = Net_ReadByte(msg);
+		to->step_offset = (int8_t) Net_ReadBits(&stream, 8);
 	}
 
 	if (bits & U_SPAWN_ID) {
-		to->spawn_id = Net_ReadByte(msg);
+		to->spawn_id = Net_ReadBits(&stream, 8);
 	}
 
 	if (bits & U_ORIGIN) {
-		to->origin = Net_ReadPosition(msg);
+		to->origin = Net_ReadDeltaVector(&stream, from->origin, NET_ORIGIN_SCALE, NET_ORIGIN_DELTA_BITS);
 	}
 
 	if (bits & U_TERMINATION) {
-		to->termination = Net_ReadPosition(msg);
+		to->termination = Net_ReadDeltaVector(&stream, from->termination, NET_ORIGIN_SCALE, NET_ORIGIN_DELTA_BITS);
 	}
 
 	if (bits & U_ANGLES) {
-		to->angles = Net_ReadAngles(msg);
+		to->angles = Net_ReadDeltaAngles(&stream, from->angles);
 	}
 
 	if (bits & U_ANIMATIONS) {
-		to->animation1 = Net_ReadByte(msg);
-		to->animation2 = Net_ReadByte(msg);
+		to->animation1 = Net_ReadBits(&stream, 8);
+		to->animation2 = Net_ReadBits(&stream, 8);
 	}
 
 	if (bits & U_EVENT) {
-		to->event = Net_ReadByte(msg);
+		to->event = Net_ReadBits(&stream, 8);
 	} else {
 		to->event = 0;
 	}
 
 	if (bits & U_EFFECTS) {
-		to->effects = Net_ReadShort(msg);
+		to->effects = Net_ReadBits(&stream, 16);
 	}
 
 	if (bits & U_TRAIL) {
-		to->trail = Net_ReadByte(msg);
+		to->trail = Net_ReadBits(&stream, 8);
 	}
 
 	if (bits & U_MODELS) {
-		to->model1 = Net_ReadByte(msg);
-		to->model2 = Net_ReadByte(msg);
-		to->model3 = Net_ReadByte(msg);
-		to->model4 = Net_ReadByte(msg);
+		to->model1 = Net_ReadBits(&stream, 8);
+		to->model2 = Net_ReadBits(&stream, 8);
+		to->model3 = Net_ReadBits(&stream, 8);
+		to->model4 = Net_ReadBits(&stream, 8);
 	}
 
 	if (bits & U_COLOR) {
-		to->color.r = Net_ReadByte(msg);
-		to->color.g = Net_ReadByte(msg);
-		to->color.b = Net_ReadByte(msg);
-		to->color.a = Net_ReadByte(msg);
+		to->color.r = Net_ReadBits(&stream, 8);
+		to->color.g = Net_ReadBits(&stream, 8);
+		to->color.b = Net_ReadBits(&stream, 8);
+		to->color.a = Net_ReadBits(&stream, 8);
 	}
 
 	if (bits & U_CLIENT) {
-		to->client = Net_ReadByte(msg);
+		to->client = Net_ReadBits(&stream, 8);
 	}
 
 	if (bits & U_SOUND) {
-		to->sound = Net_ReadByte(msg);
+		to->sound = Net_ReadBits(&stream, 8);
 	}
 
 	if (bits & U_SOLID) {
-		to->solid = Net_ReadByte(msg);
+		to->solid = Net_ReadBits(&stream, 8);
 	}
 
 	if (bits & U_BOUNDS) {
-		to->bounds = Net_ReadBounds(msg);
+		to->bounds.mins.x = (int16_t) Net_ReadBits(&stream, 16);
+		to->bounds.mins.y = (int16_t) Net_ReadBits(&stream, 16);
+		to->bounds.mins.z = (int16_t) Net_ReadBits(&stream, 16);
+		to->bounds.maxs.x = (int16_t) Net_ReadBits(&stream, 16);
+		to->bounds.maxs.y = (int16_t) Net_ReadBits(&stream, 16);
+		to->bounds.maxs.z = (int16_t) Net_ReadBits(&stream, 16);
 	}
 }
@@ -71,6 +71,35 @@
 #define U_SPAWN_ID              (1 << 14)
 #define U_STEP_OFFSET           (1 << 15)
 
+/**
+ * @brief Fixed-point scales and small delta widths for quantized vectors in
+ * entity and player state deltas. Origins are sent to 1/8 unit, velocities to
+ * 1/8 unit per second. Deltas which fit within the small width are sent as
+ * such, otherwise the quantized vector component is sent in full. The player
+ * state origin is the exception, and is sent at full precision, so that client
+ * side prediction begins from the server's exact position.
+ */
+#define NET_ORIGIN_SCALE		8.f
+#define NET_ORIGIN_DELTA_BITS	10
+#define NET_VELOCITY_SCALE		8.f
+#define NET_VELOCITY_DELTA_BITS	13
+
+/**
+ * @brief The width of a quantized vector component sent in full.
+ */
+#define NET_VECTOR_BITS			24
+
+/**
+ * @brief A bit stream over a message buffer. Bits are packed least significant
+ * first, and the stream is always flushed to a byte boundary, so that bit packed
+ * and byte aligned data may be freely interleaved within a message.
+ */
+typedef struct {
+	mem_buf_t *msg;
+	uint64_t value;
+	uint32_t count;
+} net_bits_t;
+
 /**
  * @brief Message writing and reading facilities.
  */
@@ -79,6 +108,7 @@ void Net_WriteChar(mem_buf_t *msg, int32_t c);
 void Net_WriteByte(mem_buf_t *msg, int32_t c);
 void Net_WriteShort(mem_buf_t *msg, int32_t c);
 void Net_WriteLong(mem_buf_t *msg, int32_t c);
+void Net_WriteVarLong(mem_buf_t *msg, uint32_t c);
 void Net_WriteString(mem_buf_t *msg, const char *s);
 void Net_WriteFloat(mem_buf_t *msg, float f);
 void Net_WritePosition(mem_buf_t *msg, const vec3_t pos);
@@ -86,6 +116,9 @@ void Net_WriteAngle(mem_buf_t *msg, float f);
 void Net_WriteAngles(mem_buf_t *msg, const vec3_t angles);
 void Net_WriteDir(mem_buf_t *msg, const vec3_t dir);
 void Net_WriteBounds(mem_buf_t *msg, const box3_t bounds);
+void Net_BeginBits(net_bits_t *stream, mem_buf_t *msg);
+void Net_WriteBits(net_bits_t *stream, uint32_t value, uint32_t count);
+void Net_FlushBits(net_bits_t *stream);
 void Net_WriteDeltaMoveCmd(mem_buf_t *msg, const pm_cmd_t *from, const pm_cmd_t *to);
 void Net_WriteDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const player_state_t *to);
 void Net_WriteDeltaEntity(mem_buf_t *msg, const entity_state_t *from, const entity_state_t *to, bool force);
@@ -96,6 +129,7 @@ int32_t Net_ReadChar(mem_buf_t *msg);
 int32_t Net_ReadByte(mem_buf_t *msg);
 int32_t Net_ReadShort(mem_buf_t *msg);
 int32_t Net_ReadLong(mem_buf_t *msg);
+uint32_t Net_ReadVarLong(mem_buf_t *msg);
 char *Net_ReadString(mem_buf_t *msg);
 char *Net_ReadStringLine(mem_buf_t *msg);
 float Net_ReadFloat(mem_buf_t *msg);
@@ -104,6 +138,8 @@ float Net_ReadAngle(mem_buf_t *msg);
 vec3_t Net_ReadAngles(mem_buf_t *msg);
 vec3_t Net_ReadDir(mem_buf_t *msg);
 box3_t Net_ReadBounds(mem_buf_t *msg);
+uint32_t Net_ReadBits(net_bits_t *stream, uint32_t count);
+int32_t Net_ReadSignedBits(net_bits_t *stream, uint32_t count);
 void Net_ReadDeltaMoveCmd(mem_buf_t *msg, const pm_cmd_t *from, pm_cmd_t *to);
 void Net_ReadDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, player_state_t *to);
 void Net_ReadDeltaEntity(mem_buf_t *msg, const entity_state_t *from, entity_state_t *to,
@@ -56,6 +56,19 @@
  */
 #define MAX_MSG_SIZE_UDP	1450
 
+/**
+ * @brief Netchan messages that would exceed MAX_MSG_SIZE_UDP are sent as a
+ * series of fragments of this size, leaving room for the packet header.
+ */
+#define MAX_FRAGMENT_SIZE	(MAX_MSG_SIZE_UDP - 16)
+
+/**
+ * @brief Fragmented netchan messages may be up to this size, bounded by the 16 bit
+ * offset of each fragment. Frames, which are parsed as a single command, may therefore
+ * exceed MAX_MSG_SIZE.
+ */
+#define MAX_MSG_SIZE_FRAGMENTED	(MAX_MSG_SIZE * 4)
+
 // A typedef for net_sockaddr, to reduce "struct" everywhere and silence Windows warning.
 typedef struct sockaddr_in net_sockaddr;
 
@@ -110,4 +123,92 @@ typedef struct {
 	// message is copied to this buffer when it is first transfered
 	size_t reliable_size;
 	byte reliable_buffer[MAX_MSG_SIZE - 10]; // un-acked reliable message
+
+	// incoming fragments are reassembled in this buffer, in any order
+	uint32_t fragment_sequence;
+	uint64_t fragment_received; // a bit for each fragment received
+	uint32_t fragment_count; // known once the final fragment is received
+	size_t fragment_size;
+	byte fragment_buffer[MAX_MSG_SIZE_FRAGMENTED];
 } net_chan_t;
+
+/**
+ * @brief Demo files begin with this identifier, followed by the format version.
+ * Demos recorded before the format was versioned begin with the length of their
+ * first message instead, and may be played in sequence, but not seeked. Demos
+ * recorded by the server begin with DEMO_WORLD_IDENT, and contain world records.
+ */
+#define DEMO_IDENT			(('O' << 24) + ('M' << 16) + ('E' << 8) + 'D') // "DEMO"
+#define DEMO_WORLD_IDENT	(('D' << 24) + ('L' << 16) + ('R' << 8) + 'W') // "WRLD"
+#define DEMO_VERSION		1
+
+/**
+ * @brief World records may span several messages, and are bounded by this size.
+ */
+#define MAX_DEMO_RECORD_SIZE (MAX_MSG_SIZE * 4)
+
+/**
+ * @brief Keyframes are recorded at roughly this interval, in milliseconds.
+ */
+#define DEMO_KEYFRAME_INTERVAL 10000
+
+/**
+ * @brief Demo record types.
+ */
+typedef enum {
+	/**
+	 * @brief A server message, played in sequence.
+	 */
+	DEMO_RECORD_MESSAGE,
+
+	/**
+	 * @brief Config strings which have changed since recording began. These are
+	 * played only when seeking to the uncompressed frame which follows them.
+	 */
+	DEMO_RECORD_KEYFRAME,
+
+	/**
+	 * @brief A frame of the entire world, recorded by the server. Every entity and
+	 * the player state of every client is delta compressed against the previous
+	 * world frame, followed by the messages sent to clients during the frame. World
+	 * frames are converted to client frames from a chosen point of view on playback.
+	 */
+	DEMO_RECORD_WORLD,
+} demo_record_type_t;
+
+/**
+ * @brief Messages within world records are addressed to a client number, or to all
+ * clients. The messages are terminated by DEMO_WORLD_END.
+ */
+#define DEMO_WORLD_ALL_CLIENTS	0xfe
+#define DEMO_WORLD_END			0xff
+
+/**
+ * @brief Each server message in a demo is preceded by a record. A record with a
+ * length of -1 terminates the messages.
+ */
+typedef struct {
+	int32_t length;
+	int32_t time; // milliseconds since recording began
+	int32_t type;
+} demo_record_t;
+
+/**
+ * @brief The demo index maps time to the file offset of each keyframe's records.
+ */
+typedef struct {
+	int32_t time;
+	int32_t offset;
+} demo_keyframe_t;
+
+/**
+ * @brief The terminating record is followed by the original values of all config
+ * strings which changed during recording, as keyframe records. These are followed
+ * by the index and finally this trailer, which allows the index to be read from
+ * the end of the file.
+ */
+typedef struct {
+	int32_t num_keyframes;
+	int32_t offset; // the offset of the original config strings
+	int32_t ident;
+} demo_trailer_t;
@@ -148,6 +148,62 @@ static void Sv_Demo_f(void) {
 	Sv_InitServer(Cmd_Argv(1), SV_ACTIVE_DEMO);
 }
 
+/**
+ * @brief Seeks the current demo to the specified time in seconds. Times prefixed
+ * by + or - are relative to the current time.
+ */
+static void Sv_DemoSeek_f(void) {
+
+	if (sv.state != SV_ACTIVE_DEMO) {
+		Com_Print("No demo is playing\n");
+		return;
+	}
+
+	const uint32_t seconds = sv.demo_time / 1000;
+
+	if (Cmd_Argc() != 2) {
+		Com_Print("Usage: %s <[+|-]seconds>\n", Cmd_Argv(0));
+		Com_Print("Demo %s is at %d:%02d\n", sv.name, seconds / 60, seconds % 60);
+		return;
+	}
+
+	const char *arg = Cmd_Argv(1);
+	int32_t time = (int32_t) (strtod(arg, NULL) * 1000.0);
+
+	if (*arg == '+' || *arg == '-') {
+		time += (int32_t) sv.demo_time;
+	}
+
+	Sv_SeekDemo((uint32_t) Maxi(time, 0));
+}
+
+/**
+ * @brief Records the entire world to a server demo, from which any client's point
+ * of view may be played back.
+ */
+static void Sv_DemoRecord_f(void) {
+
+	if (Cmd_Argc() > 2) {
+		Com_Print("Usage: %s [demo name]\n", Cmd_Argv(0));
+		return;
+	}
+
+	Sv_StartRecording(Cmd_Argc() == 2 ? Cmd_Argv(1) : NULL);
+}
+
+/**
+ * @brief Stops recording the current server demo.
+ */
+static void Sv_DemoStop_f(void) {
+
+	if (!sv.demo_recorder) {
+		Com_Print("Not recording a demo\n");
+		return;
+	}
+
+	Sv_StopRecording();
+}
+
 /**
  * @brief Map command autocompletion.
  */
@@ -226,6 +282,9 @@ static void Sv_Status_f(void) {
 
 		Com_Print("%s\n", status);
 	}
+
+	Com_Print("multicast: %zu bytes sent, %zu bytes culled last frame\n",
+	          sv.multicast_bytes_sent, sv.multicast_bytes_saved);
 }
 
 /**
@@ -251,6 +310,90 @@ static void Sv_ListEntities_f(void) {
 	}
 }
 
+/**
+ * @brief Benchmarks clipping traces to the world one at a time, against clipping them
+ * with Cm_BoxTraces, both on this thread alone and across all threads. Traces are cast
+ * in coherent fans from random origins, like pellets or particles.
+ */
+static void Sv_BenchmarkTraces_f(void) {
+
+	if (sv.state == SV_UNINITIALIZED) {
+		Com_Print("No map loaded\n");
+		return;
+	}
+
+	const int32_t count = Cmd_Argc() > 1 ? (int32_t) Clampf(strtol(Cmd_Argv(1), NULL, 10), 32.f, 1 << 20) : 0x10000;
+
+	cm_box_trace_t *traces = Mem_Malloc(sizeof(cm_box_trace_t) * count);
+	cm_trace_t *results = Mem_Malloc(sizeof(cm_trace_t) * count * 3);
+
+	const box3_t bounds = sv.cm_models[0]->bounds;
+
+	vec3_t origin = Vec3_Zero(), dir = Vec3_Zero();
+	for (int32_t i = 0; i < count; i++) {
+
+		if (i % 32 == 0) {
+			origin = Vec3_RandomRanges(bounds.mins.x, bounds.maxs.x,
+									   bounds.mins.y, bounds.maxs.y,
+									   bounds.mins.z, bounds.maxs.z);
+			dir = Vec3_RandomDir();
+		}
+
+		traces[i] = (cm_box_trace_t) {
+			.start = origin,
+			.end = Vec3_Fmaf(origin, 1024.f, Vec3_RandomizeDir(dir, .1f)),
+			.bounds = (i / 32) & 1 ? Box3f(8.f, 8.f, 8.f) : Box3_Zero()
+		};
+	}
+
+	Cm_TraceStats(true);
+
+	const gint64 start = g_get_monotonic_time();
+
+	for (int32_t i = 0; i < count; i++) {
+		results[i] = Cm_BoxTrace(traces[i].start, traces[i].end, traces[i].bounds, 0, CONTENTS_MASK_CLIP_PLAYER);
+	}
+
+	const gint64 single = g_get_monotonic_time() - start;
+
+	const cm_trace_stats_t stats = Cm_TraceStats(false);
+
+	// batches of a single packet (32 traces) are clipped on the calling thread
+	for (int32_t i = 0; i < count; i += 32) {
+		Cm_BoxTraces(traces + i, results + count + i, Mini(32, count - i), 0, CONTENTS_MASK_CLIP_PLAYER);
+	}
+
+	const gint64 batched = g_get_monotonic_time() - start - single;
+
+	Cm_BoxTraces(traces, results + count * 2, count, 0, CONTENTS_MASK_CLIP_PLAYER);
+
+	const gint64 parallel = g_get_monotonic_time() - start - single - batched;
+
+	int32_t mismatches = 0;
+	for (int32_t i = 0; i < count; i++) {
+		const cm_trace_t *a = &results[i];
+
+		for (int32_t j = 1; j < 3; j++) {
+			const cm_trace_t *b = &results[count * j + i];
+
+			if (a->fraction != b->fraction || !Vec3_Equal(a->end, b->end) || a->brush_side != b->brush_side) {
+				mismatches++;
+			}
+		}
+	}
+
+	Com_Print("%d traces: %.2f ms one at a time, %.2f ms batched (%.2fx), %.2f ms batched on %d threads (%.2fx), %d mismatches\n",
+			  count, single / 1000.0,
+			  batched / 1000.0, single / (double) MAX(batched, 1),
+			  parallel / 1000.0, Thread_Count(), single / (double) MAX(parallel, 1),
+			  mismatches);
+	Com_Print("%" PRId64 " brushes tested, %" PRId64 " duplicate tests avoided\n",
+			  stats.brushes, stats.duplicate_brushes);
+
+	Mem_Free(traces);
+	Mem_Free(results);
+}
+
 /**
  * @brief
  */
@@ -399,10 +542,15 @@ void Sv_InitAdmin(void) {
 	Cmd_Add("list_entities", Sv_ListEntities_f, CMD_SERVER, "List all entities in use");
 	Cmd_Add("server_info", Sv_ServerInfo_f, CMD_SERVER, "Print server info settings");
 	Cmd_Add("user_info", Sv_UserInfo_f, CMD_SERVER, "Print information for a given user");
+	Cmd_Add("benchmark_traces", Sv_BenchmarkTraces_f, CMD_SERVER, "Benchmark batched traces against the loaded map");
 
 	cmd_t *demo_cmd = Cmd_Add("demo", Sv_Demo_f, CMD_SERVER, "Start playback of the specified demo file");
 	Cmd_SetAutocomplete(demo_cmd, Sv_Demo_Autocomplete_f);
 
+	Cmd_Add("demo_seek", Sv_DemoSeek_f, CMD_SERVER, "Seek the current demo to the specified time in seconds");
+	Cmd_Add("demo_record", Sv_DemoRecord_f, CMD_SERVER, "Record all clients to the specified server demo file");
+	Cmd_Add("demo_stop", Sv_DemoStop_f, CMD_SERVER, "Stop recording the current server demo");
+
 	cmd_t *map_cmd = Cmd_Add("map", Sv_Map_f, CMD_SERVER, "Start a server for the specified map");
 	Cmd_SetAutocomplete(map_cmd, Sv_Map_Autocomplete_f);
 
@@ -0,0 +1,1235 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#include "sv_local.h"
+
+/**
+ * @brief Writes a delta update of the player states of the clients in world frame `to`.
+ */
+static void Sv_WriteWorldPlayerStates(const sv_world_frame_t *from, const sv_world_frame_t *to, mem_buf_t *msg) {
+	static player_state_t null_state;
+
+	for (int32_t i = 0; i < MAX_CLIENTS; i++) {
+
+		if (!to->clients[i]) {
+			continue;
+		}
+
+		Net_WriteByte(msg, i);
+
+		if (from && from->clients[i]) {
+			Net_WriteDeltaPlayerState(msg, &from->ps[i], &to->ps[i]);
+		} else {
+			Net_WriteDeltaPlayerState(msg, &null_state, &to->ps[i]);
+		}
+	}
+
+	Net_WriteByte(msg, DEMO_WORLD_END);
+}
+
+/**
+ * @brief Reads a delta update of the player states of the clients in world frame `to`.
+ * @return False if the update is corrupt.
+ */
+static bool Sv_ReadWorldPlayerStates(mem_buf_t *msg, const sv_world_frame_t *from, sv_world_frame_t *to) {
+	static player_state_t null_state;
+
+	memset(to->clients, 0, sizeof(to->clients));
+
+	while (true) {
+		const int32_t i = Net_ReadByte(msg);
+
+		if (i == DEMO_WORLD_END) {
+			return true;
+		}
+
+		if (i < 0 || i >= MAX_CLIENTS) {
+			return false;
+		}
+
+		if (from && from->clients[i]) {
+			Net_ReadDeltaPlayerState(msg, &from->ps[i], &to->ps[i]);
+		} else {
+			Net_ReadDeltaPlayerState(msg, &null_state, &to->ps[i]);
+		}
+
+		to->clients[i] = true;
+	}
+}
+
+/**
+ * @brief Writes a delta update of the entities in world frame `to`. Entities which are
+ * not present in `from` are delta compressed against their baseline.
+ */
+static void Sv_WriteWorldEntities(const sv_world_frame_t *from, const sv_world_frame_t *to, mem_buf_t *msg) {
+
+	const uint16_t from_num_entities = from ? from->num_entities : 0;
+	uint16_t old_index = 0, new_index = 0;
+
+	while (new_index < to->num_entities || old_index < from_num_entities) {
+
+		const entity_state_t *old_state = old_index < from_num_entities ? &from->entities[old_index] : NULL;
+		const entity_state_t *new_state = new_index < to->num_entities ? &to->entities[new_index] : NULL;
+
+		const uint16_t old_num = old_state ? old_state->number : 0xffff;
+		const uint16_t new_num = new_state ? new_state->number : 0xffff;
+
+		if (new_num == old_num) { // delta update from old position
+			Net_WriteDeltaEntity(msg, old_state, new_state, false);
+			old_index++;
+			new_index++;
+		} else if (new_num < old_num) { // this is a new entity, send it from the baseline
+			Net_WriteDeltaEntity(msg, &sv.baselines[new_num], new_state, true);
+			new_index++;
+		} else { // the old entity isn't present in the new frame
+			Net_WriteShort(msg, old_num);
+			Net_WriteVarLong(msg, U_REMOVE);
+			old_index++;
+		}
+	}
+
+	Net_WriteShort(msg, 0); // end of entities
+}
+
+/**
+ * @brief Copies an unchanged entity to the next world frame. Events are not
+ * delta compressed, and so must not persist beyond the frame which fired them.
+ */
+static void Sv_CopyWorldEntity(const entity_state_t *from, entity_state_t *to) {
+
+	*to = *from;
+	to->event = 0;
+}
+
+/**
+ * @brief Reads a delta update of the entities in world frame `to`.
+ * @return False if the update is corrupt.
+ */
+static bool Sv_ReadWorldEntities(mem_buf_t *msg, const sv_world_frame_t *from, sv_world_frame_t *to) {
+
+	const uint16_t from_num_entities = from ? from->num_entities : 0;
+	uint16_t old_index = 0;
+
+	to->num_entities = 0;
+
+	while (true) {
+		const uint16_t number = (uint16_t) Net_ReadShort(msg);
+
+		if (number >= MAX_ENTITIES || msg->read > msg->size) {
+			return false;
+		}
+
+		if (!number) { // done
+			break;
+		}
+
+		// copy the unchanged entities which precede this one
+		while (old_index < from_num_entities && from->entities[old_index].number < number) {
+			if (to->num_entities == MAX_ENTITIES) {
+				return false;
+			}
+			Sv_CopyWorldEntity(&from->entities[old_index++], &to->entities[to->num_entities++]);
+		}
+
+		const entity_state_t *base = &sv.baselines[number];
+
+		if (old_index < from_num_entities && from->entities[old_index].number == number) {
+			base = &from->entities[old_index++];
+		}
+
+		const uint16_t bits = Net_ReadVarLong(msg);
+
+		if (bits & U_REMOVE) {
+			continue;
+		}
+
+		if (to->num_entities == MAX_ENTITIES) {
+			return false;
+		}
+
+		Net_ReadDeltaEntity(msg, base, &to->entities[to->num_entities++], number, bits);
+	}
+
+	// and any remaining unchanged entities
+	while (old_index < from_num_entities) {
+		if (to->num_entities == MAX_ENTITIES) {
+			return false;
+		}
+		Sv_CopyWorldEntity(&from->entities[old_index++], &to->entities[to->num_entities++]);
+	}
+
+	return true;
+}
+
+/**
+ * @brief Loads the demo index and the original values of config strings which
+ * change during the demo, so that the demo may be seeked.
+ */
+static void Sv_LoadDemoIndex(void) {
+	demo_trailer_t trailer;
+
+	const int64_t start = Fs_Tell(sv.demo_file);
+	const int64_t length = Fs_FileLength(sv.demo_file);
+
+	if (length < start + (int64_t) sizeof(trailer) ||
+	        !Fs_Seek(sv.demo_file, length - sizeof(trailer)) ||
+	        Fs_Read(sv.demo_file, &trailer, sizeof(trailer), 1) != 1 ||
+	        LittleLong(trailer.ident) != DEMO_IDENT) {
+
+		Com_Warn("Demo %s has no index, seeking is disabled\n", sv.name);
+		Fs_Seek(sv.demo_file, start);
+		return;
+	}
+
+	const int32_t num_keyframes = LittleLong(trailer.num_keyframes);
+	const int64_t offset = LittleLong(trailer.offset);
+
+	const int64_t index = length - sizeof(trailer) - num_keyframes * (int64_t) sizeof(demo_keyframe_t);
+
+	if (num_keyframes < 0 || offset < start || offset > index) {
+		Com_Warn("Demo %s has a corrupt index, seeking is disabled\n", sv.name);
+		Fs_Seek(sv.demo_file, start);
+		return;
+	}
+
+	sv.demo_config_strings_size = sv.demo_config_strings_read = (size_t) (index - offset);
+
+	if (sv.demo_config_strings_size) {
+		sv.demo_config_strings = Mem_TagMalloc(sv.demo_config_strings_size, MEM_TAG_SERVER);
+
+		Fs_Seek(sv.demo_file, offset);
+		Fs_Read(sv.demo_file, sv.demo_config_strings, sv.demo_config_strings_size, 1);
+	}
+
+	if (num_keyframes) {
+		sv.demo_keyframes = Mem_TagMalloc(num_keyframes * sizeof(demo_keyframe_t), MEM_TAG_SERVER);
+
+		Fs_Seek(sv.demo_file, index);
+		Fs_Read(sv.demo_file, sv.demo_keyframes, sizeof(demo_keyframe_t), num_keyframes);
+
+		for (int32_t i = 0; i < num_keyframes; i++) {
+			sv.demo_keyframes[i].time = LittleLong(sv.demo_keyframes[i].time);
+			sv.demo_keyframes[i].offset = LittleLong(sv.demo_keyframes[i].offset);
+		}
+
+		sv.num_demo_keyframes = num_keyframes;
+	}
+
+	Fs_Seek(sv.demo_file, start);
+
+	Com_Debug(DEBUG_SERVER, "Loaded %d demo keyframes\n", sv.num_demo_keyframes);
+}
+
+/**
+ * @brief Opens the specified demo file for playback. Demos which predate the
+ * versioned format are played in sequence, without seeking.
+ */
+void Sv_OpenDemo(const char *name) {
+	int32_t header[2];
+
+	sv.demo_file = Fs_OpenRead(va("demos/%s.demo", name));
+	if (!sv.demo_file) {
+		Com_Error(ERROR_DROP, "Couldn't open demos/%s.demo\n", name);
+	}
+
+	if (Fs_Read(sv.demo_file, header, sizeof(header), 1) == 1 &&
+	        (LittleLong(header[0]) == DEMO_IDENT || LittleLong(header[0]) == DEMO_WORLD_IDENT)) {
+
+		sv.demo_version = LittleLong(header[1]);
+
+		if (sv.demo_version > DEMO_VERSION) {
+			Com_Error(ERROR_DROP, "Demo %s is version %d, expected %d\n", name, sv.demo_version, DEMO_VERSION);
+		}
+
+		if (LittleLong(header[0]) == DEMO_WORLD_IDENT) {
+			sv.demo_world = true;
+			sv.demo_pov = Clampf(sv_demo_pov->integer, 0, MAX_CLIENTS - 1);
+
+			sv.demo_frames = Mem_TagMalloc(2 * sizeof(sv_world_frame_t), MEM_TAG_SERVER);
+			sv.demo_frames[0].frame_num = sv.demo_frames[1].frame_num = -1;
+
+			sv.demo_record = Mem_TagMalloc(MAX_DEMO_RECORD_SIZE, MEM_TAG_SERVER);
+			sv.demo_frame_num = -1;
+		}
+
+		Sv_LoadDemoIndex();
+	} else {
+		sv.demo_version = 0;
+		Fs_Seek(sv.demo_file, 0);
+	}
+}
+
+/**
+ * @brief Called when the end of the current demo is reached. Proceeds to the next
+ * demo in `sv_demo_list`, or shuts down the server.
+ */
+static void Sv_DemoCompleted(void) {
+
+	if (sv_demo_list->string[0]) {
+
+		const char *current_demo = sv.name;
+		const char *next_demo = g_strrstr(sv_demo_list->string, current_demo);
+		char demo_token[MAX_QPATH];
+
+		if (!next_demo) {
+
+			next_demo = sv_demo_list->string;
+		} else {
+
+			next_demo += strlen(current_demo);
+
+			if (next_demo[0] == ' ') {
+				next_demo++;
+			} else if (!next_demo[0]) {
+				next_demo = sv_demo_list->string;
+			}
+		}
+
+		const char *space = strchr(next_demo, ' ') ? : (next_demo + strlen(next_demo));
+		size_t len = space - next_demo;
+
+		strncpy(demo_token, next_demo, len);
+		demo_token[len] = 0;
+
+		if (demo_token[0]) {
+			Sv_InitServer(demo_token, SV_ACTIVE_DEMO);
+		} else {
+			Sv_ShutdownServer("Demo complete\n");
+		}
+	} else {
+		Sv_ShutdownServer("Demo complete\n");
+	}
+}
+
+/**
+ * @brief Reads the next message from a demo which predates the versioned format.
+ */
+static size_t Sv_ReadLegacyDemoMessage(byte *buffer) {
+	int32_t size;
+	int64_t r;
+
+	r = Fs_Read(sv.demo_file, &size, sizeof(size), 1);
+
+	if (r != 1) { // improperly terminated demo file
+		Com_Warn("Failed to read demo file\n");
+		Sv_DemoCompleted();
+		return 0;
+	}
+
+	size = LittleLong(size);
+
+	if (size == -1) { // properly terminated demo file
+		Sv_DemoCompleted();
+		return 0;
+	}
+
+	if (size > MAX_MSG_SIZE) { // corrupt demo file
+		Com_Warn("%d > MAX_MSG_SIZE\n", size);
+		Sv_DemoCompleted();
+		return 0;
+	}
+
+	r = Fs_Read(sv.demo_file, buffer, size, 1);
+
+	if (r != 1) {
+		Com_Warn("Incomplete or corrupt demo file\n");
+		Sv_DemoCompleted();
+		return 0;
+	}
+
+	return size;
+}
+
+/**
+ * @brief Reads the next original config strings record, after seeking.
+ */
+static size_t Sv_ReadDemoConfigStrings(byte *buffer) {
+	demo_record_t record;
+
+	const byte *data = sv.demo_config_strings + sv.demo_config_strings_read;
+	const size_t remaining = sv.demo_config_strings_size - sv.demo_config_strings_read;
+
+	if (remaining < sizeof(record)) {
+		sv.demo_config_strings_read = sv.demo_config_strings_size;
+		return 0;
+	}
+
+	memcpy(&record, data, sizeof(record));
+
+	const int32_t length = LittleLong(record.length);
+
+	if (length < 0 || length > MAX_MSG_SIZE || (size_t) length > remaining - sizeof(record)) {
+		Com_Warn("Corrupt demo index\n");
+		sv.demo_config_strings_read = sv.demo_config_strings_size;
+		return 0;
+	}
+
+	memcpy(buffer, data + sizeof(record), length);
+	sv.demo_config_strings_read += sizeof(record) + length;
+
+	return length;
+}
+
+/**
+ * @brief Parses a message from the header of a server recorded demo. The baselines
+ * are resolved, and the client number is rewritten to that of the point of view.
+ */
+static void Sv_ParseDemoWorldMessage(byte *buffer, size_t size) {
+	static entity_state_t null_state;
+
+	mem_buf_t msg = {
+		.data = buffer,
+		.size = size,
+		.max_size = size
+	};
+
+	while (msg.read < msg.size) {
+
+		switch (Net_ReadByte(&msg)) {
+			case SV_CMD_SERVER_DATA: {
+					Net_ReadLong(&msg); // protocol
+					Net_ReadLong(&msg); // game protocol
+					Net_ReadByte(&msg); // demo server
+					Net_ReadString(&msg); // game
+
+					if (msg.read + 2 > msg.size) {
+						return;
+					}
+
+					mem_buf_t client_num;
+					Mem_InitBuffer(&client_num, buffer + msg.read, 2);
+					Net_WriteShort(&client_num, sv.demo_pov);
+
+					msg.read += 2;
+					Net_ReadString(&msg); // level name
+				}
+				break;
+
+			case SV_CMD_CONFIG_STRING:
+				Net_ReadShort(&msg);
+				Net_ReadString(&msg);
+				break;
+
+			case SV_CMD_BASELINE: {
+					const uint16_t number = (uint16_t) Net_ReadShort(&msg);
+					const uint16_t bits = Net_ReadVarLong(&msg);
+
+					if (number >= MAX_ENTITIES) {
+						return;
+					}
+
+					Net_ReadDeltaEntity(&msg, &null_state, &sv.baselines[number], number, bits);
+				}
+				break;
+
+			case SV_CMD_CBUF_TEXT:
+				Net_ReadString(&msg);
+				break;
+
+			default:
+				return;
+		}
+	}
+}
+
+/**
+ * @brief Decodes the world record in `sv.demo_record`, and writes the resulting frame
+ * from the point of view of `sv.demo_pov` to `buffer`, followed by the messages sent
+ * to that client. If that client is not in game, the first client in game is used.
+ * @return The size of the message, or 0 if the record could not be played.
+ */
+static size_t Sv_ReadDemoWorld(byte *buffer, size_t length) {
+	static player_state_t null_state;
+
+	mem_buf_t in = {
+		.data = sv.demo_record,
+		.size = length,
+		.max_size = length
+	};
+
+	const int32_t frame_num = Net_ReadLong(&in);
+	const int32_t delta_frame_num = Net_ReadLong(&in);
+
+	sv_world_frame_t *frame = &sv.demo_frames[frame_num & 1];
+	const sv_world_frame_t *delta_frame = NULL;
+
+	if (delta_frame_num != -1) {
+		delta_frame = &sv.demo_frames[delta_frame_num & 1];
+
+		if (delta_frame_num != frame_num - 1 || delta_frame->frame_num != delta_frame_num) {
+			Com_Debug(DEBUG_SERVER, "Demo frame %d has no delta frame %d\n", frame_num, delta_frame_num);
+			frame->frame_num = -1;
+			return 0;
+		}
+	}
+
+	frame->frame_num = -1;
+
+	if (!Sv_ReadWorldPlayerStates(&in, delta_frame, frame) || !Sv_ReadWorldEntities(&in, delta_frame, frame)) {
+		Com_Warn("Corrupt demo frame %d\n", frame_num);
+		return 0;
+	}
+
+	frame->frame_num = frame_num;
+
+	// resolve the point of view
+	int32_t pov = sv.demo_pov;
+
+	if (!frame->clients[pov]) {
+		for (pov = 0; pov < MAX_CLIENTS; pov++) {
+			if (frame->clients[pov]) {
+				break;
+			}
+		}
+	}
+
+	const player_state_t *ps = pov < MAX_CLIENTS ? &frame->ps[pov] : &null_state;
+
+	// the client may only delta against the previous frame if it was sent
+	if (delta_frame && delta_frame_num != sv.demo_frame_num) {
+		delta_frame = NULL;
+	}
+
+	mem_buf_t out;
+	Mem_InitBuffer(&out, buffer, MAX_MSG_SIZE_FRAGMENTED);
+	out.allow_overflow = true;
+
+	Net_WriteByte(&out, SV_CMD_FRAME);
+	Net_WriteLong(&out, frame_num);
+	Net_WriteLong(&out, delta_frame ? delta_frame_num : -1);
+	Net_WriteByte(&out, 0); // rate dropped packets
+
+	Net_WriteDeltaPlayerState(&out, delta_frame ? &sv.demo_ps : &null_state, ps);
+
+	Sv_WriteWorldEntities(delta_frame, frame, &out);
+
+	if (out.overflowed || out.size > MAX_MSG_SIZE_FRAGMENTED - 16) {
+		Com_Warn("Demo frame %d exceeds MAX_MSG_SIZE_FRAGMENTED (%u), dropping\n", frame_num, (uint32_t) out.size);
+
+		sv.demo_frame_num = -1;
+		return 0;
+	}
+
+	sv.demo_ps = *ps;
+	sv.demo_frame_num = frame_num;
+
+	// followed by the messages sent to the point of view
+	while (true) {
+		const int32_t client = Net_ReadByte(&in);
+
+		if (client == DEMO_WORLD_END || client == -1) {
+			break;
+		}
+
+		const int32_t len = Net_ReadShort(&in);
+
+		if (len < 0 || in.read + len > in.size) {
+			Com_Warn("Corrupt demo frame %d\n", frame_num);
+			break;
+		}
+
+		if (client == DEMO_WORLD_ALL_CLIENTS || client == pov) {
+
+			if (out.size + len > MAX_MSG_SIZE_FRAGMENTED - 16) {
+				Com_Debug(DEBUG_SERVER, "Demo frame %d messages exceed MAX_MSG_SIZE_FRAGMENTED\n", frame_num);
+			} else {
+				Mem_WriteBuffer(&out, in.data + in.read, len);
+			}
+		}
+
+		in.read += len;
+	}
+
+	return out.size;
+}
+
+/**
+ * @brief Reads the next message from the current demo file into the specified buffer,
+ * of MAX_MSG_SIZE_FRAGMENTED bytes, returning the size of the message in bytes. After
+ * seeking, the original config strings and the keyframe records are read before the
+ * keyframe's message.
+ *
+ * FIXME This doesn't work with the new packetized overflow avoidance. Multiple
+ * messages can constitute a frame. We need a mechanism to indicate frame
+ * completion, or we should pace playback by the record time.
+ */
+size_t Sv_ReadDemoMessage(byte *buffer) {
+
+	if (sv.demo_version == 0) {
+		return Sv_ReadLegacyDemoMessage(buffer);
+	}
+
+	if (sv.demo_config_strings_read < sv.demo_config_strings_size) {
+		const size_t size = Sv_ReadDemoConfigStrings(buffer);
+		if (size) {
+			return size;
+		}
+	}
+
+	while (true) {
+		demo_record_t record;
+
+		if (Fs_Read(sv.demo_file, &record, sizeof(record), 1) != 1) { // improperly terminated demo file
+			Com_Warn("Failed to read demo file\n");
+			Sv_DemoCompleted();
+			return 0;
+		}
+
+		const int32_t length = LittleLong(record.length);
+
+		if (length == -1) { // properly terminated demo file
+			Sv_DemoCompleted();
+			return 0;
+		}
+
+		const demo_record_type_t type = LittleLong(record.type);
+
+		if (length < 0 || length > (type == DEMO_RECORD_WORLD ? MAX_DEMO_RECORD_SIZE : MAX_MSG_SIZE_FRAGMENTED)) {
+			Com_Warn("Invalid demo record length %d\n", length); // corrupt demo file
+			Sv_DemoCompleted();
+			return 0;
+		}
+
+		if (length == 0 ||
+		        (type == DEMO_RECORD_KEYFRAME && !sv.demo_seeking) ||
+		        (type == DEMO_RECORD_WORLD && !sv.demo_world)) {
+			Fs_Seek(sv.demo_file, Fs_Tell(sv.demo_file) + length);
+			continue;
+		}
+
+		if (Fs_Read(sv.demo_file, type == DEMO_RECORD_WORLD ? sv.demo_record : buffer, length, 1) != 1) {
+			Com_Warn("Incomplete or corrupt demo file\n");
+			Sv_DemoCompleted();
+			return 0;
+		}
+
+		if (type == DEMO_RECORD_WORLD) {
+			const size_t size = Sv_ReadDemoWorld(buffer, length);
+			if (size == 0) {
+				continue;
+			}
+
+			sv.demo_seeking = false;
+			sv.demo_time = LittleLong(record.time);
+
+			return size;
+		}
+
+		if (type == DEMO_RECORD_MESSAGE) {
+			if (sv.demo_world) {
+				Sv_ParseDemoWorldMessage(buffer, length);
+			}
+
+			sv.demo_seeking = false;
+			sv.demo_time = LittleLong(record.time);
+		}
+
+		return length;
+	}
+}
+
+/**
+ * @brief Seeks the current demo to the last keyframe at or before `time`, in
+ * milliseconds. The original values of any config strings which change during
+ * the demo are sent, followed by the keyframe's config strings and its
+ * uncompressed frame.
+ */
+bool Sv_SeekDemo(uint32_t time) {
+
+	if (!sv.num_demo_keyframes) {
+		Com_Print("Demo %s can not be seeked\n", sv.name);
+		return false;
+	}
+
+	int32_t lo = 0, hi = sv.num_demo_keyframes - 1;
+
+	while (lo < hi) {
+		const int32_t mid = (lo + hi + 1) / 2;
+		if ((uint32_t) sv.demo_keyframes[mid].time <= time) {
+			lo = mid;
+		} else {
+			hi = mid - 1;
+		}
+	}
+
+	const demo_keyframe_t *keyframe = &sv.demo_keyframes[lo];
+
+	if (!Fs_Seek(sv.demo_file, keyframe->offset)) {
+		Com_Warn("Failed to seek demo %s: %s\n", sv.name, Fs_LastError());
+		return false;
+	}
+
+	sv.demo_seeking = true;
+	sv.demo_config_strings_read = 0;
+	sv.demo_time = keyframe->time;
+
+	Com_Debug(DEBUG_SERVER, "Seeked demo %s to keyframe %d at %dms\n", sv.name, lo, keyframe->time);
+	return true;
+}
+
+/**
+ * @brief Closes the current demo, freeing its index.
+ */
+void Sv_CloseDemo(void) {
+
+	if (sv.demo_file) {
+		Fs_Close(sv.demo_file);
+		sv.demo_file = NULL;
+	}
+
+	if (sv.demo_keyframes) {
+		Mem_Free(sv.demo_keyframes);
+		sv.demo_keyframes = NULL;
+	}
+
+	if (sv.demo_config_strings) {
+		Mem_Free(sv.demo_config_strings);
+		sv.demo_config_strings = NULL;
+	}
+
+	if (sv.demo_frames) {
+		Mem_Free(sv.demo_frames);
+		sv.demo_frames = NULL;
+	}
+
+	if (sv.demo_record) {
+		Mem_Free(sv.demo_record);
+		sv.demo_record = NULL;
+	}
+}
+
+/**
+ * @brief The demo writer thread. Writes queued chunks to the demo file, until the
+ * NULL chunk is dequeued.
+ */
+static int Sv_DemoWriterThread(void *data) {
+	sv_demo_recorder_t *rec = data;
+
+	while (true) {
+		SDL_SemWait(rec->sem);
+
+		SDL_LockMutex(rec->lock);
+		GByteArray *chunk = g_queue_pop_head(rec->chunks);
+		SDL_UnlockMutex(rec->lock);
+
+		if (!chunk) {
+			break;
+		}
+
+		if (chunk->len && !atomic_load(&rec->failed)) {
+			if (Fs_Write(rec->file, chunk->data, chunk->len, 1) != 1) {
+				g_strlcpy(rec->error, Fs_LastError(), sizeof(rec->error)); // errors are per thread
+				atomic_store(&rec->failed, true);
+			}
+		}
+
+		g_byte_array_free(chunk, true);
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Queues the specified chunk for the writer thread.
+ */
+static void Sv_QueueDemoChunk(sv_demo_recorder_t *rec, GByteArray *chunk) {
+
+	SDL_LockMutex(rec->lock);
+	g_queue_push_tail(rec->chunks, chunk);
+	SDL_UnlockMutex(rec->lock);
+
+	SDL_SemPost(rec->sem);
+}
+
+/**
+ * @brief Queues the current chunk for the writer thread once it is full. If the writer
+ * has fallen too far behind, the chunk is dropped instead, along with any keyframes
+ * within it, and the next frame is recorded as a keyframe so that playback may resume.
+ */
+static void Sv_FlushDemoChunk(void) {
+	sv_demo_recorder_t *rec = sv.demo_recorder;
+
+	if (rec->chunk->len < SV_DEMO_CHUNK_SIZE) {
+		return;
+	}
+
+	SDL_LockMutex(rec->lock);
+	const guint pending = g_queue_get_length(rec->chunks);
+	SDL_UnlockMutex(rec->lock);
+
+	if (pending < SV_DEMO_MAX_CHUNKS) {
+		Sv_QueueDemoChunk(rec, rec->chunk);
+		rec->chunk = g_byte_array_sized_new(SV_DEMO_CHUNK_SIZE + MAX_DEMO_RECORD_SIZE);
+		return;
+	}
+
+	rec->offset -= rec->chunk->len;
+
+	while (rec->keyframes->len) {
+		const guint last = rec->keyframes->len - 1;
+		if (g_array_index(rec->keyframes, demo_keyframe_t, last).offset < rec->offset) {
+			break;
+		}
+		g_array_remove_index(rec->keyframes, last);
+	}
+
+	g_byte_array_set_size(rec->chunk, 0);
+
+	rec->resume = true;
+	rec->dropped_chunks++;
+
+	Com_Debug(DEBUG_SERVER, "Demo writer fell behind, dropped chunk %u\n", rec->dropped_chunks);
+}
+
+/**
+ * @brief Appends the specified data to the current chunk.
+ */
+static void Sv_WriteDemoData(const void *data, size_t len) {
+	sv_demo_recorder_t *rec = sv.demo_recorder;
+
+	g_byte_array_append(rec->chunk, data, (guint) len);
+	rec->offset += len;
+}
+
+/**
+ * @brief Appends a record containing `msg` to the current chunk, and clears `msg`.
+ */
+static void Sv_WriteDemoRecord(mem_buf_t *msg, demo_record_type_t type, uint32_t time) {
+
+	const demo_record_t record = {
+		.length = LittleLong((int32_t) msg->size),
+		.time = LittleLong((int32_t) time),
+		.type = LittleLong(type)
+	};
+
+	Sv_WriteDemoData(&record, sizeof(record));
+	Sv_WriteDemoData(msg->data, msg->size);
+
+	Mem_ClearBuffer(msg);
+}
+
+/**
+ * @brief Writes server_data, config_strings, and baselines.
+ */
+static void Sv_WriteDemoHeader(void) {
+	static entity_state_t null_state;
+	mem_buf_t msg;
+	byte buffer[MAX_MSG_SIZE];
+
+	Mem_InitBuffer(&msg, buffer, sizeof(buffer));
+
+	// write the server data
+	Net_WriteByte(&msg, SV_CMD_SERVER_DATA);
+	Net_WriteLong(&msg, PROTOCOL_MAJOR);
+	Net_WriteLong(&msg, svs.game->protocol);
+	Net_WriteByte(&msg, 1); // demo_server byte
+	Net_WriteString(&msg, Cvar_GetString("game"));
+	Net_WriteShort(&msg, 0); // the point of view is chosen on playback
+	Net_WriteString(&msg, sv.config_strings[CS_NAME]);
+
+	// and config_strings
+	for (int32_t i = 0; i < MAX_CONFIG_STRINGS; i++) {
+		if (*sv.config_strings[i] != '\0') {
+			if (msg.size + strlen(sv.config_strings[i]) + 32 > msg.max_size) { // write it out
+				Sv_WriteDemoRecord(&msg, DEMO_RECORD_MESSAGE, 0);
+			}
+
+			Net_WriteByte(&msg, SV_CMD_CONFIG_STRING);
+			Net_WriteShort(&msg, i);
+			Net_WriteString(&msg, sv.config_strings[i]);
+		}
+	}
+
+	// and baselines
+	for (int32_t i = 0; i < MAX_ENTITIES; i++) {
+		const entity_state_t *base = &sv.baselines[i];
+		if (!base->model1 && !base->sound && !base->effects) {
+			continue;
+		}
+
+		if (msg.size + 64 > msg.max_size) { // write it out
+			Sv_WriteDemoRecord(&msg, DEMO_RECORD_MESSAGE, 0);
+		}
+
+		Net_WriteByte(&msg, SV_CMD_BASELINE);
+		Net_WriteDeltaEntity(&msg, &null_state, base, true);
+	}
+
+	Net_WriteByte(&msg, SV_CMD_CBUF_TEXT);
+	Net_WriteString(&msg, "precache 0\n");
+
+	Sv_WriteDemoRecord(&msg, DEMO_RECORD_MESSAGE, 0);
+}
+
+/**
+ * @brief Writes the config strings which have changed since recording began, as
+ * records of the specified type. If `original` is true, their values at the beginning
+ * of the demo are written, otherwise their current values are written.
+ */
+static void Sv_WriteDemoConfigStrings(demo_record_type_t type, uint32_t time, bool original) {
+	sv_demo_recorder_t *rec = sv.demo_recorder;
+	mem_buf_t msg;
+	byte buffer[MAX_MSG_SIZE];
+
+	Mem_InitBuffer(&msg, buffer, sizeof(buffer));
+
+	for (int32_t i = 0; i < MAX_CONFIG_STRINGS; i++) {
+		if (rec->config_strings[i]) {
+
+			const char *s = original ? rec->config_strings[i] : sv.config_strings[i];
+
+			if (msg.size + strlen(s) + 32 > msg.max_size) { // write it out
+				Sv_WriteDemoRecord(&msg, type, time);
+			}
+
+			Net_WriteByte(&msg, SV_CMD_CONFIG_STRING);
+			Net_WriteShort(&msg, i);
+			Net_WriteString(&msg, s);
+		}
+	}
+
+	if (msg.size) {
+		Sv_WriteDemoRecord(&msg, type, time);
+	}
+}
+
+/**
+ * @brief Adds a keyframe to the demo index, followed by the config strings which
+ * have changed since recording began. The next world frame is uncompressed, so
+ * that playback may begin from here. Keyframes which resume recording after dropped
+ * chunks write the config strings as messages, so that sequential playback receives
+ * any changes which were dropped.
+ */
+static void Sv_WriteDemoKeyframe(uint32_t time) {
+	sv_demo_recorder_t *rec = sv.demo_recorder;
+
+	const demo_keyframe_t keyframe = {
+		.time = (int32_t) time,
+		.offset = (int32_t) rec->offset
+	};
+
+	g_array_append_val(rec->keyframes, keyframe);
+
+	Sv_WriteDemoConfigStrings(rec->resume ? DEMO_RECORD_MESSAGE : DEMO_RECORD_KEYFRAME, time, false);
+
+	rec->keyframe_time = time + DEMO_KEYFRAME_INTERVAL;
+	rec->resume = false;
+
+	Com_Debug(DEBUG_SERVER, "Demo keyframe at %ums\n", time);
+}
+
+/**
+ * @brief Copies off the player state of every client in game, and every entity
+ * which clients would be sent, regardless of visibility.
+ */
+static void Sv_BuildWorldFrame(sv_world_frame_t *frame) {
+
+	memset(frame->clients, 0, sizeof(frame->clients));
+
+	for (int32_t i = 0; i < sv_max_clients->integer; i++) {
+		const g_entity_t *ent = svs.clients[i].entity;
+
+		if (ent->in_use && ent->client) {
+			frame->clients[i] = true;
+			frame->ps[i] = ent->client->ps;
+		}
+	}
+
+	frame->num_entities = 0;
+
+	for (int32_t e = 1; e < svs.game->num_entities; e++) {
+		const g_entity_t *ent = ENTITY_FOR_NUM(e);
+
+		// ignore entities that are local to the server
+		if (ent->sv_flags & SVF_NO_CLIENT) {
+			continue;
+		}
+
+		// ignore entities without visible presence unless they have an effect
+		if (!ent->s.event && !ent->s.effects && !ent->s.trail && !ent->s.model1 && !ent->s.sound) {
+			continue;
+		}
+
+		entity_state_t *s = &frame->entities[frame->num_entities++];
+
+		*s = ent->s;
+		s->number = e;
+	}
+}
+
+/**
+ * @brief Begins recording the entire world to the specified demo file. If no name is
+ * specified, one is derived from the map name and the current time.
+ */
+void Sv_StartRecording(const char *name) {
+
+	if (sv.state != SV_ACTIVE_GAME) {
+		Com_Print("You must be running a game to record\n");
+		return;
+	}
+
+	if (sv.demo_recorder) {
+		Com_Print("Already recording\n");
+		return;
+	}
+
+	sv_demo_recorder_t *rec = Mem_TagMalloc(sizeof(*rec), MEM_TAG_SERVER);
+
+	if (name) {
+		g_snprintf(rec->filename, sizeof(rec->filename), "demos/%s.demo", name);
+	} else {
+		GDateTime *now = g_date_time_new_now_local();
+		gchar *time = g_date_time_format(now, "%Y-%m-%d_%H-%M-%S");
+
+		g_snprintf(rec->filename, sizeof(rec->filename), "demos/%s_%s.demo", sv.name, time);
+
+		g_free(time);
+		g_date_time_unref(now);
+	}
+
+	// open the demo file
+	if (!(rec->file = Fs_OpenWrite(rec->filename))) {
+		Com_Warn("Couldn't open %s\n", rec->filename);
+		Mem_Free(rec);
+		return;
+	}
+
+	rec->chunks = g_queue_new();
+
+	rec->lock = SDL_CreateMutex();
+	rec->sem = SDL_CreateSemaphore(0);
+
+	if (!(rec->thread = SDL_CreateThread(Sv_DemoWriterThread, __func__, rec))) {
+		Com_Warn("Couldn't create demo writer for %s: %s\n", rec->filename, SDL_GetError());
+
+		SDL_DestroySemaphore(rec->sem);
+		SDL_DestroyMutex(rec->lock);
+		g_queue_free(rec->chunks);
+
+		Fs_Close(rec->file);
+		Fs_Delete(rec->filename);
+
+		Mem_Free(rec);
+		return;
+	}
+
+	sv.demo_recorder = rec;
+
+	rec->frame_num = -1;
+	rec->frames[0].frame_num = rec->frames[1].frame_num = -1;
+
+	rec->keyframes = g_array_new(false, false, sizeof(demo_keyframe_t));
+
+	Mem_InitBuffer(&rec->messages, rec->messages_buffer, sizeof(rec->messages_buffer));
+
+	Mem_InitBuffer(&rec->record, rec->record_buffer, sizeof(rec->record_buffer));
+	rec->record.allow_overflow = true;
+
+	rec->chunk = g_byte_array_sized_new(SV_DEMO_CHUNK_SIZE + MAX_DEMO_RECORD_SIZE);
+
+	const int32_t header[] = {
+		LittleLong(DEMO_WORLD_IDENT),
+		LittleLong(DEMO_VERSION)
+	};
+
+	Sv_WriteDemoData(header, sizeof(header));
+
+	Sv_WriteDemoHeader();
+
+	Com_Print("Recording to %s\n", rec->filename);
+}
+
+/**
+ * @brief Writes the original config strings, the index and the trailer, and waits
+ * for the writer thread to complete the demo file.
+ */
+void Sv_StopRecording(void) {
+	sv_demo_recorder_t *rec = sv.demo_recorder;
+
+	if (!rec) {
+		return;
+	}
+
+	// terminate the records
+	const demo_record_t record = {
+		.length = LittleLong(-1)
+	};
+
+	Sv_WriteDemoData(&record, sizeof(record));
+
+	// write the original config strings, the index and the trailer
+	const demo_trailer_t trailer = {
+		.num_keyframes = LittleLong(rec->keyframes->len),
+		.offset = LittleLong((int32_t) rec->offset),
+		.ident = LittleLong(DEMO_IDENT)
+	};
+
+	Sv_WriteDemoConfigStrings(DEMO_RECORD_KEYFRAME, 0, true);
+
+	for (guint i = 0; i < rec->keyframes->len; i++) {
+		const demo_keyframe_t *in = &g_array_index(rec->keyframes, demo_keyframe_t, i);
+		const demo_keyframe_t out = {
+			.time = LittleLong(in->time),
+			.offset = LittleLong(in->offset)
+		};
+		Sv_WriteDemoData(&out, sizeof(out));
+	}
+
+	Sv_WriteDemoData(&trailer, sizeof(trailer));
+
+	Sv_QueueDemoChunk(rec, rec->chunk);
+	Sv_QueueDemoChunk(rec, NULL);
+
+	SDL_WaitThread(rec->thread, NULL);
+
+	if (atomic_load(&rec->failed)) {
+		Com_Warn("Failed to write %s: %s\n", rec->filename, rec->error);
+	}
+
+	if (rec->dropped_chunks) {
+		Com_Warn("Dropped %u chunks of %s, the disk could not keep up\n", rec->dropped_chunks, rec->filename);
+	}
+
+	if (rec->dropped_messages) {
+		Com_Warn("Dropped %u messages from %s, they exceeded MAX_DEMO_RECORD_SIZE\n", rec->dropped_messages, rec->filename);
+	}
+
+	Fs_Close(rec->file);
+
+	SDL_DestroySemaphore(rec->sem);
+	SDL_DestroyMutex(rec->lock);
+
+	g_queue_free(rec->chunks);
+	g_array_free(rec->keyframes, true);
+
+	for (int32_t i = 0; i < MAX_CONFIG_STRINGS; i++) {
+		if (rec->config_strings[i]) {
+			Mem_Free(rec->config_strings[i]);
+		}
+	}
+
+	Com_Print("Stopped recording %s\n", rec->filename);
+
+	Mem_Free(rec);
+	sv.demo_recorder = NULL;
+}
+
+/**
+ * @brief Records the world frame which was just sent to clients, along with the
+ * messages sent to them since the previous frame.
+ */
+void Sv_RecordFrame(void) {
+	sv_demo_recorder_t *rec = sv.demo_recorder;
+
+	if (!rec) {
+		return;
+	}
+
+	if (atomic_load(&rec->failed)) {
+		Sv_StopRecording();
+		return;
+	}
+
+	if (rec->frame_num == -1) {
+		rec->frame_num = sv.frame_num;
+	}
+
+	const uint32_t time = (sv.frame_num - rec->frame_num) * QUETOO_TICK_MILLIS;
+
+	sv_world_frame_t *frame = &rec->frames[sv.frame_num & 1];
+	const sv_world_frame_t *delta_frame = &rec->frames[(sv.frame_num - 1) & 1];
+
+	Sv_BuildWorldFrame(frame);
+
+	if (time >= rec->keyframe_time || rec->resume) {
+		Sv_WriteDemoKeyframe(time);
+		delta_frame = NULL;
+	} else if (delta_frame->frame_num != (int32_t) sv.frame_num - 1) {
+		delta_frame = NULL;
+	}
+
+	mem_buf_t *msg = &rec->record;
+
+	Net_WriteLong(msg, sv.frame_num);
+	Net_WriteLong(msg, delta_frame ? delta_frame->frame_num : -1);
+
+	Sv_WriteWorldPlayerStates(delta_frame, frame, msg);
+	Sv_WriteWorldEntities(delta_frame, frame, msg);
+
+	Mem_WriteBuffer(msg, rec->messages.data, rec->messages.size);
+	Net_WriteByte(msg, DEMO_WORLD_END);
+
+	Mem_ClearBuffer(&rec->messages);
+
+	if (msg->overflowed) {
+		Com_Warn("World frame %d exceeds MAX_DEMO_RECORD_SIZE, dropping\n", sv.frame_num);
+
+		frame->frame_num = -1;
+		Mem_ClearBuffer(msg);
+		return;
+	}
+
+	frame->frame_num = sv.frame_num;
+
+	Sv_WriteDemoRecord(msg, DEMO_RECORD_WORLD, time);
+
+	Sv_FlushDemoChunk();
+}
+
+/**
+ * @brief Records a message sent to the specified client, or to all clients if
+ * `client` is -1, to be written with the current world frame.
+ */
+void Sv_RecordMessage(const void *data, size_t len, int32_t client) {
+	sv_demo_recorder_t *rec = sv.demo_recorder;
+
+	if (!rec || !len) {
+		return;
+	}
+
+	if (rec->messages.size + len + 3 > rec->messages.max_size) {
+		rec->dropped_messages++;
+
+		Com_Debug(DEBUG_SERVER, "Demo messages exceed MAX_DEMO_RECORD_SIZE, dropped message %u\n", rec->dropped_messages);
+		return;
+	}
+
+	Net_WriteByte(&rec->messages, client == -1 ? DEMO_WORLD_ALL_CLIENTS : client);
+	Net_WriteShort(&rec->messages, (int32_t) len);
+	Net_WriteData(&rec->messages, data, len);
+}
+
+/**
+ * @brief Saves the original value of the config string at `index`, which is about
+ * to change, so that seeking within the demo may restore it.
+ */
+void Sv_TouchDemoConfigString(int32_t index) {
+	sv_demo_recorder_t *rec = sv.demo_recorder;
+
+	if (!rec) {
+		return;
+	}
+
+	if (!rec->config_strings[index]) {
+		rec->config_strings[index] = Mem_TagCopyString(sv.config_strings[index], MEM_TAG_SERVER);
+	}
+}
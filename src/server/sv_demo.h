@@ -0,0 +1,37 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#pragma once
+
+#include "sv_types.h"
+
+#ifdef __SV_LOCAL_H__
+void Sv_OpenDemo(const char *name);
+size_t Sv_ReadDemoMessage(byte *buffer);
+bool Sv_SeekDemo(uint32_t time);
+void Sv_CloseDemo(void);
+void Sv_StartRecording(const char *name);
+void Sv_StopRecording(void);
+void Sv_RecordFrame(void);
+void Sv_RecordMessage(const void *data, size_t len, int32_t client);
+void Sv_TouchDemoConfigString(int32_t index);
+#endif /* __SV_LOCAL_H__ */
@@ -68,10 +68,8 @@ static void Sv_WriteEntities(sv_frame_t *from, sv_frame_t *to, mem_buf_t *msg) {
 		}
 
 		if (new_num > old_num) { // the old entity isn't present in the new message
-			const int16_t bits = U_REMOVE;
-
 			Net_WriteShort(msg, old_num);
-			Net_WriteShort(msg, bits);
+			Net_WriteVarLong(msg, U_REMOVE);
 
 			old_index++;
 			continue;
@@ -131,6 +129,89 @@ void Sv_WriteClientFrame(sv_client_t *client, mem_buf_t *msg) {
 	Sv_WriteEntities(delta_frame, frame, msg);
 }
 
+/**
+ * @brief The potentially visible and hearable sets of the client frame being built.
+ */
+static byte sv_client_pvs[MAX_BSP_CLUSTER_BYTES];
+static byte sv_client_phs[MAX_BSP_CLUSTER_BYTES];
+
+/**
+ * @brief Resolves the potentially visible and hearable sets for the client's view origin.
+ * The clusters of all leafs near the view origin are merged, so that entities do not pop
+ * in and out as the view crosses cluster boundaries.
+ * @return False if the view origin is not within a visible cluster (e.g. noclip).
+ */
+static bool Sv_ClientPVS(const sv_client_t *client) {
+	static byte pvs[MAX_BSP_CLUSTER_BYTES], phs[MAX_BSP_CLUSTER_BYTES];
+	int32_t leafs[64];
+
+	const pm_state_t *pm = &client->entity->client->ps.pm_state;
+	const vec3_t view = Vec3_Add(pm->origin, pm->view_offset);
+
+	const size_t len = Cm_BoxLeafnums(Box3_FromCenterRadius(view, 8.f), leafs, lengthof(leafs), NULL, 0);
+	const size_t size = (Cm_NumClusters() + 7) >> 3;
+
+	memset(sv_client_pvs, 0, size);
+	memset(sv_client_phs, 0, size);
+
+	bool visible = false;
+
+	for (size_t i = 0; i < len; i++) {
+
+		if (leafs[i] == 0) {
+			continue;
+		}
+
+		const int32_t cluster = Cm_LeafCluster(leafs[i]);
+		if (cluster == -1) {
+			continue;
+		}
+
+		Cm_ClusterPVS(cluster, pvs);
+		Cm_ClusterPHS(cluster, phs);
+
+		for (size_t j = 0; j < size; j++) {
+			sv_client_pvs[j] |= pvs[j];
+			sv_client_phs[j] |= phs[j];
+		}
+
+		visible = true;
+	}
+
+	return visible;
+}
+
+/**
+ * @return True if the entity should be included in the frame currently being built.
+ */
+static bool Sv_EntityVisible(const sv_client_t *client, const g_entity_t *ent) {
+
+	if (ent == client->entity) {
+		return true;
+	}
+
+	if (ent->sv_flags & SVF_ALWAYS_SEND) {
+		return true;
+	}
+
+	// looping sounds and events are audible beyond the visible set
+	const byte *vis = (ent->s.sound || ent->s.event) ? sv_client_phs : sv_client_pvs;
+
+	const sv_entity_t *sent = &sv.entities[NUM_FOR_ENTITY(ent)];
+
+	if (sent->num_clusters == -1) {
+		return Cm_HeadnodeVisible(sent->top_node, vis);
+	}
+
+	for (int32_t i = 0; i < sent->num_clusters; i++) {
+		if (Cm_ClusterVisible(sent->clusters[i], vis)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
 /**
  * @brief Decides which entities are going to be visible to the client, and
  * copies off the player state.
@@ -149,6 +230,9 @@ void Sv_BuildClientFrame(sv_client_t *client) {
 	// grab the current player_state_t
 	frame->ps = cent->client->ps;
 
+	// resolve the visible set, falling back to everything when outside the world
+	const bool cull = sv_cull_entities->integer && Sv_ClientPVS(client);
+
 	// build up the list of relevant entities
 	frame->num_entities = 0;
 	frame->entity_state = svs.next_entity_state;
@@ -166,6 +250,11 @@ void Sv_BuildClientFrame(sv_client_t *client) {
 			continue;
 		}
 
+		// ignore entities the client can not possibly see
+		if (cull && !Sv_EntityVisible(client, ent)) {
+			continue;
+		}
+
 		// copy it to the circular entity_state_t array
 		entity_state_t *s = &svs.entity_states[svs.next_entity_state % svs.num_entity_states];
 		if (ent->s.number != e) {
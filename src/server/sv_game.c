@@ -95,6 +95,9 @@ static void Sv_SetConfigString(const int32_t index, const char *val) {
 		return;
 	}
 
+	// save the original value for any demo being recorded
+	Sv_TouchDemoConfigString(index);
+
 	// change the string in sv.config_strings
 	g_strlcpy(sv.config_strings[index], val, sizeof(sv.config_strings[0]));
 
@@ -199,23 +202,25 @@ static void Sv_WriteAngles(const vec3_t angles) {
 }
 
 /**
- * @brief
+ * @return True if `p2` is in the potentially visible set of `p1`.
  */
 static bool Sv_InPVS(const vec3_t p1, const vec3_t p2) {
+	byte pvs[MAX_BSP_CLUSTER_BYTES];
 
-	// TODO: Traces?
+	Cm_ClusterPVS(Sv_PointCluster(p1), pvs);
 
-	return true;
+	return Cm_ClusterVisible(Sv_PointCluster(p2), pvs);
 }
 
 /**
- * @brief
+ * @return True if `p2` is in the potentially hearable set of `p1`.
  */
 static bool Sv_InPHS(const vec3_t p1, const vec3_t p2) {
+	byte phs[MAX_BSP_CLUSTER_BYTES];
 
-	// TODO: Distance threshold?
+	Cm_ClusterPHS(Sv_PointCluster(p1), phs);
 
-	return true;
+	return Cm_ClusterVisible(Sv_PointCluster(p2), phs);
 }
 
 static void *game_handle;
@@ -300,6 +305,7 @@ void Sv_InitGame(void) {
 	import.LinkEntity = Sv_LinkEntity;
 	import.UnlinkEntity = Sv_UnlinkEntity;
 	import.BoxEntities = Sv_BoxEntities;
+	import.SphereEntities = Sv_SphereEntities;
 
 	import.Multicast = Sv_Multicast;
 	import.Unicast = Sv_Unicast;
@@ -138,9 +138,9 @@ static void Sv_ClearState(void) {
 
 	if (svs.initialized) { // if we were intialized, cleanup
 
-		if (sv.demo_file) {
-			Fs_Close(sv.demo_file);
-		}
+		Sv_StopRecording();
+
+		Sv_CloseDemo();
 	}
 
 	memset(&sv, 0, sizeof(sv));
@@ -250,7 +250,7 @@ static void Sv_LoadMedia(const char *server, sv_state_t state) {
 
 	if (state == SV_ACTIVE_DEMO) { // loading a demo
 
-		sv.demo_file = Fs_OpenRead(va("demos/%s.demo", sv.name));
+		Sv_OpenDemo(sv.name);
 		svs.spawn_count = 0;
 
 		Com_Print("  Loaded demo %s.\n", sv.name);
@@ -360,6 +360,10 @@ void Sv_InitServer(const char *server, sv_state_t state) {
 	Com_InitSubsystem(QUETOO_SERVER);
 
 	svs.initialized = true;
+
+	if (state == SV_ACTIVE_GAME && sv_demo_record->integer) {
+		Sv_StartRecording(NULL);
+	}
 }
 
 /**
@@ -28,11 +28,15 @@ sv_server_t sv; // per-level server info
 
 sv_client_t *sv_client; // current client
 
+cvar_t *sv_cull_entities;
 cvar_t *sv_demo_list;
+cvar_t *sv_demo_pov;
+cvar_t *sv_demo_record;
 cvar_t *sv_download_url;
 cvar_t *sv_enforce_time;
 cvar_t *sv_hostname;
 cvar_t *sv_max_clients;
+cvar_t *sv_multicast_radius;
 cvar_t *sv_public;
 cvar_t *sv_rcon_password; // password for remote server commands
 cvar_t *sv_timeout;
@@ -50,7 +54,7 @@ void Sv_DropClient(sv_client_t *cl) {
 	Mem_ClearBuffer(&cl->datagram.buffer);
 
 	if (cl->datagram.messages) {
-		g_list_free_full(cl->datagram.messages, Mem_Free);
+		g_list_free_full(cl->datagram.messages, g_free);
 	}
 
 	if (cl->state > SV_CLIENT_FREE) { // send the disconnect
@@ -767,6 +771,9 @@ void Sv_Frame(const uint32_t msec) {
 	// clamp the frame interval to 1 second of simulation
 	frame_delta = Minf(frame_delta, (uint32_t) (QUETOO_TICK_MILLIS * QUETOO_TICK_RATE));
 
+	// multicasts are counted from here, including those made by client commands
+	sv.multicast_bytes_sent = sv.multicast_bytes_saved = 0;
+
 	// read any pending packets from clients
 	Sv_ReadPackets();
 
@@ -791,6 +798,9 @@ void Sv_Frame(const uint32_t msec) {
 		// send the resulting frame to connected clients
 		Sv_SendClientPackets();
 
+		// and record it
+		Sv_RecordFrame();
+
 		// decrement the simulation time
 		frame_delta -= QUETOO_TICK_MILLIS;
 	}
@@ -807,8 +817,14 @@ void Sv_Frame(const uint32_t msec) {
  */
 static void Sv_InitLocal(void) {
 
+	sv_cull_entities = Cvar_Add("sv_cull_entities", "1", 0,
+	                            "Set to 0 to send all entities to all clients, regardless of visibility");
 	sv_demo_list = Cvar_Add("sv_demo_list", "", CVAR_SERVER_INFO,
 	                        "A list of demo names to cycle through");
+	sv_demo_pov = Cvar_Add("sv_demo_pov", "0", 0,
+	                       "The client number from whose point of view server recorded demos are played");
+	sv_demo_record = Cvar_Add("sv_demo_record", "0", CVAR_ARCHIVE,
+	                          "Set to 1 to record every map to a server demo");
 	sv_download_url = Cvar_Add("sv_download_url", "", CVAR_SERVER_INFO,
 	                           "The base URL for in-game HTTP downloads");
 	sv_enforce_time = Cvar_Add("sv_enforce_time", va("%d", CMD_MSEC_MAX_DRIFT_ERRORS), 0,
@@ -817,6 +833,8 @@ static void Sv_InitLocal(void) {
 	                       "The server hostname, visible in the server browser");
 	sv_max_clients = Cvar_Add("sv_max_clients", "8", CVAR_SERVER_INFO | CVAR_LATCH,
 	                          "The maximum number of clients the server will allow");
+	sv_multicast_radius = Cvar_Add("sv_multicast_radius", "2048", 0,
+	                               "The distance beyond which hearable, but not visible, multicasts are not sent, or 0 for no limit");
 	sv_public = Cvar_Add("sv_public", "0", CVAR_SERVER_INFO,
 	                     "Set to 1 to to advertise this server via the master server");
 	sv_rcon_password = Cvar_Add("rcon_password", "", 0,
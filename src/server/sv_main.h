@@ -29,11 +29,15 @@ void Sv_Frame(const uint32_t msec);
 
 #ifdef __SV_LOCAL_H__
 // cvars
+extern cvar_t *sv_cull_entities;
 extern cvar_t *sv_demo_list;
+extern cvar_t *sv_demo_pov;
+extern cvar_t *sv_demo_record;
 extern cvar_t *sv_download_url;
 extern cvar_t *sv_enforce_time;
 extern cvar_t *sv_hostname;
 extern cvar_t *sv_max_clients;
+extern cvar_t *sv_multicast_radius;
 extern cvar_t *sv_public;
 extern cvar_t *sv_rcon_password;
 extern cvar_t *sv_timeout;
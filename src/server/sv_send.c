@@ -52,9 +52,18 @@ void Sv_ClientPrint(const g_entity_t *ent, const int32_t level, const char *fmt,
 	vsprintf(string, fmt, args);
 	va_end(args);
 
-	Net_WriteByte(&cl->net_chan.message, SV_CMD_PRINT);
-	Net_WriteByte(&cl->net_chan.message, level);
-	Net_WriteString(&cl->net_chan.message, string);
+	byte buffer[sizeof(string) + 8];
+	mem_buf_t msg;
+
+	Mem_InitBuffer(&msg, buffer, sizeof(buffer));
+
+	Net_WriteByte(&msg, SV_CMD_PRINT);
+	Net_WriteByte(&msg, level);
+	Net_WriteString(&msg, string);
+
+	Mem_WriteBuffer(&cl->net_chan.message, msg.data, msg.size);
+
+	Sv_RecordMessage(msg.data, msg.size, (int32_t) (n - 1));
 }
 
 /**
@@ -83,6 +92,15 @@ void Sv_BroadcastPrint(const int32_t level, const char *fmt, ...) {
 		Com_Print("%s", copy);
 	}
 
+	byte buffer[sizeof(string) + 8];
+	mem_buf_t msg;
+
+	Mem_InitBuffer(&msg, buffer, sizeof(buffer));
+
+	Net_WriteByte(&msg, SV_CMD_PRINT);
+	Net_WriteByte(&msg, level);
+	Net_WriteString(&msg, string);
+
 	for (i = 0, cl = svs.clients; i < sv_max_clients->integer; i++, cl++) {
 
 		if (level < cl->message_level) {
@@ -93,10 +111,10 @@ void Sv_BroadcastPrint(const int32_t level, const char *fmt, ...) {
 			continue;
 		}
 
-		Net_WriteByte(&cl->net_chan.message, SV_CMD_PRINT);
-		Net_WriteByte(&cl->net_chan.message, level);
-		Net_WriteString(&cl->net_chan.message, string);
+		Mem_WriteBuffer(&cl->net_chan.message, msg.data, msg.size);
 	}
+
+	Sv_RecordMessage(msg.data, msg.size, -1);
 }
 
 /**
@@ -173,18 +191,51 @@ void Sv_Unicast(const g_entity_t *ent, const bool reliable) {
 		} else {
 			Sv_ClientDatagramMessage(cl, sv.multicast.data, sv.multicast.size);
 		}
+
+		Sv_RecordMessage(sv.multicast.data, sv.multicast.size, n - 1);
 	}
 
 	Mem_ClearBuffer(&sv.multicast);
 }
 
+/**
+ * @return True if the client should receive a multicast from `origin`, given the visible
+ * and hearable sets of the origin's cluster.
+ */
+static bool Sv_MulticastVisible(const sv_client_t *cl, const vec3_t origin, const byte *pvs, const byte *phs) {
+
+	const pm_state_t *pm = &cl->entity->client->ps.pm_state;
+	const vec3_t view = Vec3_Add(pm->origin, pm->view_offset);
+
+	const int32_t cluster = Sv_PointCluster(view);
+	if (cluster == -1) {
+		return true;
+	}
+
+	if (Cm_ClusterVisible(cluster, pvs)) {
+		return true;
+	}
+
+	if (phs && Cm_ClusterVisible(cluster, phs)) {
+		if (sv_multicast_radius->value) {
+			return Vec3_Distance(origin, view) <= sv_multicast_radius->value;
+		}
+		return true;
+	}
+
+	return false;
+}
+
 /**
  * @brief Sends the contents of sv.multicast to a subset of the clients,
- * then clears sv.multicast.
+ * then clears sv.multicast. Multicasts to the PVS are sent to clients that may see the
+ * origin. Multicasts to the PHS are also sent to clients that may hear the origin, and
+ * are within sv_multicast_radius of it.
  */
 void Sv_Multicast(const vec3_t origin, multicast_t to, EntityFilterFunc filter) {
+	byte pvs[MAX_BSP_CLUSTER_BYTES], phs[MAX_BSP_CLUSTER_BYTES];
 
-	bool reliable = false;
+	bool reliable = false, hearable = false;
 
 	switch (to) {
 		case MULTICAST_ALL_R:
@@ -197,6 +248,7 @@ void Sv_Multicast(const vec3_t origin, multicast_t to, EntityFilterFunc filter)
 			reliable = true;
 			__attribute__((fallthrough));
 		case MULTICAST_PHS:
+			hearable = true;
 			break;
 
 		case MULTICAST_PVS_R:
@@ -211,6 +263,26 @@ void Sv_Multicast(const vec3_t origin, multicast_t to, EntityFilterFunc filter)
 			return;
 	}
 
+	// resolve the sets of the origin, unless it is not within a visible cluster
+	bool cull = false;
+
+	if (to != MULTICAST_ALL && to != MULTICAST_ALL_R) {
+		const int32_t cluster = Sv_PointCluster(origin);
+		if (cluster != -1) {
+			Cm_ClusterPVS(cluster, pvs);
+			if (hearable) {
+				Cm_ClusterPHS(cluster, phs);
+			}
+			cull = true;
+		}
+	}
+
+	// messages to all clients are recorded once, others are recorded per recipient
+	const bool everyone = (to == MULTICAST_ALL || to == MULTICAST_ALL_R) && !filter;
+	if (everyone) {
+		Sv_RecordMessage(sv.multicast.data, sv.multicast.size, -1);
+	}
+
 	// send the data to all relevant clients
 	sv_client_t *cl = svs.clients;
 	for (int32_t j = 0; j < sv_max_clients->integer; j++, cl++) {
@@ -227,33 +299,38 @@ void Sv_Multicast(const vec3_t origin, multicast_t to, EntityFilterFunc filter)
 			continue;
 		}
 
-		if (to != MULTICAST_ALL && to != MULTICAST_ALL_R) {
-			// TODO: Some basic tracing or just distance attenuation?
-		}
-
 		if (filter) { // allow the game module to filter the recipients
 			if (!filter(cl->entity)) {
 				continue;
 			}
 		}
 
+		if (cull && !Sv_MulticastVisible(cl, origin, pvs, hearable ? phs : NULL)) {
+			sv.multicast_bytes_saved += sv.multicast.size;
+			continue;
+		}
+
+		if (!everyone) {
+			Sv_RecordMessage(sv.multicast.data, sv.multicast.size, j);
+		}
+
 		if (reliable) {
 			Mem_WriteBuffer(&cl->net_chan.message, sv.multicast.data, sv.multicast.size);
 		} else {
 			Sv_ClientDatagramMessage(cl, sv.multicast.data, sv.multicast.size);
 		}
+
+		sv.multicast_bytes_sent += sv.multicast.size;
 	}
 
 	Mem_ClearBuffer(&sv.multicast);
 }
 
-
-
 /**
  * @brief
  */
 static void Sv_SendClientDatagram(sv_client_t *cl) {
-	byte buffer[MAX_MSG_SIZE];
+	byte buffer[MAX_MSG_SIZE_FRAGMENTED];
 	mem_buf_t buf;
 
 	Sv_BuildClientFrame(cl);
@@ -268,9 +345,18 @@ static void Sv_SendClientDatagram(sv_client_t *cl) {
 	Sv_WriteClientFrame(cl, &buf);
 
 	// the frame itself (player state and delta entities) must fit into a single message,
-	// since it is parsed as a single command by the client
-	if (buf.overflowed || buf.size > MAX_MSG_SIZE - 16) {
-		Com_Error(ERROR_DROP, "Frame exceeds MAX_MSG_SIZE (%u)\n", (uint32_t) buf.size);
+	// since it is parsed as a single command by the client. The message is reassembled
+	// from fragments, alongside any reliable message, and the client is dropped should it
+	// not fit, as it could otherwise never receive another frame.
+	const net_chan_t *chan = &cl->net_chan;
+	const size_t reliable_size = chan->reliable_size ? chan->reliable_size : chan->message.size;
+
+	if (buf.overflowed || buf.size + reliable_size > MAX_MSG_SIZE_FRAGMENTED - 16) {
+		Com_Warn("Frame for %s exceeds MAX_MSG_SIZE_FRAGMENTED (%u)\n",
+				 Sv_NetaddrToString(cl), (uint32_t) buf.size);
+
+		Sv_KickClient(cl, "Frame overflowed");
+		return;
 	}
 
 	// but we can packetize the remaining datagram messages, which are parsed individually
@@ -300,47 +386,6 @@ static void Sv_SendClientDatagram(sv_client_t *cl) {
 	cl->frame_size[sv.frame_num % QUETOO_TICK_RATE] = frame_size;
 }
 
-/**
- * @brief
- */
-static void Sv_DemoCompleted(void) {
-
-	if (sv_demo_list->string[0]) {
-
-		const char *current_demo = sv.name;
-		const char *next_demo = g_strrstr(sv_demo_list->string, current_demo);
-		char demo_token[MAX_QPATH];
-
-		if (!next_demo) {
-
-			next_demo = sv_demo_list->string;
-		} else {
-
-			next_demo += strlen(current_demo);
-
-			if (next_demo[0] == ' ') {
-				next_demo++;
-			} else if (!next_demo[0]) {
-				next_demo = sv_demo_list->string;
-			}
-		}
-
-		const char *space = strchr(next_demo, ' ') ? : (next_demo + strlen(next_demo));
-		size_t len = space - next_demo;
-
-		strncpy(demo_token, next_demo, len);
-		demo_token[len] = 0;
-
-		if (demo_token[0]) {
-			Sv_InitServer(demo_token, SV_ACTIVE_DEMO);
-		} else {
-			Sv_ShutdownServer("Demo complete\n");
-		}
-	} else {
-		Sv_ShutdownServer("Demo complete\n");
-	}
-}
-
 /**
  * @brief Returns true if the client is over its current bandwidth estimation
  * and should not be sent another packet.
@@ -372,50 +417,6 @@ static bool Sv_RateDrop(sv_client_t *cl) {
 	return false;
 }
 
-/**
- * @brief Reads the next frame from the current demo file into the specified buffer,
- * returning the size of the frame in bytes.
- *
- * FIXME This doesn't work with the new packetized overflow avoidance. Multiple
- * messages can constitute a frame. We need a mechanism to indicate frame
- * completion, or we need a timecode in our demos.
- */
-static size_t Sv_GetDemoMessage(byte *buffer) {
-	int32_t size;
-	int64_t r;
-
-	r = Fs_Read(sv.demo_file, &size, sizeof(size), 1);
-
-	if (r != 1) { // improperly terminated demo file
-		Com_Warn("Failed to read demo file\n");
-		Sv_DemoCompleted();
-		return 0;
-	}
-
-	size = LittleLong(size);
-
-	if (size == -1) { // properly terminated demo file
-		Sv_DemoCompleted();
-		return 0;
-	}
-
-	if (size > MAX_MSG_SIZE) { // corrupt demo file
-		Com_Warn("%d > MAX_MSG_SIZE\n", size);
-		Sv_DemoCompleted();
-		return 0;
-	}
-
-	r = Fs_Read(sv.demo_file, buffer, size, 1);
-
-	if (r != 1) {
-		Com_Warn("Incomplete or corrupt demo file\n");
-		Sv_DemoCompleted();
-		return 0;
-	}
-
-	return size;
-}
-
 /**
  * @brief Send the frame and all pending datagram messages since the last frame.
  */
@@ -442,10 +443,10 @@ void Sv_SendClientPackets(void) {
 		}
 
 		if (sv.state == SV_ACTIVE_DEMO) { // send the demo packet
-			byte buffer[MAX_MSG_SIZE];
+			byte buffer[MAX_MSG_SIZE_FRAGMENTED];
 			size_t size;
 
-			if ((size = Sv_GetDemoMessage(buffer))) {
+			if ((size = Sv_ReadDemoMessage(buffer))) {
 				Netchan_Transmit(&cl->net_chan, buffer, size);
 			} else {
 				break;    // recording is done, so we're done
@@ -52,7 +52,7 @@ typedef struct {
 	int32_t clusters[MAX_ENT_CLUSTERS];
 	int32_t num_clusters; // if -1, use top_node
 
-	struct sv_sector_s *sector;
+	int32_t node; // the leaf in the world tree, or 0 if not linked
 
 	mat4_t matrix;
 	mat4_t inverse_matrix;
@@ -68,6 +68,74 @@ typedef enum {
 	SV_ACTIVE_DEMO
 } sv_state_t;
 
+/**
+ * @brief A frame of the entire world, as recorded by the server or decoded from
+ * a server recorded demo. Entities are sorted by number.
+ */
+typedef struct {
+	int32_t frame_num; // -1 if this frame may not be delta compressed against
+
+	bool clients[MAX_CLIENTS]; // true for clients which are in game
+	player_state_t ps[MAX_CLIENTS];
+
+	entity_state_t entities[MAX_ENTITIES];
+	uint16_t num_entities;
+} sv_world_frame_t;
+
+/**
+ * @brief Recorded demos are handed to the writer thread in chunks of this size.
+ */
+#define SV_DEMO_CHUNK_SIZE 0x40000
+
+/**
+ * @brief If the writer thread falls this many chunks behind, further chunks are
+ * dropped rather than queued.
+ */
+#define SV_DEMO_MAX_CHUNKS 16
+
+/**
+ * @brief The server demo recorder writes the entire world once per frame, so that
+ * any client's point of view may be played back. Records are accumulated in chunks,
+ * which are written by a dedicated thread so that disk access never stalls the frame.
+ * Should the disk fail to keep up, whole chunks are dropped, and recording resumes
+ * with a keyframe.
+ */
+typedef struct {
+	char filename[MAX_OS_PATH];
+	file_t *file;
+
+	int32_t frame_num; // the frame recording began on, or -1
+
+	uint32_t keyframe_time; // the time of the next keyframe
+	GArray *keyframes; // the demo index
+
+	char *config_strings[MAX_CONFIG_STRINGS]; // the original values of changed config strings
+
+	sv_world_frame_t frames[2]; // the current and previous frames, by frame number
+
+	// the messages sent to clients during the current frame
+	mem_buf_t messages;
+	byte messages_buffer[MAX_DEMO_RECORD_SIZE];
+	uint32_t dropped_messages; // the messages dropped because they exceeded the buffer
+
+	// the world record being written
+	mem_buf_t record;
+	byte record_buffer[MAX_DEMO_RECORD_SIZE];
+
+	GByteArray *chunk; // the records pending submission to the writer thread
+	int64_t offset; // the file offset of the end of the current chunk
+
+	SDL_Thread *thread;
+	SDL_mutex *lock;
+	SDL_sem *sem; // counts the queued chunks
+	GQueue *chunks; // the chunks pending write, terminated by NULL
+	uint32_t dropped_chunks; // the chunks dropped because the writer fell behind
+	bool resume; // set when a chunk is dropped, so that the next frame is a keyframe
+
+	atomic_bool failed; // set by the writer thread if a write fails
+	char error[MAX_STRING_CHARS]; // the error of the failed write, set before failed
+} sv_demo_recorder_t;
+
 /**
  * @brief The sv_server_t struct is wiped at each level load.
  */
@@ -91,8 +159,33 @@ typedef struct {
 	mem_buf_t multicast;
 	byte multicast_buffer[MAX_MSG_SIZE];
 
+	// multicast bandwidth accounting for the most recent frame
+	size_t multicast_bytes_sent;
+	size_t multicast_bytes_saved; // bytes not sent to clients that could not see or hear them
+
 	// demo server information
 	file_t *demo_file;
+	int32_t demo_version; // 0 for demos which predate the versioned format
+	uint32_t demo_time; // the time of the most recently read message
+
+	demo_keyframe_t *demo_keyframes; // the demo index
+	int32_t num_demo_keyframes;
+
+	byte *demo_config_strings; // the original config strings, sent when seeking
+	size_t demo_config_strings_size;
+	size_t demo_config_strings_read;
+
+	bool demo_seeking; // true until the keyframe's message has been read
+
+	// server recorded demos are played from the point of view of a single client
+	bool demo_world;
+	int32_t demo_pov;
+	sv_world_frame_t *demo_frames; // the current and previous frames, by frame number
+	byte *demo_record; // the world record being read
+	player_state_t demo_ps; // the player state of the most recently sent frame
+	int32_t demo_frame_num; // the most recently sent frame, or -1
+
+	sv_demo_recorder_t *demo_recorder; // the demo being recorded, if any
 } sv_server_t;
 
 typedef struct {
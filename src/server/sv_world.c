@@ -22,84 +22,276 @@
 #include "sv_local.h"
 
 /**
- * @brief The world is divided into evenly sized sectors to aid in entity
- * management. This works like a meta-BSP tree, providing fast searches via
- * recursion to find entities within an arbitrary box.
+ * @brief The world is partitioned by a dynamic bounding volume tree. Every
+ * linked entity occupies one leaf, whose bounds are fattened so that small
+ * movements do not require the tree to be restructured. Nodes are pooled, so
+ * linking and unlinking entities never allocates. Node 0 is reserved as null.
  */
-typedef struct sv_sector_s {
-	int32_t axis; // -1 = leaf
-	float dist;
-	struct sv_sector_s *children[2];
-	GList *entities;
-} sv_sector_t;
+typedef struct {
+	box3_t bounds; // fattened for leafs
+	int32_t parent; // or the next free node
+	int32_t children[2]; // 0 for leafs
+	int32_t height; // 0 for leafs
+	g_entity_t *ent;
+} sv_world_node_t;
 
-#define SECTOR_DEPTH	4
-#define SECTOR_NODES	32
+#define WORLD_NODES		(MAX_ENTITIES * 2)
+#define WORLD_MARGIN	8.f
+#define WORLD_STACK		128
 
 /**
- * @brief The world structure contains all sectors and also the current query
- * context issued to Sv_BoxEntities.
+ * @brief The world structure contains the entity tree and its node pool.
  */
 typedef struct {
-	sv_sector_t sectors[SECTOR_NODES];
-	uint16_t num_sectors;
+	sv_world_node_t nodes[WORLD_NODES];
+	int32_t root;
+	int32_t free_node;
+} sv_world_t;
 
-	box3_t box;
+static sv_world_t sv_world;
 
-	g_entity_t **box_entities;
-	size_t num_box_entities, max_box_entities;
+/**
+ * @return A node from the pool.
+ */
+static int32_t Sv_AllocNode(void) {
 
-	uint32_t box_type; // BOX_SOLID, BOX_TRIGGER, ..
-} sv_world_t;
+	const int32_t n = sv_world.free_node;
+	if (n == 0) {
+		Com_Error(ERROR_DROP, "WORLD_NODES\n");
+	}
 
-static sv_world_t sv_world;
+	sv_world_node_t *node = &sv_world.nodes[n];
+	sv_world.free_node = node->parent;
+
+	memset(node, 0, sizeof(*node));
+	return n;
+}
+
+/**
+ * @brief Returns the specified node to the pool.
+ */
+static void Sv_FreeNode(int32_t n) {
+
+	sv_world.nodes[n].parent = sv_world.free_node;
+	sv_world.free_node = n;
+}
+
+/**
+ * @return The surface area of the bounds, which is the insertion cost metric.
+ */
+static float Sv_NodeArea(const box3_t bounds) {
+	const vec3_t size = Box3_Size(bounds);
+	return 2.f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+/**
+ * @brief Replaces the child `old_child` of `parent` with `new_child`, or sets the
+ * root if `parent` is null.
+ */
+static void Sv_ReplaceChild(int32_t parent, int32_t old_child, int32_t new_child) {
+
+	if (parent) {
+		sv_world_node_t *p = &sv_world.nodes[parent];
+		if (p->children[0] == old_child) {
+			p->children[0] = new_child;
+		} else {
+			p->children[1] = new_child;
+		}
+	} else {
+		sv_world.root = new_child;
+	}
+}
+
+/**
+ * @brief Refits the bounds and height of the specified internal node.
+ */
+static void Sv_RefitNode(int32_t n) {
+
+	sv_world_node_t *node = &sv_world.nodes[n];
+
+	const sv_world_node_t *a = &sv_world.nodes[node->children[0]];
+	const sv_world_node_t *b = &sv_world.nodes[node->children[1]];
+
+	node->bounds = Box3_Union(a->bounds, b->bounds);
+	node->height = 1 + Maxi(a->height, b->height);
+}
 
 /**
- * @brief Builds a uniformly subdivided tree for the given world size.
+ * @brief Rotates the taller grandchild of the specified node up, if the node is
+ * imbalanced.
+ * @return The root of the balanced subtree.
  */
-static sv_sector_t *Sv_CreateSector(int32_t depth, const box3_t bounds) {
-	sv_sector_t *sector = &sv_world.sectors[sv_world.num_sectors];
-	sv_world.num_sectors++;
+static int32_t Sv_BalanceNode(int32_t a) {
 
-	if (depth == SECTOR_DEPTH) {
-		sector->axis = -1;
-		sector->children[0] = sector->children[1] = NULL;
-		return sector;
+	sv_world_node_t *node_a = &sv_world.nodes[a];
+	if (node_a->height < 2) {
+		return a;
 	}
 
-	vec3_t size = Box3_Size(bounds);
+	const int32_t balance = sv_world.nodes[node_a->children[1]].height -
+	                        sv_world.nodes[node_a->children[0]].height;
 
-	if (size.x > size.y) {
-		sector->axis = 0;
+	int32_t side;
+	if (balance > 1) {
+		side = 1;
+	} else if (balance < -1) {
+		side = 0;
 	} else {
-		sector->axis = 1;
+		return a;
 	}
 
-	sector->dist = 0.5f * (bounds.maxs.xyz[sector->axis] + bounds.mins.xyz[sector->axis]);
+	// promote the taller child, b, to replace a
+	const int32_t b = node_a->children[side];
+	sv_world_node_t *node_b = &sv_world.nodes[b];
 
-	box3_t bounds1 = bounds, bounds2 = bounds;
+	const int32_t c = node_b->children[0];
+	const int32_t d = node_b->children[1];
 
-	bounds1.maxs.xyz[sector->axis] = bounds2.mins.xyz[sector->axis] = sector->dist;
+	node_b->parent = node_a->parent;
+	node_a->parent = b;
 
-	sector->children[0] = Sv_CreateSector(depth + 1, bounds2);
-	sector->children[1] = Sv_CreateSector(depth + 1, bounds1);
+	Sv_ReplaceChild(node_b->parent, a, b);
 
-	return sector;
+	// keep the taller of b's children, and hand the shorter one down to a
+	int32_t keep = c, give = d;
+	if (sv_world.nodes[d].height > sv_world.nodes[c].height) {
+		keep = d, give = c;
+	}
+
+	node_b->children[0] = a;
+	node_b->children[1] = keep;
+
+	node_a->children[side] = give;
+	sv_world.nodes[give].parent = a;
+
+	Sv_RefitNode(a);
+	Sv_RefitNode(b);
+
+	return b;
 }
 
 /**
- * @brief Resolve our sectors for a newly loaded level. This is called prior to
- * linking any entities.
+ * @brief Refits and balances the tree from the specified node to the root.
  */
-void Sv_InitWorld(void) {
+static void Sv_RefitTree(int32_t n) {
+
+	while (n) {
+		n = Sv_BalanceNode(n);
+		Sv_RefitNode(n);
+		n = sv_world.nodes[n].parent;
+	}
+}
+
+/**
+ * @brief Inserts the specified leaf into the tree, pairing it with the sibling
+ * which minimizes the growth in surface area.
+ */
+static void Sv_InsertLeaf(int32_t leaf) {
+
+	sv_world_node_t *node = &sv_world.nodes[leaf];
+
+	if (sv_world.root == 0) {
+		sv_world.root = leaf;
+		node->parent = 0;
+		return;
+	}
+
+	const box3_t bounds = node->bounds;
+
+	int32_t sibling = sv_world.root;
+	while (sv_world.nodes[sibling].height) {
+		const sv_world_node_t *s = &sv_world.nodes[sibling];
+
+		const float area = Sv_NodeArea(s->bounds);
+		const float combined_area = Sv_NodeArea(Box3_Union(s->bounds, bounds));
+
+		// the cost of creating a new parent for this node and the leaf
+		const float cost = 2.f * combined_area;
+
+		// the minimum cost of pushing the leaf further down the tree
+		const float inheritance_cost = 2.f * (combined_area - area);
+
+		float child_cost[2];
+		for (int32_t i = 0; i < 2; i++) {
+			const sv_world_node_t *child = &sv_world.nodes[s->children[i]];
+
+			child_cost[i] = Sv_NodeArea(Box3_Union(child->bounds, bounds)) + inheritance_cost;
+			if (child->height) {
+				child_cost[i] -= Sv_NodeArea(child->bounds);
+			}
+		}
+
+		if (cost < child_cost[0] && cost < child_cost[1]) {
+			break;
+		}
+
+		sibling = s->children[child_cost[0] < child_cost[1] ? 0 : 1];
+	}
+
+	const int32_t parent = Sv_AllocNode();
+	sv_world_node_t *p = &sv_world.nodes[parent];
+
+	p->parent = sv_world.nodes[sibling].parent;
+	p->children[0] = sibling;
+	p->children[1] = leaf;
+
+	Sv_ReplaceChild(p->parent, sibling, parent);
 
-	for (uint16_t i = 0; i < sv_world.num_sectors; i++) {
-		g_list_free(sv_world.sectors[i].entities);
+	sv_world.nodes[sibling].parent = parent;
+	sv_world.nodes[leaf].parent = parent;
+
+	Sv_RefitTree(parent);
+}
+
+/**
+ * @brief Removes the specified leaf from the tree, collapsing its parent.
+ */
+static void Sv_RemoveLeaf(int32_t leaf) {
+
+	if (leaf == sv_world.root) {
+		sv_world.root = 0;
+		return;
 	}
 
+	const int32_t parent = sv_world.nodes[leaf].parent;
+	const sv_world_node_t *p = &sv_world.nodes[parent];
+
+	const int32_t grandparent = p->parent;
+	const int32_t sibling = p->children[p->children[0] == leaf ? 1 : 0];
+
+	Sv_ReplaceChild(grandparent, parent, sibling);
+	sv_world.nodes[sibling].parent = grandparent;
+
+	Sv_FreeNode(parent);
+
+	Sv_RefitTree(grandparent);
+}
+
+/**
+ * @brief Removes the specified entity's leaf from the tree, if it has one.
+ */
+static void Sv_UnlinkLeaf(sv_entity_t *sent) {
+
+	if (sent->node) {
+		Sv_RemoveLeaf(sent->node);
+		Sv_FreeNode(sent->node);
+		sent->node = 0;
+	}
+}
+
+/**
+ * @brief Resets the entity tree for a newly loaded level. This is called prior to
+ * linking any entities.
+ */
+void Sv_InitWorld(void) {
+
 	memset(&sv_world, 0, sizeof(sv_world));
 
-	Sv_CreateSector(0, sv.cm_models[0]->bounds);
+	for (int32_t i = 1; i < WORLD_NODES - 1; i++) {
+		sv_world.nodes[i].parent = i + 1;
+	}
+
+	sv_world.free_node = 1;
 }
 
 /**
@@ -110,12 +302,10 @@ void Sv_UnlinkEntity(g_entity_t *ent) {
 
 	sv_entity_t *sent = &sv.entities[NUM_FOR_ENTITY(ent)];
 
-	if (sent->sector) {
-		sv_sector_t *sector = (sv_sector_t *) sent->sector;
-		sector->entities = g_list_remove(sector->entities, ent);
+	Sv_UnlinkLeaf(sent);
 
-		memset(sent, 0, sizeof(*sent));
-	}
+	// non-solid entities have clusters but no leaf, and must not keep them
+	memset(sent, 0, sizeof(*sent));
 }
 
 /**
@@ -130,10 +320,8 @@ void Sv_LinkEntity(g_entity_t *ent) {
 		return;
 	}
 
-	// remove it from its current sector
-	Sv_UnlinkEntity(ent);
-
-	if (!ent->in_use) { // and if its free, we're done
+	if (!ent->in_use) { // if its free, remove it and we're done
+		Sv_UnlinkEntity(ent);
 		return;
 	}
 
@@ -206,44 +394,43 @@ void Sv_LinkEntity(g_entity_t *ent) {
 	}
 
 	if (ent->solid == SOLID_NOT) {
+		Sv_UnlinkLeaf(sent);
 		return;
 	}
 
-	// find the first sector that the ent's box crosses
-	sv_sector_t *sector = sv_world.sectors;
-	while (true) {
+	// update its clipping matrices
+	sent->matrix = matrix;
+	sent->inverse_matrix = inverse_matrix;
 
-		if (sector->axis == -1) {
-			break;
-		}
+	// if it still fits snugly within its fattened leaf, the tree is unchanged
+	if (sent->node) {
+		const box3_t fat_bounds = sv_world.nodes[sent->node].bounds;
 
-		if (ent->abs_bounds.mins.xyz[sector->axis] > sector->dist) {
-			sector = sector->children[0];
-		} else if (ent->abs_bounds.maxs.xyz[sector->axis] < sector->dist) {
-			sector = sector->children[1];
-		} else {
-			break;    // crosses the node
+		if (Box3_Contains(fat_bounds, ent->abs_bounds) &&
+			Box3_Contains(Box3_Expand(ent->abs_bounds, WORLD_MARGIN * 4.f), fat_bounds)) {
+			return;
 		}
+
+		Sv_RemoveLeaf(sent->node);
+	} else {
+		sent->node = Sv_AllocNode();
+		sv_world.nodes[sent->node].ent = ent;
 	}
 
-	// add it to the sector
-	sent->sector = sector;
-	sector->entities = g_list_prepend(sector->entities, ent);
+	sv_world.nodes[sent->node].bounds = Box3_Expand(ent->abs_bounds, WORLD_MARGIN);
 
-	// and update its clipping matrices
-	sent->matrix = matrix;
-	sent->inverse_matrix = inverse_matrix;
+	Sv_InsertLeaf(sent->node);
 }
 
 /**
- * @return True if the entity matches the current world filter, false otherwise.
+ * @return True if the entity matches the specified filter, false otherwise.
  */
-static bool Sv_BoxEntities_Filter(const g_entity_t *ent) {
+static bool Sv_BoxEntities_Filter(const g_entity_t *ent, uint32_t type) {
 
 	switch (ent->solid) {
 		case SOLID_TRIGGER:
 		case SOLID_PROJECTILE:
-			if (sv_world.box_type & BOX_OCCUPY) {
+			if (type & BOX_OCCUPY) {
 				return true;
 			}
 			break;
@@ -251,7 +438,7 @@ static bool Sv_BoxEntities_Filter(const g_entity_t *ent) {
 		case SOLID_DEAD:
 		case SOLID_BOX:
 		case SOLID_BSP:
-			if (sv_world.box_type & BOX_COLLIDE) {
+			if (type & BOX_COLLIDE) {
 				return true;
 			}
 			break;
@@ -264,66 +451,76 @@ static bool Sv_BoxEntities_Filter(const g_entity_t *ent) {
 }
 
 /**
- * @brief
+ * @brief Populates an array of entities with those which have bounding boxes
+ * that intersect the given box. It is possible for a non-axial BSP model to
+ * be returned that doesn't actually intersect the box.
+ *
+ * @return The number of entities found.
  */
-static void Sv_BoxEntities_r(sv_sector_t *sector) {
-
-	GList *e = sector->entities;
-	while (e) {
-		g_entity_t *ent = (g_entity_t *) e->data;
+size_t Sv_BoxEntities(const box3_t bounds, g_entity_t **list, const size_t len, uint32_t type) {
+	int32_t stack[WORLD_STACK];
+	size_t count = 0, depth = 0;
 
-		if (Sv_BoxEntities_Filter(ent)) {
+	if (sv_world.root) {
+		stack[depth++] = sv_world.root;
+	}
 
-			if (Box3_Intersects(ent->abs_bounds, sv_world.box)) {
+	while (depth) {
+		const sv_world_node_t *node = &sv_world.nodes[stack[--depth]];
 
-				sv_world.box_entities[sv_world.num_box_entities] = ent;
-				sv_world.num_box_entities++;
+		if (!Box3_Intersects(node->bounds, bounds)) {
+			continue;
+		}
 
-				if (sv_world.num_box_entities == sv_world.max_box_entities) {
-					Com_Warn("sv_world.max_box_entities\n");
-					return;
-				}
+		if (node->height) {
+			if (depth + 2 > lengthof(stack)) {
+				Com_Error(ERROR_DROP, "WORLD_STACK\n");
 			}
+
+			stack[depth++] = node->children[0];
+			stack[depth++] = node->children[1];
+			continue;
 		}
 
-		e = e->next;
-	}
+		g_entity_t *ent = node->ent;
 
-	if (sector->axis == -1) {
-		return;    // terminal node
-	}
+		if (Sv_BoxEntities_Filter(ent, type) && Box3_Intersects(ent->abs_bounds, bounds)) {
 
-	// recurse down both sides
-	if (sv_world.box.maxs.xyz[sector->axis] > sector->dist) {
-		Sv_BoxEntities_r(sector->children[0]);
-	}
+			list[count++] = ent;
 
-	if (sv_world.box.mins.xyz[sector->axis] < sector->dist) {
-		Sv_BoxEntities_r(sector->children[1]);
+			if (count == len) {
+				Com_Warn("max_box_entities\n");
+				break;
+			}
+		}
 	}
+
+	return count;
 }
 
 /**
  * @brief Populates an array of entities with those which have bounding boxes
- * that intersect the given box. It is possible for a non-axial BSP model to
- * be returned that doesn't actually intersect the box.
+ * that intersect the given sphere.
  *
  * @return The number of entities found.
  */
-size_t Sv_BoxEntities(const box3_t bounds, g_entity_t **list, const size_t len, uint32_t type) {
+size_t Sv_SphereEntities(const vec3_t origin, float radius, g_entity_t **list, const size_t len, uint32_t type) {
+
+	const box3_t bounds = Box3_Expand(Box3_FromCenter(origin), radius);
 
-	sv_world.box = bounds;
-	sv_world.box_entities = list;
-	sv_world.num_box_entities = 0;
-	sv_world.max_box_entities = len;
-	sv_world.box_type = type;
+	const size_t len_box = Sv_BoxEntities(bounds, list, len, type);
 
-	Sv_BoxEntities_r(sv_world.sectors);
+	size_t count = 0;
+	for (size_t i = 0; i < len_box; i++) {
 
-	sv_world.box = Box3_Zero();
-	sv_world.box_entities = NULL;
+		const vec3_t point = Box3_ClampPoint(list[i]->abs_bounds, origin);
 
-	return sv_world.num_box_entities;
+		if (Vec3_DistanceSquared(point, origin) <= radius * radius) {
+			list[count++] = list[i];
+		}
+	}
+
+	return count;
 }
 
 /**
@@ -358,6 +555,20 @@ static int32_t Sv_HullForEntity(const g_entity_t *ent) {
 	return -1;
 }
 
+/**
+ * @return The cluster containing the specified point, or -1 if the point is not within a
+ * visible cluster.
+ */
+int32_t Sv_PointCluster(const vec3_t point) {
+
+	const int32_t leaf_num = Cm_PointLeafnum(point, 0);
+	if (leaf_num < 1) {
+		return -1;
+	}
+
+	return Cm_LeafCluster(leaf_num);
+}
+
 /**
  * @brief Returns the contents mask for the specified point. This includes world
  * contents as well as contents for any solid entities this point intersects.
@@ -28,6 +28,8 @@ void Sv_InitWorld(void);
 void Sv_LinkEntity(g_entity_t *ent);
 void Sv_UnlinkEntity(g_entity_t *ent);
 size_t Sv_BoxEntities(const box3_t bounds, g_entity_t **list, size_t len, uint32_t type);
+size_t Sv_SphereEntities(const vec3_t origin, float radius, g_entity_t **list, size_t len, uint32_t type);
+int32_t Sv_PointCluster(const vec3_t point);
 int32_t Sv_PointContents(const vec3_t p);
 int32_t Sv_BoxContents(const box3_t bounds);
 cm_trace_t Sv_Trace(const vec3_t start, const vec3_t end, const box3_t bounds,
@@ -89,6 +89,91 @@ START_TEST(check_Mem_LinkMalloc) {
 
 } END_TEST
 
+START_TEST(check_Mem_Realloc) {
+	char *parent = Mem_Malloc(8);
+	strcpy(parent, "parent");
+
+	char *child = Mem_LinkMalloc(8, parent);
+	strcpy(child, "child");
+
+	for (size_t size = 16; size < 0x10000; size *= 2) {
+		parent = Mem_Realloc(parent, size);
+		ck_assert_str_eq("parent", parent);
+		ck_assert_int_eq(size + 8, Mem_Size());
+	}
+
+	child = Mem_Realloc(child, 4000);
+	ck_assert_str_eq("child", child);
+
+	Mem_Free(parent);
+
+	ck_assert_int_eq(0, Mem_Size());
+
+} END_TEST
+
+START_TEST(check_Mem_TagArena) {
+
+#define ARENA_TAG 11
+
+	Mem_TagArena(ARENA_TAG);
+
+	for (int32_t i = 0; i < 0x10000; i++) {
+		int32_t *value = Mem_TagMalloc(sizeof(int32_t) * (i % 16 + 1), ARENA_TAG);
+		ck_assert_int_eq(0, *value);
+		*value = i;
+	}
+
+	byte *block = Mem_TagMalloc(64, ARENA_TAG);
+	Mem_LinkMalloc(64, block);
+	Mem_Free(block);
+
+	GArray *stats = Mem_Stats();
+
+	const mem_stat_t *total = &g_array_index(stats, mem_stat_t, 0);
+	ck_assert_int_eq(Mem_Size(), total->size);
+
+	g_array_free(stats, true);
+
+	Mem_FreeTag(ARENA_TAG);
+
+	ck_assert_int_eq(0, Mem_Size());
+
+} END_TEST
+
+#define STATS_TAG 12
+
+START_TEST(check_Mem_Stats) {
+
+	for (int32_t i = 0; i < 100; i++) {
+		Mem_TagMalloc(64, STATS_TAG);
+	}
+
+	g_array_free(Mem_Stats(), true); // the high-water mark is sampled by Mem_Stats
+
+	Mem_FreeTag(STATS_TAG);
+
+	Mem_TagMalloc(128, STATS_TAG);
+
+	GArray *stats = Mem_Stats();
+
+	const mem_stat_t *total = &g_array_index(stats, mem_stat_t, 0);
+	ck_assert_int_eq(-1, total->tag);
+	ck_assert_int_eq(128, total->size);
+	ck_assert_int_eq(1, total->count);
+	ck_assert_int_eq(64 * 100, total->peak);
+	ck_assert(total->rate > 0.f);
+
+	const mem_stat_t *tag = &g_array_index(stats, mem_stat_t, 1);
+	ck_assert_int_eq(STATS_TAG, tag->tag);
+	ck_assert_int_eq(128, tag->size);
+	ck_assert_int_eq(1, tag->count);
+
+	g_array_free(stats, true);
+
+	Mem_FreeTag(STATS_TAG);
+
+} END_TEST
+
 START_TEST(check_Mem_CopyString) {
 	char *test = Mem_CopyString("test");
 
@@ -111,6 +196,9 @@ int32_t main(int32_t argc, char **argv) {
 
 	tcase_add_test(tcase, check_Mem_TagMalloc);
 	tcase_add_test(tcase, check_Mem_LinkMalloc);
+	tcase_add_test(tcase, check_Mem_Realloc);
+	tcase_add_test(tcase, check_Mem_TagArena);
+	tcase_add_test(tcase, check_Mem_Stats);
 	tcase_add_test(tcase, check_Mem_CopyString);
 
 	Suite *suite = suite_create("check_mem");
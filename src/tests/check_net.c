@@ -0,0 +1,187 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "tests.h"
+#include "net/net_message.h"
+
+quetoo_t quetoo;
+
+#define NUM_DIRS 0x100000
+
+static vec3_t *dirs;
+static byte *data;
+
+/**
+ * @brief Setup fixture.
+ */
+void setup(void) {
+
+	Mem_Init();
+
+	dirs = Mem_Malloc(NUM_DIRS * sizeof(vec3_t));
+	data = Mem_Malloc(NUM_DIRS * 2);
+
+	for (int32_t i = 0; i < NUM_DIRS; i++) {
+		dirs[i] = Vec3_RandomDir();
+	}
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+
+	Mem_Free(dirs);
+	Mem_Free(data);
+
+	Mem_Shutdown();
+}
+
+/**
+ * @return The index of the approximate normal closest to `dir`, as previously sent by Net_WriteDir.
+ */
+static int32_t ApproximateNormal(const vec3_t dir) {
+	int32_t best = 0;
+	float best_d = 0.f;
+
+	for (int32_t i = 0; i < NUM_APPROXIMATE_NORMALS; i++) {
+		const float d = Vec3_Dot(dir, approximate_normals[i]);
+		if (d > best_d) {
+			best_d = d;
+			best = i;
+		}
+	}
+
+	return best;
+}
+
+/**
+ * @return The angle between the unit vectors `a` and `b`, in degrees.
+ */
+static float AngleBetween(const vec3_t a, const vec3_t b) {
+	return Degrees(acosf(Clampf(Vec3_Dot(a, b), -1.f, 1.f)));
+}
+
+START_TEST(check_Net_WriteDir_Axial) {
+
+	const vec3_t axial[] = {
+		Vec3(1.f, 0.f, 0.f), Vec3(-1.f, 0.f, 0.f),
+		Vec3(0.f, 1.f, 0.f), Vec3(0.f, -1.f, 0.f),
+		Vec3(0.f, 0.f, 1.f), Vec3(0.f, 0.f, -1.f),
+	};
+
+	for (size_t i = 0; i < lengthof(axial); i++) {
+		mem_buf_t msg;
+		Mem_InitBuffer(&msg, data, 2);
+
+		Net_WriteDir(&msg, axial[i]);
+		ck_assert_int_eq(2, msg.size);
+
+		const vec3_t dir = Net_ReadDir(&msg);
+		ck_assert_msg(Vec3_Equal(axial[i], dir), "(%g %g %g) != (%g %g %g)",
+					  axial[i].x, axial[i].y, axial[i].z, dir.x, dir.y, dir.z);
+	}
+
+} END_TEST
+
+START_TEST(check_Net_WriteDir_Accuracy) {
+
+	mem_buf_t msg;
+	Mem_InitBuffer(&msg, data, NUM_DIRS * 2);
+
+	for (int32_t i = 0; i < NUM_DIRS; i++) {
+		Net_WriteDir(&msg, dirs[i]);
+	}
+
+	float table_max = 0.f, table_mean = 0.f;
+	float max = 0.f, mean = 0.f;
+
+	for (int32_t i = 0; i < NUM_DIRS; i++) {
+
+		const float table_error = AngleBetween(dirs[i], approximate_normals[ApproximateNormal(dirs[i])]);
+
+		table_max = Maxf(table_max, table_error);
+		table_mean += table_error / NUM_DIRS;
+
+		const float error = AngleBetween(dirs[i], Net_ReadDir(&msg));
+
+		max = Maxf(max, error);
+		mean += error / NUM_DIRS;
+	}
+
+	printf("Net_WriteDir: max error %.3f, mean error %.3f degrees\n", max, mean);
+	printf("approximate_normals: max error %.3f, mean error %.3f degrees\n", table_max, table_mean);
+
+	ck_assert_msg(max < 1.f, "max error %g", max);
+	ck_assert_msg(mean < table_mean / 10.f, "mean error %g", mean);
+
+} END_TEST
+
+START_TEST(check_Net_WriteDir_Benchmark) {
+
+	mem_buf_t msg;
+	Mem_InitBuffer(&msg, data, NUM_DIRS * 2);
+
+	gint64 start = g_get_monotonic_time();
+
+	for (int32_t i = 0; i < NUM_DIRS; i++) {
+		Net_WriteDir(&msg, dirs[i]);
+	}
+
+	const gint64 octahedral = g_get_monotonic_time() - start;
+
+	Mem_ClearBuffer(&msg);
+
+	start = g_get_monotonic_time();
+
+	for (int32_t i = 0; i < NUM_DIRS; i++) {
+		Net_WriteByte(&msg, ApproximateNormal(dirs[i]));
+	}
+
+	const gint64 table = g_get_monotonic_time() - start;
+
+	printf("Net_WriteDir: %.1fns, approximate_normals: %.1fns\n",
+		   octahedral * 1000.0 / NUM_DIRS, table * 1000.0 / NUM_DIRS);
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+	Test_Init(argc, argv);
+
+	TCase *tcase = tcase_create("check_net");
+	tcase_add_checked_fixture(tcase, setup, teardown);
+
+	tcase_add_test(tcase, check_Net_WriteDir_Axial);
+	tcase_add_test(tcase, check_Net_WriteDir_Accuracy);
+	tcase_add_test(tcase, check_Net_WriteDir_Benchmark);
+
+	Suite *suite = suite_create("check_net");
+	suite_add_tcase(suite, tcase);
+
+	int32_t failed = Test_Run(suite);
+
+	Test_Shutdown();
+	return failed;
+}
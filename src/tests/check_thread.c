@@ -81,6 +81,54 @@ START_TEST(check_Thread_Wait) {
 
 } END_TEST
 
+/**
+ * @brief Increments the specified counter.
+ */
+static void increment(void *data) {
+	atomic_fetch_add((atomic_int *) data, 1);
+}
+
+START_TEST(check_Thread_Join) {
+	thread_counter_t counter = 0;
+	atomic_int count = 0;
+
+	for (int32_t i = 0; i < 10000; i++) {
+		Thread_Submit(increment, &count, &counter);
+	}
+
+	Thread_Join(&counter);
+
+	ck_assert_int_eq(0, counter);
+	ck_assert_int_eq(10000, count);
+
+} END_TEST
+
+/**
+ * @brief Marks the specified index as visited.
+ */
+static void visit(int32_t index, void *data) {
+	atomic_fetch_add(&((atomic_int *) data)[index], 1);
+}
+
+START_TEST(check_Thread_ParallelFor) {
+	static atomic_int visits[10000];
+
+	memset(visits, 0, sizeof(visits));
+
+	Thread_ParallelFor(lengthof(visits), 0, visit, visits);
+
+	for (size_t i = 0; i < lengthof(visits); i++) {
+		ck_assert_int_eq(1, visits[i]);
+	}
+
+	Thread_ParallelFor(lengthof(visits), 7, visit, visits);
+
+	for (size_t i = 0; i < lengthof(visits); i++) {
+		ck_assert_int_eq(2, visits[i]);
+	}
+
+} END_TEST
+
 /**
  * @brief Test entry point.
  */
@@ -92,6 +140,8 @@ int32_t main(int32_t argc, char **argv) {
 	tcase_add_checked_fixture(tcase, setup, teardown);
 
 	tcase_add_test(tcase, check_Thread_Wait);
+	tcase_add_test(tcase, check_Thread_Join);
+	tcase_add_test(tcase, check_Thread_ParallelFor);
 
 	Suite *suite = suite_create("check_threads");
 	suite_add_tcase(suite, tcase);
@@ -0,0 +1,386 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "bvh.h"
+
+/**
+ * @brief The maximum number of brushes referenced by a BVH leaf.
+ */
+#define BVH_LEAF_BRUSHES 4
+
+/**
+ * @brief The maximum depth of a BVH, which bounds the traversal stack.
+ */
+#define BVH_MAX_DEPTH 64
+
+/**
+ * @brief Flattened BVH nodes are stored depth-first, so that the first child of an interior
+ * node immediately follows it, and `offset` indexes the second. For leafs, `offset` indexes
+ * the first of `count` brushes.
+ */
+typedef struct {
+	box3_t bounds;
+	int32_t offset;
+	int32_t count;
+} bvh_node_t;
+
+/**
+ * @brief A BVH over the brushes of a single BSP model.
+ */
+typedef struct {
+	int32_t head_node;
+	GArray *nodes;
+	GArray *brushes;
+} bvh_t;
+
+static GArray *bvhs;
+
+/**
+ * @brief Collects the unique brushes referenced by the leafs beneath the specified node.
+ */
+static void CollectBrushes_r(int32_t num, GArray *brushes, byte *collected) {
+
+	const cm_bsp_t *bsp = Cm_Bsp();
+
+	if (num < 0) {
+		const cm_bsp_leaf_t *leaf = &bsp->leafs[-1 - num];
+
+		for (int32_t i = 0; i < leaf->num_leaf_brushes; i++) {
+			const int32_t brush_num = bsp->leaf_brushes[leaf->first_leaf_brush + i];
+
+			if (collected[brush_num]) {
+				continue;
+			}
+
+			collected[brush_num] = true;
+
+			if (bsp->brushes[brush_num].num_brush_sides) {
+				g_array_append_val(brushes, brush_num);
+			}
+		}
+		return;
+	}
+
+	CollectBrushes_r(bsp->nodes[num].children[0], brushes, collected);
+	CollectBrushes_r(bsp->nodes[num].children[1], brushes, collected);
+}
+
+/**
+ * @brief Recursively partitions the brushes in `[first, first + count)` at the median
+ * of their centers along the longest axis, appending nodes depth-first.
+ */
+static void BuildBVH_r(bvh_t *bvh, int32_t *brushes, int32_t first, int32_t count, int32_t depth) {
+
+	const cm_bsp_t *bsp = Cm_Bsp();
+
+	box3_t bounds = Box3_Null(), centers = Box3_Null();
+
+	for (int32_t i = first; i < first + count; i++) {
+		const box3_t b = bsp->brushes[brushes[i]].bounds;
+
+		bounds = Box3_Union(bounds, b);
+		centers = Box3_Append(centers, Box3_Center(b));
+	}
+
+	const int32_t index = bvh->nodes->len;
+
+	g_array_append_vals(bvh->nodes, &(const bvh_node_t) {
+		.bounds = bounds,
+		.offset = first,
+		.count = count
+	}, 1);
+
+	if (count <= BVH_LEAF_BRUSHES || depth == BVH_MAX_DEPTH - 1) {
+		return;
+	}
+
+	const vec3_t size = Box3_Size(centers);
+
+	int32_t axis = 0;
+	if (size.y > size.xyz[axis]) {
+		axis = 1;
+	}
+	if (size.z > size.xyz[axis]) {
+		axis = 2;
+	}
+
+	// partially sort the brushes about the median, so that both halves are balanced
+	const int32_t mid = first + count / 2;
+
+	int32_t lo = first, hi = first + count - 1;
+	while (lo < hi) {
+		const float pivot = Box3_Center(bsp->brushes[brushes[mid]].bounds).xyz[axis];
+
+		int32_t i = lo, j = hi;
+		while (i <= j) {
+			while (Box3_Center(bsp->brushes[brushes[i]].bounds).xyz[axis] < pivot) {
+				i++;
+			}
+			while (Box3_Center(bsp->brushes[brushes[j]].bounds).xyz[axis] > pivot) {
+				j--;
+			}
+			if (i <= j) {
+				const int32_t swap = brushes[i];
+				brushes[i] = brushes[j];
+				brushes[j] = swap;
+				i++, j--;
+			}
+		}
+
+		if (j < mid) {
+			lo = i;
+		}
+		if (mid < i) {
+			hi = j;
+		}
+	}
+
+	BuildBVH_r(bvh, brushes, first, mid - first, depth + 1);
+
+	g_array_index(bvh->nodes, bvh_node_t, index).offset = bvh->nodes->len;
+	g_array_index(bvh->nodes, bvh_node_t, index).count = 0;
+
+	BuildBVH_r(bvh, brushes, mid, first + count - mid, depth + 1);
+}
+
+/**
+ * @brief Builds a BVH over the brushes of each BSP model, for occlusion queries.
+ */
+void BuildOcclusionBVH(void) {
+
+	const cm_bsp_t *bsp = Cm_Bsp();
+
+	const uint32_t start = SDL_GetTicks();
+
+	bvhs = g_array_new(false, false, sizeof(bvh_t));
+
+	byte *collected = Mem_TagMalloc(bsp->num_brushes, MEM_TAG_LIGHT);
+
+	size_t num_nodes = 0;
+
+	for (int32_t i = 0; i < bsp->num_models; i++) {
+
+		bvh_t bvh = {
+			.head_node = bsp->models[i].head_node,
+			.nodes = g_array_new(false, false, sizeof(bvh_node_t)),
+			.brushes = g_array_new(false, false, sizeof(int32_t))
+		};
+
+		memset(collected, 0, bsp->num_brushes);
+
+		CollectBrushes_r(bvh.head_node, bvh.brushes, collected);
+
+		if (bvh.brushes->len) {
+			BuildBVH_r(&bvh, (int32_t *) bvh.brushes->data, 0, bvh.brushes->len, 0);
+		}
+
+		num_nodes += bvh.nodes->len;
+
+		g_array_append_val(bvhs, bvh);
+	}
+
+	Mem_Free(collected);
+
+	Com_Verbose("Built occlusion BVH with %zu nodes in %d ms\n", num_nodes, SDL_GetTicks() - start);
+}
+
+/**
+ * @return True if the segment intersects the box, using the slab method.
+ */
+static inline bool IntersectBox(const box3_t box, const vec3_t start, const vec3_t inv_dir) {
+
+	float t_min = 0.f, t_max = 1.f;
+
+	for (int32_t i = 0; i < 3; i++) {
+
+		float t1 = (box.mins.xyz[i] - start.xyz[i]) * inv_dir.xyz[i];
+		float t2 = (box.maxs.xyz[i] - start.xyz[i]) * inv_dir.xyz[i];
+
+		if (t1 > t2) {
+			const float swap = t1;
+			t1 = t2;
+			t2 = swap;
+		}
+
+		// NaN, from an axis the segment is parallel to and lies on a face of, is ignored
+		t_min = t1 > t_min ? t1 : t_min;
+		t_max = t2 < t_max ? t2 : t_max;
+
+		if (t_min > t_max) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @return True if the segment intersects the brush. This is the occlusion-only form of
+ * the brush clipping in Light_Trace, and must agree with it.
+ */
+static inline bool IntersectBrush(const cm_bsp_brush_t *brush, const vec3_t start, const vec3_t end) {
+
+	float enter_fraction = -1.f;
+	float leave_fraction = 1.f;
+	float nudged_enter_fraction = -1.f;
+
+	bool start_outside = false;
+
+	const cm_bsp_brush_side_t *s = brush->brush_sides + brush->num_brush_sides - 1;
+	for (int32_t i = brush->num_brush_sides - 1; i >= 0; i--, s--) {
+
+		const cm_bsp_plane_t *p = s->plane;
+
+		const float d1 = Vec3_Dot(start, p->normal) - p->dist;
+		const float d2 = Vec3_Dot(end, p->normal) - p->dist;
+
+		if (d1 > 0.f) {
+			start_outside = true;
+		}
+
+		// if completely in front of plane, the segment does not intersect with the brush
+		if (d1 > 0.f && d2 >= d1) {
+			return false;
+		}
+
+		// if completely behind plane, the segment does not intersect with this side
+		if (d1 <= 0.f && d2 <= d1) {
+			continue;
+		}
+
+		const float f = d1 / (d1 - d2);
+
+		if (d1 > d2) { // enter
+			if (f > enter_fraction) {
+				enter_fraction = f;
+				nudged_enter_fraction = (d1 - TRACE_EPSILON) / (d1 - d2);
+			}
+		} else { // leave
+			if (f < leave_fraction) {
+				leave_fraction = f;
+			}
+		}
+	}
+
+	if (!start_outside) {
+		return true;
+	}
+
+	return enter_fraction < leave_fraction &&
+		   enter_fraction > -1.f &&
+		   enter_fraction < 1.f + TRACE_EPSILON &&
+		   nudged_enter_fraction < 1.f;
+}
+
+/**
+ * @return True if any brush of the BVH matching `mask` intersects the segment.
+ */
+static bool OccludedBVH_(const bvh_t *bvh, const vec3_t start, const vec3_t end, int32_t mask) {
+
+	if (!bvh->nodes->len) {
+		return false;
+	}
+
+	const cm_bsp_t *bsp = Cm_Bsp();
+
+	const vec3_t dir = Vec3_Subtract(end, start);
+	const vec3_t inv_dir = Vec3(1.f / dir.x, 1.f / dir.y, 1.f / dir.z);
+
+	const bvh_node_t *nodes = (const bvh_node_t *) bvh->nodes->data;
+	const int32_t *brushes = (const int32_t *) bvh->brushes->data;
+
+	int32_t stack[BVH_MAX_DEPTH];
+	int32_t depth = 0;
+
+	stack[depth++] = 0;
+
+	while (depth) {
+		const bvh_node_t *node = &nodes[stack[--depth]];
+
+		if (!IntersectBox(node->bounds, start, inv_dir)) {
+			continue;
+		}
+
+		if (node->count == 0) {
+			stack[depth++] = node->offset;
+			stack[depth++] = (int32_t) (node - nodes) + 1;
+			continue;
+		}
+
+		for (int32_t i = 0; i < node->count; i++) {
+			const cm_bsp_brush_t *brush = &bsp->brushes[brushes[node->offset + i]];
+
+			if (!(brush->contents & mask)) {
+				continue;
+			}
+
+			if (IntersectBrush(brush, start, end)) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief Any-hit occlusion query, equivalent to `Light_Trace(...).fraction < 1.f`. The segment
+ * is tested against the world and against the model of the given head node.
+ */
+bool OccludedBVH(int32_t head_node, const vec3_t start, const vec3_t end, int32_t mask) {
+
+	const bvh_t *world = &g_array_index(bvhs, bvh_t, 0);
+
+	if (OccludedBVH_(world, start, end, mask)) {
+		return true;
+	}
+
+	if (head_node) {
+		for (guint i = 1; i < bvhs->len; i++) {
+			const bvh_t *bvh = &g_array_index(bvhs, bvh_t, i);
+			if (bvh->head_node == head_node) {
+				return OccludedBVH_(bvh, start, end, mask);
+			}
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief Frees the occlusion BVH.
+ */
+void FreeOcclusionBVH(void) {
+
+	if (!bvhs) {
+		return;
+	}
+
+	for (guint i = 0; i < bvhs->len; i++) {
+		bvh_t *bvh = &g_array_index(bvhs, bvh_t, i);
+
+		g_array_free(bvh->nodes, true);
+		g_array_free(bvh->brushes, true);
+	}
+
+	g_array_free(bvhs, true);
+	bvhs = NULL;
+}
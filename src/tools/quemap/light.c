@@ -25,9 +25,6 @@
 
 static GPtrArray *lights = NULL;
 
-GPtrArray *node_lights[MAX_BSP_NODES];
-GPtrArray *leaf_lights[MAX_BSP_LEAFS];
-
 /**
  * @brief
  */
@@ -403,38 +400,142 @@ static light_t *LightForBrushSide(const bsp_brush_side_t *brush_side, int32_t si
 }
 
 /**
- * @brief
+ * @brief The maximum number of light sources referenced by a light index leaf.
  */
-void FreeLights(void) {
+#define LIGHT_INDEX_LEAF_LIGHTS 8
 
-	if (!lights) {
-		return;
+/**
+ * @brief The maximum depth of the light index, which bounds the query stack.
+ */
+#define LIGHT_INDEX_MAX_DEPTH 64
+
+/**
+ * @brief Light index nodes are stored depth-first, so that the first child of an interior
+ * node immediately follows it, and `offset` indexes the second. For leafs, `offset` indexes
+ * the first of `count` light sources.
+ */
+typedef struct {
+	box3_t bounds;
+	int32_t offset;
+	int32_t count;
+} light_node_t;
+
+/**
+ * @brief The light index is a BVH over the bounds of attenuated light sources, so that the
+ * lights affecting a lightmap or lightgrid luxel can be found without scanning them all.
+ * Leaf light bounds are stored as SoA, contiguous in leaf order.
+ */
+static struct {
+	GPtrArray *unbounded;
+	GArray *nodes;
+	light_t **lights;
+	float *mins[3], *maxs[3];
+	int32_t num_lights;
+} light_index;
+
+/**
+ * @brief Frees the light index.
+ */
+static void FreeLightIndex(void) {
+
+	if (light_index.unbounded) {
+		g_ptr_array_free(light_index.unbounded, true);
 	}
 
-	g_ptr_array_free(lights, true);
-	lights = NULL;
+	if (light_index.nodes) {
+		g_array_free(light_index.nodes, true);
+	}
 
-	for (int32_t i = 0; i < bsp_file.num_nodes; i++) {
-		if (node_lights[i]) {
-			g_ptr_array_free(node_lights[i], true);
-			node_lights[i] = NULL;
-		}
+	Mem_Free(light_index.lights);
+
+	for (int32_t i = 0; i < 3; i++) {
+		Mem_Free(light_index.mins[i]);
+		Mem_Free(light_index.maxs[i]);
 	}
 
-	for (int32_t i = 0; i < bsp_file.num_leafs; i++) {
-		if (leaf_lights[i]) {
-			g_ptr_array_free(leaf_lights[i], true);
-			leaf_lights[i] = NULL;
-		}
+	memset(&light_index, 0, sizeof(light_index));
+}
+
+/**
+ * @brief The axis on which LightIndex_Compare orders light sources.
+ */
+static int32_t light_index_axis;
+
+/**
+ * @brief Sort comparator ordering light sources by their center on `light_index_axis`.
+ */
+static int32_t LightIndex_Compare(const void *a, const void *b) {
+
+	const int32_t axis = light_index_axis;
+
+	const float ca = Box3_Center((*(const light_t **) a)->bounds).xyz[axis];
+	const float cb = Box3_Center((*(const light_t **) b)->bounds).xyz[axis];
+
+	return ca < cb ? -1 : ca > cb ? 1 : 0;
+}
+
+/**
+ * @brief Recursively partitions the light sources in `[first, first + count)` at the median
+ * of their centers along the longest axis, appending nodes depth-first.
+ */
+static void BuildLightIndex_r(int32_t first, int32_t count, int32_t depth) {
+
+	light_t **lights = light_index.lights + first;
+
+	box3_t bounds = Box3_Null(), centers = Box3_Null();
+
+	for (int32_t i = 0; i < count; i++) {
+		bounds = Box3_Union(bounds, lights[i]->bounds);
+		centers = Box3_Append(centers, Box3_Center(lights[i]->bounds));
+	}
+
+	const int32_t index = light_index.nodes->len;
+
+	g_array_append_vals(light_index.nodes, &(const light_node_t) {
+		.bounds = bounds,
+		.offset = first,
+		.count = count
+	}, 1);
+
+	if (count <= LIGHT_INDEX_LEAF_LIGHTS || depth == LIGHT_INDEX_MAX_DEPTH - 1) {
+		return;
+	}
+
+	const vec3_t size = Box3_Size(centers);
+
+	int32_t axis = 0;
+	if (size.y > size.xyz[axis]) {
+		axis = 1;
+	}
+	if (size.z > size.xyz[axis]) {
+		axis = 2;
 	}
+
+	light_index_axis = axis;
+	qsort(lights, count, sizeof(light_t *), LightIndex_Compare);
+
+	const int32_t half = count / 2;
+
+	BuildLightIndex_r(first, half, depth + 1);
+
+	g_array_index(light_index.nodes, light_node_t, index).offset = light_index.nodes->len;
+	g_array_index(light_index.nodes, light_node_t, index).count = 0;
+
+	BuildLightIndex_r(first + half, count - half, depth + 1);
 }
 
 /**
- * @return A GPtrArray of all light sources of the specified types intersecting the given bounds.
+ * @brief Indexes light sources of the specified type(s) by their bounds.
  */
-static GPtrArray *BoxLights(light_type_t type, const box3_t bounds) {
+static void BuildLightIndex(light_type_t type) {
+
+	assert(lights);
+
+	FreeLightIndex();
 
-	GPtrArray *box_lights = g_ptr_array_new();
+	light_index.unbounded = g_ptr_array_new();
+	light_index.nodes = g_array_new(false, false, sizeof(light_node_t));
+	light_index.lights = Mem_TagMalloc(lights->len * sizeof(light_t *), MEM_TAG_LIGHT);
 
 	for (guint i = 0; i < lights->len; i++) {
 		light_t *light = g_ptr_array_index(lights, i);
@@ -443,52 +544,103 @@ static GPtrArray *BoxLights(light_type_t type, const box3_t bounds) {
 			continue;
 		}
 
-		if (light->atten != LIGHT_ATTEN_NONE) {
-			if (!Box3_Intersects(bounds, light->bounds)) {
-				continue;
-			}
+		light->hash = HashLight(light);
+
+		if (light->atten == LIGHT_ATTEN_NONE) {
+			g_ptr_array_add(light_index.unbounded, light);
+		} else {
+			light_index.lights[light_index.num_lights++] = light;
 		}
+	}
 
-		g_ptr_array_add(box_lights, (gpointer) light);
+	if (light_index.num_lights) {
+		BuildLightIndex_r(0, light_index.num_lights, 0);
 	}
 
-	return box_lights;
+	for (int32_t i = 0; i < 3; i++) {
+		light_index.mins[i] = Mem_TagMalloc(light_index.num_lights * sizeof(float), MEM_TAG_LIGHT);
+		light_index.maxs[i] = Mem_TagMalloc(light_index.num_lights * sizeof(float), MEM_TAG_LIGHT);
+
+		for (int32_t j = 0; j < light_index.num_lights; j++) {
+			light_index.mins[i][j] = light_index.lights[j]->bounds.mins.xyz[i];
+			light_index.maxs[i][j] = light_index.lights[j]->bounds.maxs.xyz[i];
+		}
+	}
+
+	Com_Verbose("Indexed %d lights in %d nodes\n", light_index.num_lights, light_index.nodes->len);
 }
 
 /**
- * @brief Hashes light sources of the specified type(s) into bins by node and leaf.
+ * @return A GPtrArray of all indexed light sources intersecting the given bounds, which
+ * the caller must free.
  */
-static void HashLights(light_type_t type) {
+GPtrArray *BoxLights(const box3_t bounds) {
 
-	assert(lights);
+	GPtrArray *box_lights = g_ptr_array_sized_new(light_index.unbounded->len + LIGHT_INDEX_LEAF_LIGHTS);
+
+	for (guint i = 0; i < light_index.unbounded->len; i++) {
+		g_ptr_array_add(box_lights, g_ptr_array_index(light_index.unbounded, i));
+	}
+
+	if (light_index.num_lights == 0) {
+		return box_lights;
+	}
+
+	const light_node_t *nodes = (light_node_t *) light_index.nodes->data;
 
-	const bsp_node_t *node = bsp_file.nodes;
-	for (int32_t i = 0; i < bsp_file.num_nodes; i++, node++) {
+	int32_t stack[LIGHT_INDEX_MAX_DEPTH];
+	int32_t depth = 0;
 
-		if (node->num_faces == 0) {
+	stack[depth++] = 0;
+
+	while (depth) {
+		const light_node_t *node = &nodes[stack[--depth]];
+
+		if (!Box3_Intersects(bounds, node->bounds)) {
 			continue;
 		}
 
-		if (node_lights[i]) {
-			g_ptr_array_free(node_lights[i], true);
+		if (node->count == 0) {
+			stack[depth++] = node->offset;
+			stack[depth++] = (int32_t) (node - nodes) + 1;
+			continue;
 		}
 
-		node_lights[i] = BoxLights(type, Box3_Expand(node->visible_bounds, BSP_LIGHTMAP_LUXEL_SIZE));
-	}
+		const float *mins_x = light_index.mins[0] + node->offset;
+		const float *mins_y = light_index.mins[1] + node->offset;
+		const float *mins_z = light_index.mins[2] + node->offset;
+		const float *maxs_x = light_index.maxs[0] + node->offset;
+		const float *maxs_y = light_index.maxs[1] + node->offset;
+		const float *maxs_z = light_index.maxs[2] + node->offset;
 
-	const bsp_leaf_t *leaf = bsp_file.leafs;
-	for (int32_t i = 0; i < bsp_file.num_leafs; i++, leaf++) {
+		for (int32_t i = 0; i < node->count; i++) {
 
-		if (leaf->contents & CONTENTS_SOLID) {
-			continue;
-		}
+			if (mins_x[i] > bounds.maxs.x || maxs_x[i] < bounds.mins.x ||
+				mins_y[i] > bounds.maxs.y || maxs_y[i] < bounds.mins.y ||
+				mins_z[i] > bounds.maxs.z || maxs_z[i] < bounds.mins.z) {
+				continue;
+			}
 
-		if (leaf_lights[i]) {
-			g_ptr_array_free(leaf_lights[i], true);
+			g_ptr_array_add(box_lights, light_index.lights[node->offset + i]);
 		}
+	}
+
+	return box_lights;
+}
 
-		leaf_lights[i] = BoxLights(type, Box3_Expand(leaf->visible_bounds, BSP_LIGHTMAP_LUXEL_SIZE));
+/**
+ * @brief
+ */
+void FreeLights(void) {
+
+	if (!lights) {
+		return;
 	}
+
+	FreeLightIndex();
+
+	g_ptr_array_free(lights, true);
+	lights = NULL;
 }
 
 /**
@@ -529,7 +681,7 @@ void BuildDirectLights(void) {
 		}
 	}
 
-	HashLights(~LIGHT_PATCH);
+	BuildLightIndex(~LIGHT_PATCH);
 
 	Com_Print("\r%-24s [100%%] %d ms\n", "Building direct lights", SDL_GetTicks() - start);
 
@@ -646,7 +798,7 @@ void BuildIndirectLights(void) {
 		Progress("Building indirect lights", i * 100.f / bsp_file.num_faces);
 	}
 
-	HashLights(LIGHT_PATCH);
+	BuildLightIndex(LIGHT_PATCH);
 
 	Com_Print("\r%-24s [100%%] %d ms\n", "Building indirect lights", SDL_GetTicks() - start);
 
@@ -689,6 +841,8 @@ void EmitLights(void) {
 				break;
 
 			default:
+				RestoreLightBounds(light);
+
 				out->type = light->type;
 				out->atten = light->atten;
 				out->origin = light->origin;
@@ -154,12 +154,15 @@ typedef struct light_s {
 	 * @brief The light source model for face and patch lights.
 	 */
 	const bsp_model_t *model;
-} light_t;
 
-extern GPtrArray *node_lights[MAX_BSP_NODES];
-extern GPtrArray *leaf_lights[MAX_BSP_LEAFS];
+	/**
+	 * @brief The hash of the light source parameters, for the light cache.
+	 */
+	uint64_t hash;
+} light_t;
 
 void FreeLights(void);
+GPtrArray *BoxLights(const box3_t bounds);
 void BuildDirectLights(void);
 void BuildIndirectLights(void);
 void EmitLights(void);
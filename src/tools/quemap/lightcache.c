@@ -0,0 +1,945 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "qlight.h"
+
+/**
+ * @brief The light cache file version. Bump this whenever lighting results change.
+ */
+#define LIGHT_CACHE_VERSION 1
+
+/**
+ * @brief The light cache file identifier.
+ */
+#define LIGHT_CACHE_IDENT (('C' << 24) + ('L' << 16) + ('U' << 8) + 'Q')
+
+/**
+ * @brief The distance that caustics are traced from each luxel.
+ */
+#define LIGHT_CACHE_CAUSTICS_DIST 128.f
+
+/**
+ * @brief The cached results of each lighting phase for a single luxel.
+ */
+typedef struct {
+	vec3_t ambient, diffuse, direction;
+	vec3_t indirect;
+	vec3_t caustics;
+} light_cache_luxel_t;
+
+/**
+ * @brief The cached results for a single lightmap, keyed by the face geometry.
+ */
+typedef struct {
+	uint64_t key;
+	uint64_t phases[LIGHT_CACHE_PHASES];
+	int32_t num_luxels;
+	light_cache_luxel_t *luxels;
+} light_cache_face_t;
+
+/**
+ * @brief Brushes are hashed so that geometry changes, which may cast or remove shadows,
+ * can be located.
+ */
+typedef struct {
+	uint64_t hash;
+	box3_t bounds;
+} light_cache_brush_t;
+
+/**
+ * @brief Light sources are hashed by their parameters. Their visible bounds are cached.
+ */
+typedef struct {
+	uint64_t hash;
+	box3_t bounds;
+} light_cache_light_t;
+
+/**
+ * @brief The cached lightgrid, valid only if its dimensions are unchanged.
+ */
+typedef struct {
+	vec3i_t size;
+	mat4_t matrix;
+	int32_t num_luxels;
+	uint64_t (*phases)[LIGHT_CACHE_PHASES];
+	light_cache_luxel_t *luxels;
+} light_cache_lightgrid_t;
+
+/**
+ * @brief A light cache, either as read from the previous compile, or as built by this one.
+ */
+typedef struct {
+	uint64_t options;
+
+	GArray *brushes;
+	GHashTable *lights;
+
+	int32_t num_faces;
+	light_cache_face_t *faces;
+
+	light_cache_lightgrid_t lightgrid;
+} light_cache_t;
+
+static struct {
+	/**
+	 * @brief The cache from the previous compile, and an index of its faces by key.
+	 */
+	light_cache_t in;
+	GHashTable *in_faces;
+
+	/**
+	 * @brief The cache built by this compile, for the next.
+	 */
+	light_cache_t out;
+
+	/**
+	 * @brief The bounds of brushes that have changed since the previous compile.
+	 */
+	GArray *dirty;
+
+	/**
+	 * @brief The bounds of each face, for testing against dirty bounds.
+	 */
+	box3_t *face_bounds;
+
+	/**
+	 * @brief The number of lightmap and lightgrid phases restored and computed.
+	 */
+	SDL_atomic_t restored, computed;
+	SDL_atomic_t restored_lightgrid, computed_lightgrid;
+} light_cache;
+
+/**
+ * @brief Hashes the given data into the running FNV-1a hash.
+ */
+static uint64_t Hash(uint64_t hash, const void *data, size_t len) {
+
+	const byte *b = data;
+
+	for (size_t i = 0; i < len; i++) {
+		hash ^= b[i];
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+/**
+ * @brief The FNV-1a offset basis.
+ */
+#define HASH_INIT 0xcbf29ce484222325ull
+
+/**
+ * @brief Hashes a value into the running hash.
+ */
+#define HASH_VALUE(hash, value) Hash(hash, &(value), sizeof(value))
+
+/**
+ * @return The hash of the light source parameters.
+ */
+uint64_t HashLight(const light_t *light) {
+
+	uint64_t hash = HASH_INIT;
+
+	hash = HASH_VALUE(hash, light->type);
+	hash = HASH_VALUE(hash, light->atten);
+	hash = HASH_VALUE(hash, light->origin);
+	hash = HASH_VALUE(hash, light->color);
+	hash = HASH_VALUE(hash, light->normal);
+	hash = HASH_VALUE(hash, light->radius);
+	hash = HASH_VALUE(hash, light->intensity);
+	hash = HASH_VALUE(hash, light->cone);
+	hash = HASH_VALUE(hash, light->falloff);
+	hash = HASH_VALUE(hash, light->shadow);
+	hash = HASH_VALUE(hash, light->size);
+	hash = HASH_VALUE(hash, light->bounds);
+
+	hash = Hash(hash, light->points, light->num_points * sizeof(vec3_t));
+
+	if (light->plane) {
+		hash = HASH_VALUE(hash, light->plane->normal);
+		hash = HASH_VALUE(hash, light->plane->dist);
+	}
+
+	if (light->model) {
+		hash = HASH_VALUE(hash, light->model->head_node);
+	}
+
+	return hash;
+}
+
+/**
+ * @return The hash of the brush, including all of the attributes that may affect lighting.
+ */
+static uint64_t HashBrush(const cm_bsp_brush_t *brush) {
+
+	uint64_t hash = HASH_INIT;
+
+	hash = HASH_VALUE(hash, brush->contents);
+
+	const cm_bsp_brush_side_t *side = brush->brush_sides;
+	for (int32_t i = 0; i < brush->num_brush_sides; i++, side++) {
+
+		hash = HASH_VALUE(hash, side->plane->normal);
+		hash = HASH_VALUE(hash, side->plane->dist);
+		hash = HASH_VALUE(hash, side->contents);
+		hash = HASH_VALUE(hash, side->surface);
+
+		if (side->material) {
+			hash = Hash(hash, side->material->name, strlen(side->material->name));
+		}
+	}
+
+	return hash;
+}
+
+/**
+ * @return The hash of the lightmap geometry and material, which identifies it across compiles.
+ */
+static uint64_t HashLightmap(const lightmap_t *lm) {
+
+	uint64_t hash = HASH_INIT;
+
+	hash = HASH_VALUE(hash, lm->w);
+	hash = HASH_VALUE(hash, lm->h);
+	hash = HASH_VALUE(hash, lm->model->head_node);
+	hash = HASH_VALUE(hash, lm->brush_side->surface);
+	hash = HASH_VALUE(hash, lm->brush_side->contents);
+
+	hash = Hash(hash, lm->material->cm->name, strlen(lm->material->cm->name));
+
+	const luxel_t *l = lm->luxels;
+	for (size_t i = 0; i < lm->num_luxels; i++, l++) {
+		hash = HASH_VALUE(hash, l->origin);
+		hash = HASH_VALUE(hash, l->normal);
+	}
+
+	return hash;
+}
+
+/**
+ * @return The key of the specified phase, given the geometry key and the light sources.
+ * @remarks Light hashes are summed, so that the key does not depend on their order.
+ */
+static uint64_t PhaseKey(uint64_t key, light_cache_phase_t phase, const GPtrArray *lights) {
+
+	uint64_t sum = 0;
+
+	if (lights) {
+		for (guint i = 0; i < lights->len; i++) {
+			sum += ((const light_t *) g_ptr_array_index(lights, i))->hash;
+		}
+	}
+
+	key = HASH_VALUE(key, phase);
+	key = HASH_VALUE(key, sum);
+
+	return key;
+}
+
+/**
+ * @return True if the segment intersects the box, using the slab method.
+ */
+static bool SegmentIntersectsBox(const vec3_t start, const vec3_t end, const box3_t box) {
+
+	float t_min = 0.f, t_max = 1.f;
+
+	for (int32_t i = 0; i < 3; i++) {
+		const float d = end.xyz[i] - start.xyz[i];
+
+		if (fabsf(d) < FLT_EPSILON) {
+			if (start.xyz[i] < box.mins.xyz[i] || start.xyz[i] > box.maxs.xyz[i]) {
+				return false;
+			}
+			continue;
+		}
+
+		float t1 = (box.mins.xyz[i] - start.xyz[i]) / d;
+		float t2 = (box.maxs.xyz[i] - start.xyz[i]) / d;
+
+		if (t1 > t2) {
+			const float swap = t1;
+			t1 = t2;
+			t2 = swap;
+		}
+
+		t_min = Maxf(t_min, t1);
+		t_max = Minf(t_max, t2);
+
+		if (t_min > t_max) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @return True if the light source's contribution to the given bounds may have been altered
+ * by a change in geometry. The changed geometry must lie between the light and the bounds.
+ */
+static bool LightDirty(const light_t *light, const box3_t bounds, const box3_t dirty) {
+
+	switch (light->type) {
+		case LIGHT_AMBIENT:
+			return Box3_Intersects(Box3_Expand(bounds, light->radius), dirty);
+
+		case LIGHT_SUN: {
+			// sun samples are jittered, so pad the swept bounds generously
+			const vec3_t center = Box3_Center(bounds);
+			const box3_t swept = Box3_Expand3(dirty, Vec3_Add(Box3_Extents(bounds), Vec3(64.f, 64.f, 64.f)));
+
+			for (int32_t i = 0; i < light->num_points; i++) {
+				const vec3_t end = Vec3_Fmaf(center, MAX_WORLD_DIST, Vec3_Negate(light->points[i]));
+				if (SegmentIntersectsBox(center, end, swept)) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		default:
+			return Box3_Intersects(light->bounds, dirty);
+	}
+}
+
+/**
+ * @return True if the results of the specified phase may have been altered by a change in
+ * geometry, independent of the phase key.
+ */
+static bool PhaseDirty(light_cache_phase_t phase, const GPtrArray *lights, const box3_t bounds) {
+
+	const box3_t *dirty = (const box3_t *) light_cache.dirty->data;
+
+	for (guint i = 0; i < light_cache.dirty->len; i++, dirty++) {
+
+		if (phase == LIGHT_CACHE_CAUSTICS) {
+			if (Box3_Intersects(Box3_Expand(bounds, LIGHT_CACHE_CAUSTICS_DIST), *dirty)) {
+				return true;
+			}
+			continue;
+		}
+
+		for (guint j = 0; j < lights->len; j++) {
+			if (LightDirty(g_ptr_array_index(lights, j), bounds, *dirty)) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief Sort comparator for light cache brushes, by hash.
+ */
+static int32_t BrushCmp(const void *a, const void *b) {
+
+	const uint64_t ha = ((const light_cache_brush_t *) a)->hash;
+	const uint64_t hb = ((const light_cache_brush_t *) b)->hash;
+
+	return ha < hb ? -1 : ha > hb ? 1 : 0;
+}
+
+/**
+ * @brief Hashes the brushes of the current BSP, and resolves the bounds of those that
+ * differ from the previous compile.
+ */
+static void ResolveDirtyBrushes(void) {
+
+	const cm_bsp_t *bsp = Cm_Bsp();
+
+	light_cache.out.brushes = g_array_sized_new(false, false, sizeof(light_cache_brush_t), bsp->num_brushes);
+
+	const cm_bsp_brush_t *brush = bsp->brushes;
+	for (int32_t i = 0; i < bsp->num_brushes; i++, brush++) {
+		g_array_append_vals(light_cache.out.brushes, &(const light_cache_brush_t) {
+			.hash = HashBrush(brush),
+			.bounds = brush->bounds
+		}, 1);
+	}
+
+	g_array_sort(light_cache.out.brushes, BrushCmp);
+
+	light_cache.dirty = g_array_new(false, false, sizeof(box3_t));
+
+	const GArray *in = light_cache.in.brushes, *out = light_cache.out.brushes;
+
+	guint i = 0, j = 0;
+	while (i < in->len || j < out->len) {
+
+		const light_cache_brush_t *a = i < in->len ? &g_array_index(in, light_cache_brush_t, i) : NULL;
+		const light_cache_brush_t *b = j < out->len ? &g_array_index(out, light_cache_brush_t, j) : NULL;
+
+		if (a && b && a->hash == b->hash) {
+			i++, j++;
+		} else if (b == NULL || (a && a->hash < b->hash)) {
+			g_array_append_val(light_cache.dirty, a->bounds);
+			i++;
+		} else {
+			g_array_append_val(light_cache.dirty, b->bounds);
+			j++;
+		}
+	}
+}
+
+/**
+ * @brief Reads `size` bytes from the cache buffer at `offset`.
+ * @return True on success, false if the buffer is exhausted.
+ */
+static bool ReadLightCache(const byte *buffer, int64_t len, int64_t *offset, void *out, size_t size) {
+
+	if (*offset + (int64_t) size > len) {
+		return false;
+	}
+
+	memcpy(out, buffer + *offset, size);
+	*offset += size;
+
+	return true;
+}
+
+/**
+ * @return The light cache options hash, which must match for any results to be reused.
+ * @remarks Every pair of the worldspawn entity is hashed, so that changes to its lighting
+ * keys, such as ambient, invalidate the cache.
+ */
+static uint64_t LightCacheOptions(void) {
+
+	uint64_t hash = HASH_INIT;
+
+	const int32_t version = LIGHT_CACHE_VERSION;
+
+	hash = HASH_VALUE(hash, version);
+	hash = HASH_VALUE(hash, antialias);
+	hash = HASH_VALUE(hash, occlusion_bvh);
+
+	const cm_bsp_t *bsp = Cm_Bsp();
+
+	if (bsp->num_entities) {
+		for (const cm_entity_t *e = bsp->entities[0]; e; e = e->next) {
+			hash = Hash(hash, e->key, strlen(e->key) + 1);
+			hash = Hash(hash, e->string, strlen(e->string) + 1);
+		}
+	}
+
+	return hash;
+}
+
+/**
+ * @brief Frees the specified cache.
+ */
+static void FreeLightCache_(light_cache_t *cache) {
+
+	if (cache->brushes) {
+		g_array_free(cache->brushes, true);
+	}
+
+	if (cache->lights) {
+		g_hash_table_destroy(cache->lights);
+	}
+
+	for (int32_t i = 0; i < cache->num_faces; i++) {
+		Mem_Free(cache->faces[i].luxels);
+	}
+
+	Mem_Free(cache->faces);
+
+	Mem_Free(cache->lightgrid.phases);
+	Mem_Free(cache->lightgrid.luxels);
+
+	memset(cache, 0, sizeof(*cache));
+}
+
+/**
+ * @brief Parses the light cache from the previous compile into `light_cache.in`.
+ * @return True on success, false if the cache is missing, stale or corrupt.
+ */
+static bool ParseLightCache(const byte *buffer, int64_t len) {
+
+	light_cache_t *in = &light_cache.in;
+
+	int64_t offset = 0;
+	int32_t ident, count;
+
+	if (!ReadLightCache(buffer, len, &offset, &ident, sizeof(ident)) || ident != LIGHT_CACHE_IDENT) {
+		return false;
+	}
+
+	if (!ReadLightCache(buffer, len, &offset, &in->options, sizeof(in->options))) {
+		return false;
+	}
+
+	if (in->options != LightCacheOptions()) {
+		return false;
+	}
+
+	if (!ReadLightCache(buffer, len, &offset, &count, sizeof(count)) || count < 0) {
+		return false;
+	}
+
+	in->brushes = g_array_sized_new(false, false, sizeof(light_cache_brush_t), count);
+	g_array_set_size(in->brushes, count);
+
+	if (!ReadLightCache(buffer, len, &offset, in->brushes->data, count * sizeof(light_cache_brush_t))) {
+		return false;
+	}
+
+	if (!ReadLightCache(buffer, len, &offset, &count, sizeof(count)) || count < 0) {
+		return false;
+	}
+
+	in->lights = g_hash_table_new_full(g_int64_hash, g_int64_equal, NULL, g_free);
+
+	for (int32_t i = 0; i < count; i++) {
+		light_cache_light_t *light = g_new(light_cache_light_t, 1);
+
+		if (!ReadLightCache(buffer, len, &offset, light, sizeof(*light))) {
+			g_free(light);
+			return false;
+		}
+
+		g_hash_table_replace(in->lights, &light->hash, light);
+	}
+
+	if (!ReadLightCache(buffer, len, &offset, &in->num_faces, sizeof(in->num_faces)) || in->num_faces < 0) {
+		in->num_faces = 0;
+		return false;
+	}
+
+	in->faces = Mem_TagMalloc(in->num_faces * sizeof(light_cache_face_t), MEM_TAG_LIGHT);
+
+	for (int32_t i = 0; i < in->num_faces; i++) {
+		light_cache_face_t *face = &in->faces[i];
+
+		if (!ReadLightCache(buffer, len, &offset, &face->key, sizeof(face->key)) ||
+			!ReadLightCache(buffer, len, &offset, face->phases, sizeof(face->phases)) ||
+			!ReadLightCache(buffer, len, &offset, &face->num_luxels, sizeof(face->num_luxels)) ||
+			face->num_luxels < 0) {
+			face->num_luxels = 0;
+			return false;
+		}
+
+		const size_t size = face->num_luxels * sizeof(light_cache_luxel_t);
+
+		face->luxels = Mem_TagMalloc(size, MEM_TAG_LIGHT);
+
+		if (!ReadLightCache(buffer, len, &offset, face->luxels, size)) {
+			return false;
+		}
+	}
+
+	light_cache_lightgrid_t *lightgrid = &in->lightgrid;
+
+	if (!ReadLightCache(buffer, len, &offset, &lightgrid->size, sizeof(lightgrid->size)) ||
+		!ReadLightCache(buffer, len, &offset, &lightgrid->matrix, sizeof(lightgrid->matrix)) ||
+		!ReadLightCache(buffer, len, &offset, &lightgrid->num_luxels, sizeof(lightgrid->num_luxels)) ||
+		lightgrid->num_luxels < 0) {
+		lightgrid->num_luxels = 0;
+		return false;
+	}
+
+	const size_t phases_size = lightgrid->num_luxels * sizeof(*lightgrid->phases);
+	const size_t luxels_size = lightgrid->num_luxels * sizeof(*lightgrid->luxels);
+
+	lightgrid->phases = Mem_TagMalloc(phases_size, MEM_TAG_LIGHT);
+	lightgrid->luxels = Mem_TagMalloc(luxels_size, MEM_TAG_LIGHT);
+
+	if (!ReadLightCache(buffer, len, &offset, lightgrid->phases, phases_size) ||
+		!ReadLightCache(buffer, len, &offset, lightgrid->luxels, luxels_size)) {
+		return false;
+	}
+
+	return offset == len;
+}
+
+/**
+ * @return The light cache path for the current map.
+ */
+static const char *LightCachePath(void) {
+	return va("maps/%s.lightcache", map_base);
+}
+
+/**
+ * @brief Loads the light cache from the previous compile, if any, and resolves the geometry
+ * that has changed since. Must be called after the lightmaps and lightgrid are built.
+ */
+void LoadLightCache(void) {
+
+	const uint32_t start = SDL_GetTicks();
+
+	memset(&light_cache, 0, sizeof(light_cache));
+
+	void *buffer;
+	const int64_t len = Fs_Load(LightCachePath(), &buffer);
+
+	if (len == -1) {
+		Com_Verbose("No light cache found, lighting all faces\n");
+	} else {
+		const bool valid = ParseLightCache(buffer, len);
+
+		Fs_Free(buffer);
+
+		if (!valid) {
+			Com_Warn("Light cache is stale or invalid, lighting all faces\n");
+			FreeLightCache_(&light_cache.in);
+		}
+	}
+
+	light_cache.in_faces = g_hash_table_new(g_int64_hash, g_int64_equal);
+
+	for (int32_t i = 0; i < light_cache.in.num_faces; i++) {
+		g_hash_table_insert(light_cache.in_faces, &light_cache.in.faces[i].key, &light_cache.in.faces[i]);
+	}
+
+	if (light_cache.in.brushes == NULL) {
+		light_cache.in.brushes = g_array_new(false, false, sizeof(light_cache_brush_t));
+	}
+
+	ResolveDirtyBrushes();
+
+	light_cache.out.options = LightCacheOptions();
+	light_cache.out.lights = g_hash_table_new_full(g_int64_hash, g_int64_equal, NULL, g_free);
+
+	light_cache.out.num_faces = bsp_file.num_faces;
+	light_cache.out.faces = Mem_TagMalloc(bsp_file.num_faces * sizeof(light_cache_face_t), MEM_TAG_LIGHT);
+
+	light_cache.face_bounds = Mem_TagMalloc(bsp_file.num_faces * sizeof(box3_t), MEM_TAG_LIGHT);
+
+	for (int32_t i = 0; i < bsp_file.num_faces; i++) {
+		const lightmap_t *lm = &lightmaps[i];
+
+		if (lm->brush_side->surface & SURF_MASK_NO_LIGHTMAP) {
+			continue;
+		}
+
+		light_cache_face_t *face = &light_cache.out.faces[i];
+
+		face->key = HashLightmap(lm);
+		face->num_luxels = (int32_t) lm->num_luxels;
+		face->luxels = Mem_TagMalloc(lm->num_luxels * sizeof(light_cache_luxel_t), MEM_TAG_LIGHT);
+
+		box3_t bounds = Box3_Null();
+
+		const luxel_t *l = lm->luxels;
+		for (size_t j = 0; j < lm->num_luxels; j++, l++) {
+			bounds = Box3_Append(bounds, l->origin);
+		}
+
+		light_cache.face_bounds[i] = Box3_Expand(bounds, BSP_LIGHTMAP_LUXEL_SIZE * 2.f);
+	}
+
+	light_cache_lightgrid_t *lightgrid = &light_cache.out.lightgrid;
+
+	lightgrid->size = lg.size;
+	lightgrid->matrix = lg.matrix;
+	lightgrid->num_luxels = (int32_t) lg.num_luxels;
+	lightgrid->phases = Mem_TagMalloc(lg.num_luxels * sizeof(*lightgrid->phases), MEM_TAG_LIGHT);
+	lightgrid->luxels = Mem_TagMalloc(lg.num_luxels * sizeof(*lightgrid->luxels), MEM_TAG_LIGHT);
+
+	// the previous lightgrid is only useful if its layout is unchanged
+	const light_cache_lightgrid_t *in = &light_cache.in.lightgrid;
+	if (in->num_luxels != lightgrid->num_luxels ||
+		memcmp(&in->size, &lightgrid->size, sizeof(vec3i_t)) ||
+		memcmp(&in->matrix, &lightgrid->matrix, sizeof(mat4_t))) {
+
+		Mem_Free(light_cache.in.lightgrid.phases);
+		Mem_Free(light_cache.in.lightgrid.luxels);
+
+		memset(&light_cache.in.lightgrid, 0, sizeof(light_cache.in.lightgrid));
+	}
+
+	Com_Print("\r%-24s [100%%] %d ms\n", "Loading light cache", SDL_GetTicks() - start);
+
+	Com_Verbose("Light cache: %d faces, %d changed brushes\n", light_cache.in.num_faces, light_cache.dirty->len);
+}
+
+/**
+ * @brief Snapshots the results of the specified phase from the luxel.
+ */
+static void CacheLuxel(light_cache_luxel_t *out, light_cache_phase_t phase, const luxel_t *l) {
+
+	switch (phase) {
+		case LIGHT_CACHE_DIRECT:
+			out->ambient = l->ambient;
+			out->diffuse = l->diffuse;
+			out->direction = l->direction;
+			break;
+		case LIGHT_CACHE_INDIRECT:
+			out->indirect = Vec3_Subtract(l->ambient, out->ambient);
+			break;
+		case LIGHT_CACHE_CAUSTICS:
+			out->caustics = l->caustics;
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+ * @brief Restores the results of the specified phase to the luxel.
+ */
+static void RestoreLuxel(const light_cache_luxel_t *in, light_cache_phase_t phase, luxel_t *l) {
+
+	switch (phase) {
+		case LIGHT_CACHE_DIRECT:
+			l->ambient = in->ambient;
+			l->diffuse = in->diffuse;
+			l->direction = in->direction;
+			break;
+		case LIGHT_CACHE_INDIRECT:
+			l->ambient = Vec3_Add(l->ambient, in->indirect);
+			break;
+		case LIGHT_CACHE_CAUSTICS:
+			l->caustics = in->caustics;
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+ * @brief Restores the specified phase of the lightmap from the previous compile, if neither
+ * the face, its light sources, nor the geometry between them have changed.
+ * @return True if the phase was restored, false if it must be computed.
+ */
+bool RestoreLightmap(int32_t face_num, light_cache_phase_t phase, const GPtrArray *lights) {
+
+	if (!incremental) {
+		return false;
+	}
+
+	light_cache_face_t *out = &light_cache.out.faces[face_num];
+
+	out->phases[phase] = PhaseKey(out->key, phase, lights);
+
+	const light_cache_face_t *in = g_hash_table_lookup(light_cache.in_faces, &out->key);
+	if (in == NULL || in->phases[phase] != out->phases[phase] || in->num_luxels != out->num_luxels) {
+		SDL_AtomicAdd(&light_cache.computed, 1);
+		return false;
+	}
+
+	if (PhaseDirty(phase, lights, light_cache.face_bounds[face_num])) {
+		SDL_AtomicAdd(&light_cache.computed, 1);
+		return false;
+	}
+
+	const lightmap_t *lm = &lightmaps[face_num];
+
+	for (int32_t i = 0; i < out->num_luxels; i++) {
+		RestoreLuxel(&in->luxels[i], phase, &lm->luxels[i]);
+		CacheLuxel(&out->luxels[i], phase, &lm->luxels[i]);
+	}
+
+	SDL_AtomicAdd(&light_cache.restored, 1);
+	return true;
+}
+
+/**
+ * @brief Caches the results of the specified phase of the lightmap for the next compile.
+ */
+void CacheLightmap(int32_t face_num, light_cache_phase_t phase) {
+
+	if (!incremental) {
+		return;
+	}
+
+	light_cache_face_t *out = &light_cache.out.faces[face_num];
+
+	const lightmap_t *lm = &lightmaps[face_num];
+
+	for (int32_t i = 0; i < out->num_luxels; i++) {
+		CacheLuxel(&out->luxels[i], phase, &lm->luxels[i]);
+	}
+}
+
+/**
+ * @brief Restores the specified phase of the lightgrid luxel from the previous compile, if
+ * neither its light sources nor the geometry between them have changed.
+ * @return True if the phase was restored, false if it must be computed.
+ */
+bool RestoreLightgrid(int32_t luxel_num, light_cache_phase_t phase, const GPtrArray *lights, const box3_t bounds) {
+
+	if (!incremental) {
+		return false;
+	}
+
+	light_cache_lightgrid_t *out = &light_cache.out.lightgrid;
+
+	uint64_t key = HASH_INIT;
+	key = HASH_VALUE(key, luxel_num);
+
+	out->phases[luxel_num][phase] = PhaseKey(key, phase, lights);
+
+	const light_cache_lightgrid_t *in = &light_cache.in.lightgrid;
+	if (in->num_luxels == 0 || in->phases[luxel_num][phase] != out->phases[luxel_num][phase]) {
+		SDL_AtomicAdd(&light_cache.computed_lightgrid, 1);
+		return false;
+	}
+
+	if (PhaseDirty(phase, lights, bounds)) {
+		SDL_AtomicAdd(&light_cache.computed_lightgrid, 1);
+		return false;
+	}
+
+	luxel_t *l = &lg.luxels[luxel_num];
+
+	RestoreLuxel(&in->luxels[luxel_num], phase, l);
+	CacheLuxel(&out->luxels[luxel_num], phase, l);
+
+	SDL_AtomicAdd(&light_cache.restored_lightgrid, 1);
+	return true;
+}
+
+/**
+ * @brief Caches the results of the specified phase of the lightgrid luxel for the next compile.
+ */
+void CacheLightgrid(int32_t luxel_num, light_cache_phase_t phase) {
+
+	if (!incremental) {
+		return;
+	}
+
+	CacheLuxel(&light_cache.out.lightgrid.luxels[luxel_num], phase, &lg.luxels[luxel_num]);
+}
+
+/**
+ * @brief Merges the cached visible bounds of the light source into its own, as faces restored
+ * from the cache do not contribute to them, and records the result for the next compile.
+ */
+void RestoreLightBounds(light_t *light) {
+
+	if (!incremental) {
+		return;
+	}
+
+	if (light_cache.in.lights) {
+		const light_cache_light_t *in = g_hash_table_lookup(light_cache.in.lights, &light->hash);
+		if (in) {
+			light->visible_bounds = Box3_Union(light->visible_bounds, in->bounds);
+		}
+	}
+
+	light_cache_light_t *out = g_new(light_cache_light_t, 1);
+
+	out->hash = light->hash;
+	out->bounds = light->visible_bounds;
+
+	g_hash_table_replace(light_cache.out.lights, &out->hash, out);
+}
+
+/**
+ * @brief Writes the light cache for the next compile.
+ */
+void WriteLightCache(void) {
+
+	const uint32_t start = SDL_GetTicks();
+
+	file_t *file = Fs_OpenWrite(LightCachePath());
+	if (file == NULL) {
+		Com_Warn("Failed to open %s\n", LightCachePath());
+		return;
+	}
+
+	const light_cache_t *out = &light_cache.out;
+
+	const int32_t ident = LIGHT_CACHE_IDENT;
+	Fs_Write(file, &ident, sizeof(ident), 1);
+	Fs_Write(file, &out->options, sizeof(out->options), 1);
+
+	const int32_t num_brushes = out->brushes->len;
+	Fs_Write(file, &num_brushes, sizeof(num_brushes), 1);
+	Fs_Write(file, out->brushes->data, sizeof(light_cache_brush_t), num_brushes);
+
+	const int32_t num_lights = g_hash_table_size(out->lights);
+	Fs_Write(file, &num_lights, sizeof(num_lights), 1);
+
+	GHashTableIter iter;
+	gpointer value;
+
+	g_hash_table_iter_init(&iter, out->lights);
+	while (g_hash_table_iter_next(&iter, NULL, &value)) {
+		Fs_Write(file, value, sizeof(light_cache_light_t), 1);
+	}
+
+	int32_t num_faces = 0;
+	for (int32_t i = 0; i < out->num_faces; i++) {
+		if (out->faces[i].luxels) {
+			num_faces++;
+		}
+	}
+
+	Fs_Write(file, &num_faces, sizeof(num_faces), 1);
+
+	for (int32_t i = 0; i < out->num_faces; i++) {
+		const light_cache_face_t *face = &out->faces[i];
+
+		if (face->luxels) {
+			Fs_Write(file, &face->key, sizeof(face->key), 1);
+			Fs_Write(file, face->phases, sizeof(face->phases), 1);
+			Fs_Write(file, &face->num_luxels, sizeof(face->num_luxels), 1);
+			Fs_Write(file, face->luxels, sizeof(light_cache_luxel_t), face->num_luxels);
+		}
+	}
+
+	const light_cache_lightgrid_t *lightgrid = &out->lightgrid;
+
+	Fs_Write(file, &lightgrid->size, sizeof(lightgrid->size), 1);
+	Fs_Write(file, &lightgrid->matrix, sizeof(lightgrid->matrix), 1);
+	Fs_Write(file, &lightgrid->num_luxels, sizeof(lightgrid->num_luxels), 1);
+	Fs_Write(file, lightgrid->phases, sizeof(*lightgrid->phases), lightgrid->num_luxels);
+	Fs_Write(file, lightgrid->luxels, sizeof(*lightgrid->luxels), lightgrid->num_luxels);
+
+	Fs_Close(file);
+
+	Com_Print("\r%-24s [100%%] %d ms\n", "Writing light cache", SDL_GetTicks() - start);
+
+	const int32_t restored = SDL_AtomicGet(&light_cache.restored);
+	const int32_t computed = SDL_AtomicGet(&light_cache.computed);
+
+	Com_Verbose("Light cache: restored %d, computed %d lightmap phases\n", restored, computed);
+
+	const int32_t restored_lightgrid = SDL_AtomicGet(&light_cache.restored_lightgrid);
+	const int32_t computed_lightgrid = SDL_AtomicGet(&light_cache.computed_lightgrid);
+
+	Com_Verbose("Light cache: restored %d, computed %d lightgrid phases\n", restored_lightgrid, computed_lightgrid);
+}
+
+/**
+ * @brief Frees the light cache.
+ */
+void FreeLightCache(void) {
+
+	FreeLightCache_(&light_cache.in);
+	FreeLightCache_(&light_cache.out);
+
+	if (light_cache.in_faces) {
+		g_hash_table_destroy(light_cache.in_faces);
+	}
+
+	if (light_cache.dirty) {
+		g_array_free(light_cache.dirty, true);
+	}
+
+	Mem_Free(light_cache.face_bounds);
+
+	memset(&light_cache, 0, sizeof(light_cache));
+}
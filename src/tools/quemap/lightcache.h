@@ -0,0 +1,44 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#pragma once
+
+#include "light.h"
+
+/**
+ * @brief The lighting phases whose results are cached per lightmap and lightgrid luxel.
+ */
+typedef enum {
+	LIGHT_CACHE_DIRECT,
+	LIGHT_CACHE_INDIRECT,
+	LIGHT_CACHE_CAUSTICS,
+	LIGHT_CACHE_PHASES
+} light_cache_phase_t;
+
+uint64_t HashLight(const light_t *light);
+void LoadLightCache(void);
+bool RestoreLightmap(int32_t face_num, light_cache_phase_t phase, const GPtrArray *lights);
+void CacheLightmap(int32_t face_num, light_cache_phase_t phase);
+bool RestoreLightgrid(int32_t luxel_num, light_cache_phase_t phase, const GPtrArray *lights, const box3_t bounds);
+void CacheLightgrid(int32_t luxel_num, light_cache_phase_t phase);
+void RestoreLightBounds(light_t *light);
+void WriteLightCache(void);
+void FreeLightCache(void);
@@ -209,19 +209,20 @@ static void LightgridLuxel_Point(light_t *light, luxel_t *luxel, float scale) {
 
 	const float lumens = atten * scale / light->num_points;
 
-	for (int32_t i = 0; i < light->num_points; i++) {
+	light_packet_t packet = {
+		.luxel = luxel
+	};
 
-		const cm_trace_t trace = Light_Trace(luxel->origin, light->points[i], 0, CONTENTS_SOLID);
-		if (trace.fraction < 1.f) {
-			continue;
-		}
+	for (int32_t i = 0; i < light->num_points; i++) {
 
-		Luxel_Illuminate(luxel, &(const lumen_t) {
+		Light_PacketAdd(&packet, light->points[i], &(const lumen_t) {
 			.light = light,
 			.direction = Vec3_Direction(light->points[i], luxel->origin),
 			.lumens = lumens,
 		});
 	}
+
+	Light_PacketFlush(&packet);
 }
 
 /**
@@ -249,6 +250,10 @@ static void LightgridLuxel_Spot(light_t *light, luxel_t *luxel, float scale) {
 			break;
 	}
 
+	light_packet_t packet = {
+		.luxel = luxel
+	};
+
 	for (int32_t i = 0; i < light->num_points; i++) {
 
 		float lumens = atten * scale / light->num_points;
@@ -264,17 +269,14 @@ static void LightgridLuxel_Spot(light_t *light, luxel_t *luxel, float scale) {
 			lumens *= Smoothf(dot, light->phi, light->theta);
 		}
 
-		const cm_trace_t trace = Light_Trace(luxel->origin, light->points[i], 0, CONTENTS_SOLID);
-		if (trace.fraction < 1.f) {
-			continue;
-		}
-
-		Luxel_Illuminate(luxel, &(const lumen_t) {
+		Light_PacketAdd(&packet, light->points[i], &(const lumen_t) {
 			.light = light,
 			.direction = dir,
 			.lumens = lumens,
 		});
 	}
+
+	Light_PacketFlush(&packet);
 }
 
 /**
@@ -306,6 +308,10 @@ static void LightgridLuxel_BrushSide(light_t *light, luxel_t *luxel, float scale
 			break;
 	}
 
+	light_packet_t packet = {
+		.luxel = luxel
+	};
+
 	for (int32_t i = 0; i < light->num_points; i++) {
 
 		float lumens = atten * scale / light->num_points;
@@ -321,17 +327,14 @@ static void LightgridLuxel_BrushSide(light_t *light, luxel_t *luxel, float scale
 			lumens *= Smoothf(dot, light->phi, light->theta);
 		}
 
-		const cm_trace_t trace = Light_Trace(luxel->origin, light->points[i], 0, CONTENTS_SOLID);
-		if (trace.fraction < 1.f) {
-			continue;
-		}
-
-		Luxel_Illuminate(luxel, &(const lumen_t) {
+		Light_PacketAdd(&packet, light->points[i], &(const lumen_t) {
 			.light = light,
 			.direction = dir,
 			.lumens = lumens,
 		});
 	}
+
+	Light_PacketFlush(&packet);
 }
 
 /**
@@ -355,18 +358,19 @@ static void LightgridLuxel_Patch(light_t *light, luxel_t *luxel, float scale) {
 	const float atten = Clampf(1.f - dist / light->radius, 0.f, 1.f);
 	const float lumens = atten * scale / light->num_points;
 
-	for (int32_t i = 0; i < light->num_points; i++) {
+	light_packet_t packet = {
+		.luxel = luxel
+	};
 
-		const cm_trace_t trace = Light_Trace(luxel->origin, light->points[i], 0, CONTENTS_SOLID);
-		if (trace.fraction < 1.f) {
-			continue;
-		}
+	for (int32_t i = 0; i < light->num_points; i++) {
 
-		Luxel_Illuminate(luxel, &(const lumen_t) {
+		Light_PacketAdd(&packet, light->points[i], &(const lumen_t) {
 			.light = light,
 			.lumens = lumens,
 		});
 	}
+
+	Light_PacketFlush(&packet);
 }
 
 /**
@@ -406,6 +410,16 @@ static inline void LightgridLuxel(const GPtrArray *lights, luxel_t *luxel, float
 	}
 }
 
+/**
+ * @return The bounds of the given luxel, including its antialiasing sample offsets.
+ */
+static box3_t LightgridLuxelBounds(luxel_t *l) {
+
+	ProjectLightgridLuxel(l, 0.f, 0.f, 0.f);
+
+	return Box3_Expand(Box3_FromPoints(&l->origin, 1), BSP_LIGHTGRID_LUXEL_SIZE * 0.5f);
+}
+
 /**
  * @brief
  */
@@ -423,6 +437,15 @@ void DirectLightgrid(int32_t luxel_num) {
 
 	luxel_t *l = &lg.luxels[luxel_num];
 
+	const box3_t bounds = LightgridLuxelBounds(l);
+
+	GPtrArray *lights = BoxLights(bounds);
+
+	if (RestoreLightgrid(luxel_num, LIGHT_CACHE_DIRECT, lights, bounds)) {
+		g_ptr_array_free(lights, true);
+		return;
+	}
+
 	for (size_t i = 0; i < lengthof(offsets); i++) {
 
 		const float soffs = offsets[i].x;
@@ -433,13 +456,12 @@ void DirectLightgrid(int32_t luxel_num) {
 			continue;
 		}
 
-		const GPtrArray *lights = leaf_lights[Cm_PointLeafnum(l->origin, 0)];
-		if (!lights) {
-			continue;
-		}
-
 		LightgridLuxel(lights, l, weight);
 	}
+
+	CacheLightgrid(luxel_num, LIGHT_CACHE_DIRECT);
+
+	g_ptr_array_free(lights, true);
 }
 
 /**
@@ -459,6 +481,15 @@ void IndirectLightgrid(int32_t luxel_num) {
 
 	luxel_t *l = &lg.luxels[luxel_num];
 
+	const box3_t bounds = LightgridLuxelBounds(l);
+
+	GPtrArray *lights = BoxLights(bounds);
+
+	if (RestoreLightgrid(luxel_num, LIGHT_CACHE_INDIRECT, lights, bounds)) {
+		g_ptr_array_free(lights, true);
+		return;
+	}
+
 	for (size_t i = 0; i < lengthof(offsets); i++) {
 
 		const float soffs = offsets[i].x;
@@ -469,13 +500,12 @@ void IndirectLightgrid(int32_t luxel_num) {
 			continue;
 		}
 
-		const GPtrArray *lights = leaf_lights[Cm_PointLeafnum(l->origin, 0)];
-		if (!lights) {
-			continue;
-		}
-
 		LightgridLuxel(lights, l, weight);
 	}
+
+	CacheLightgrid(luxel_num, LIGHT_CACHE_INDIRECT);
+
+	g_ptr_array_free(lights, true);
 }
 
 /**
@@ -542,6 +572,10 @@ void CausticsLightgrid(int32_t luxel_num) {
 
 	luxel_t *l = &lg.luxels[luxel_num];
 
+	if (RestoreLightgrid(luxel_num, LIGHT_CACHE_CAUSTICS, NULL, LightgridLuxelBounds(l))) {
+		return;
+	}
+
 	for (size_t i = 0; i < lengthof(offsets); i++) {
 
 		const float soffs = offsets[i].x;
@@ -554,6 +588,8 @@ void CausticsLightgrid(int32_t luxel_num) {
 
 		CausticsLightgridLuxel(l, weight);
 	}
+
+	CacheLightgrid(luxel_num, LIGHT_CACHE_CAUSTICS);
 }
 
 /**
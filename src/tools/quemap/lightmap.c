@@ -365,19 +365,21 @@ static void LightmapLuxel_Point(light_t *light, const lightmap_t *lightmap, luxe
 
 	const float lumens = atten * scale / light->num_points;
 
-	for (int32_t i = 0; i < light->num_points; i++) {
+	light_packet_t packet = {
+		.luxel = luxel,
+		.head_node = lightmap->model->head_node
+	};
 
-		const cm_trace_t trace = Light_Trace(luxel->origin, light->points[i], lightmap->model->head_node, CONTENTS_SOLID);
-		if (trace.fraction < 1.f) {
-			continue;
-		}
+	for (int32_t i = 0; i < light->num_points; i++) {
 
-		Luxel_Illuminate(luxel, &(const lumen_t) {
+		Light_PacketAdd(&packet, light->points[i], &(const lumen_t) {
 			.light = light,
 			.direction = Vec3_Direction(light->points[i], luxel->origin),
 			.lumens = lumens,
 		});
 	}
+
+	Light_PacketFlush(&packet);
 }
 
 /**
@@ -405,6 +407,11 @@ static void LightmapLuxel_Spot(light_t *light, const lightmap_t *lightmap, luxel
 			break;
 	}
 
+	light_packet_t packet = {
+		.luxel = luxel,
+		.head_node = lightmap->model->head_node
+	};
+
 	for (int32_t i = 0; i < light->num_points; i++) {
 
 		float lumens = atten * scale / light->num_points;
@@ -420,17 +427,14 @@ static void LightmapLuxel_Spot(light_t *light, const lightmap_t *lightmap, luxel
 			lumens *= Smoothf(dot, light->phi, light->theta);
 		}
 
-		const cm_trace_t trace = Light_Trace(luxel->origin, light->points[i], lightmap->model->head_node, CONTENTS_SOLID);
-		if (trace.fraction < 1.f) {
-			continue;
-		}
-
-		Luxel_Illuminate(luxel, &(const lumen_t) {
+		Light_PacketAdd(&packet, light->points[i], &(const lumen_t) {
 			.light = light,
 			.direction = dir,
 			.lumens = lumens,
 		});
 	}
+
+	Light_PacketFlush(&packet);
 }
 
 /**
@@ -462,6 +466,11 @@ static void LightmapLuxel_BrushSide(light_t *light, const lightmap_t *lightmap,
 			break;
 	}
 
+	light_packet_t packet = {
+		.luxel = luxel,
+		.head_node = lightmap->model->head_node
+	};
+
 	for (int32_t i = 0; i < light->num_points; i++) {
 
 		float lumens = atten * scale / light->num_points;
@@ -477,17 +486,14 @@ static void LightmapLuxel_BrushSide(light_t *light, const lightmap_t *lightmap,
 			lumens *= Smoothf(dot, light->phi, light->theta);
 		}
 
-		const cm_trace_t trace = Light_Trace(luxel->origin, light->points[i], lightmap->model->head_node, CONTENTS_SOLID);
-		if (trace.fraction < 1.f) {
-			continue;
-		}
-
-		Luxel_Illuminate(luxel, &(const lumen_t) {
+		Light_PacketAdd(&packet, light->points[i], &(const lumen_t) {
 			.light = light,
 			.direction = dir,
 			.lumens = lumens,
 		});
 	}
+
+	Light_PacketFlush(&packet);
 }
 
 /**
@@ -511,18 +517,20 @@ static void LightmapLuxel_Patch(light_t *light, const lightmap_t *lightmap, luxe
 	const float atten = Clampf(1.f - dist / light->radius, 0.f, 1.f);
 	const float lumens = atten * scale / light->num_points;
 
-	for (int32_t i = 0; i < light->num_points; i++) {
+	light_packet_t packet = {
+		.luxel = luxel,
+		.head_node = lightmap->model->head_node
+	};
 
-		const cm_trace_t trace = Light_Trace(luxel->origin, light->points[i], lightmap->model->head_node, CONTENTS_SOLID);
-		if (trace.fraction < 1.f) {
-			continue;
-		}
+	for (int32_t i = 0; i < light->num_points; i++) {
 
-		Luxel_Illuminate(luxel, &(const lumen_t) {
+		Light_PacketAdd(&packet, light->points[i], &(const lumen_t) {
 			.light = light,
 			.lumens = lumens,
 		});
 	}
+
+	Light_PacketFlush(&packet);
 }
 
 /**
@@ -563,6 +571,22 @@ static inline void LightmapLuxel(const GPtrArray *lights, const lightmap_t *ligh
 	}
 }
 
+/**
+ * @return The bounds of the luxels of the given lightmap, padded to include their antialiasing
+ * sample offsets.
+ */
+static box3_t LightmapBounds(const lightmap_t *lm) {
+
+	box3_t bounds = Box3_Null();
+
+	const luxel_t *l = lm->luxels;
+	for (size_t i = 0; i < lm->num_luxels; i++, l++) {
+		bounds = Box3_Append(bounds, l->origin);
+	}
+
+	return Box3_Expand(bounds, BSP_LIGHTMAP_LUXEL_SIZE * 2.f);
+}
+
 /**
  * @brief Calculates direct lighting for the given face. Luxels are projected into world space.
  * We then query the light sources that intersect the lightmap's node, and accumulate their ambient,
@@ -582,7 +606,12 @@ void DirectLightmap(int32_t face_num) {
 		return;
 	}
 
-	const GPtrArray *lights = node_lights[lm->node - bsp_file.nodes];
+	GPtrArray *lights = BoxLights(LightmapBounds(lm));
+
+	if (RestoreLightmap(face_num, LIGHT_CACHE_DIRECT, lights)) {
+		g_ptr_array_free(lights, true);
+		return;
+	}
 
 	luxel_t *l = lm->luxels;
 	for (size_t i = 0; i < lm->num_luxels; i++, l++) {
@@ -623,6 +652,10 @@ void DirectLightmap(int32_t face_num) {
 		// re-center the luxel for any downstream operations
 		ProjectLightmapLuxel(lm, l, 0.f, 0.f);
 	}
+
+	CacheLightmap(face_num, LIGHT_CACHE_DIRECT);
+
+	g_ptr_array_free(lights, true);
 }
 
 /**
@@ -642,7 +675,12 @@ void IndirectLightmap(int32_t face_num) {
 		return;
 	}
 
-	const GPtrArray *lights = node_lights[lm->node - bsp_file.nodes];
+	GPtrArray *lights = BoxLights(LightmapBounds(lm));
+
+	if (RestoreLightmap(face_num, LIGHT_CACHE_INDIRECT, lights)) {
+		g_ptr_array_free(lights, true);
+		return;
+	}
 
 	luxel_t *l = lm->luxels;
 	for (size_t i = 0; i < lm->num_luxels; i++, l++) {
@@ -664,6 +702,10 @@ void IndirectLightmap(int32_t face_num) {
 			}
 		}
 	}
+
+	CacheLightmap(face_num, LIGHT_CACHE_INDIRECT);
+
+	g_ptr_array_free(lights, true);
 }
 
 /**
@@ -724,6 +766,10 @@ void CausticsLightmap(int32_t face_num) {
 		return;
 	}
 
+	if (RestoreLightmap(face_num, LIGHT_CACHE_CAUSTICS, NULL)) {
+		return;
+	}
+
 	luxel_t *l = lm->luxels;
 	for (size_t i = 0; i < lm->num_luxels; i++, l++) {
 
@@ -733,6 +779,8 @@ void CausticsLightmap(int32_t face_num) {
 
 		CausticsLightmapLuxel(l, 1.f);
 	}
+
+	CacheLightmap(face_num, LIGHT_CACHE_CAUSTICS);
 }
 
 /**
@@ -785,6 +833,20 @@ static void FinalizeLightmapLuxel(const lightmap_t *lightmap, luxel_t *luxel) {
 	luxel->caustics = Vec3_Clampf(luxel->caustics, 0.f, 1.f);
 }
 
+/**
+ * @return The relative cost of lighting the given face, for work ordering.
+ */
+int64_t LightmapCost(int32_t face_num) {
+
+	const lightmap_t *lm = &lightmaps[face_num];
+
+	if (lm->brush_side->surface & SURF_MASK_NO_LIGHTMAP) {
+		return 0;
+	}
+
+	return (int64_t) lm->num_luxels;
+}
+
 /**
  * @brief Finalize light values for the given face, and create its lightmap textures.
  */
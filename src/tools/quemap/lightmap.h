@@ -56,6 +56,7 @@ void BuildVertexNormals(void);
 void DirectLightmap(int32_t face_num);
 void IndirectLightmap(int32_t face_num);
 void CausticsLightmap(int32_t face_num);
+int64_t LightmapCost(int32_t face_num);
 void FinalizeLightmap(int32_t face_num);
 void EmitLightmap(void);
 void EmitLightmapTexcoords(void);
@@ -81,11 +81,18 @@ static void Error(err_t err, const char *msg) {
 }
 
 /**
- * @brief Print to stdout and, if not escaped, to the monitor socket.
+ * @brief Print to stdout and, if not escaped, to the monitor socket. Output deferred by
+ * the calling thread is collected instead.
  */
 static void Print(const char *msg) {
 
 	if (msg) {
+		GString *output = DeferredOutput();
+		if (output) {
+			g_string_append(output, *msg == '@' ? msg + 1 : msg);
+			return;
+		}
+
 		if (*msg == '@') {
 			fputs(msg + 1, stdout);
 		} else {
@@ -139,6 +146,10 @@ static void Init(void) {
 
 	Mem_Init();
 
+	// lightmap and lightgrid luxels are allocated face by face, and freed together
+	Mem_TagArena(MEM_TAG_LIGHTMAP);
+	Mem_TagArena(MEM_TAG_LIGHTGRID);
+
 	Mon_Init();
 
 	Fs_Init(FS_AUTO_LOAD_ARCHIVES);
@@ -199,6 +210,9 @@ static void Check_BSP_Options(int32_t argc) {
 		} else if (!g_strcmp0(Com_Argv(i), "--no-tjunc")) {
 			Com_Verbose("no_tjunc = true\n");
 			no_tjunc = true;
+		} else if (!g_strcmp0(Com_Argv(i), "--no-vis")) {
+			Com_Verbose("no_vis = true\n");
+			no_vis = true;
 		} else if (!g_strcmp0(Com_Argv(i), "--no-weld")) {
 			Com_Verbose("no_weld = true\n");
 			no_weld = true;
@@ -220,6 +234,12 @@ static void Check_LIGHT_Options(int32_t argc) {
 		if (!g_strcmp0(Com_Argv(i), "--antialias")) {
 			antialias = true;
 			Com_Verbose("antialias: true\n");
+		} else if (!g_strcmp0(Com_Argv(i), "--bvh")) {
+			occlusion_bvh = true;
+			Com_Verbose("bvh: true\n");
+		} else if (!g_strcmp0(Com_Argv(i), "--incremental")) {
+			incremental = true;
+			Com_Verbose("incremental: true\n");
 		} else {
 			break;
 		}
@@ -275,12 +295,15 @@ static void PrintHelpMessage(void) {
 	Com_Print(" --no-phong - don't apply Phong shading\n");
 	Com_Print(" --no-prune - don't prune unused nodes\n");
 	Com_Print(" --no-tjunc - don't fix T-junctions\n");
+	Com_Print(" --no-vis - don't calculate potentially visible sets\n");
 	Com_Print(" --no-weld - don't weld vertices\n");
 	Com_Print(" --only-ents - only update the entity string from the .map\n");
 	Com_Print("\n");
 
 	Com_Print("-light             LIGHT stage options:\n");
 	Com_Print(" --antialias - calculate extra lighting samples and average them\n");
+	Com_Print(" --bvh - trace shadows against a brush BVH rather than the BSP\n");
+	Com_Print(" --incremental - reuse lighting from the previous compile where nothing changed\n");
 	Com_Print(" --no-indirect - skip indirect lighting\n");
 	Com_Print(" --brightness <float> - brightness (default 1.0)\n");
 	Com_Print(" --contrast <float> - contrast (default 1.0)\n");
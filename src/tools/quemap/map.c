@@ -40,6 +40,7 @@ plane_t planes[MAX_BSP_PLANES];
 
 #define	PLANE_HASHES (size_t) MAX_WORLD_COORD
 static plane_t *plane_hash[PLANE_HASHES];
+static SDL_SpinLock plane_lock; // planes may be found, and created, by concurrent models
 
 box3_t map_bounds;
 
@@ -164,6 +165,8 @@ int32_t FindPlane(const vec3_t normal, double dist) {
 
 	const int32_t hash = ((int32_t) fabs(dist)) & (PLANE_HASHES - 1);
 
+	SDL_AtomicLock(&plane_lock);
+
 	// search the adjacent bins as well
 	for (int32_t i = -1; i <= 1; i++) {
 		const int32_t h = (hash + i) & (PLANE_HASHES - 1);
@@ -171,13 +174,18 @@ int32_t FindPlane(const vec3_t normal, double dist) {
 		const plane_t *p = plane_hash[h];
 		while (p) {
 			if (PlaneEqual(p, snapped, dist)) {
+				SDL_AtomicUnlock(&plane_lock);
 				return (int32_t) (ptrdiff_t) (p - planes);
 			}
 			p = p->hash_chain;
 		}
 	}
 
-	return CreatePlane(snapped, dist);
+	const int32_t plane = CreatePlane(snapped, dist);
+
+	SDL_AtomicUnlock(&plane_lock);
+
+	return plane;
 }
 
 /**
@@ -40,6 +40,8 @@ typedef struct {
 	byte buffer[MAX_MSG_SIZE];
 
 	xmlDocPtr doc;
+
+	SDL_SpinLock lock; // held while appending to, and sending from, the document
 } mon_state_t;
 
 static mon_state_t mon_state;
@@ -73,8 +75,16 @@ static void Mon_SendString(const xmlChar *string) {
  * @brief Sends the specified XML node to the stream.
  */
 static void Mon_SendXML(xmlNodePtr node) {
+	static _Thread_local bool locked;
 
 	if (node) {
+		// errors while sending route back through here, so the lock must be reentrant
+		const bool lock = !locked;
+		if (lock) {
+			SDL_AtomicLock(&mon_state.lock);
+			locked = true;
+		}
+
 		if (mon_state.doc) {
 			xmlAddChild(xmlDocGetRootElement(mon_state.doc), node);
 
@@ -90,6 +100,11 @@ static void Mon_SendXML(xmlNodePtr node) {
 		} else {
 			mon_backlog = g_list_append(mon_backlog, node);
 		}
+
+		if (lock) {
+			locked = false;
+			SDL_AtomicUnlock(&mon_state.lock);
+		}
 	}
 }
 
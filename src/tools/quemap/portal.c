@@ -145,7 +145,7 @@ static bool Portal_EntityFlood(const portal_t *p) {
 	return true;
 }
 
-static int32_t c_small_portals;
+static _Thread_local int32_t c_small_portals;
 
 /**
  * @brief
@@ -699,7 +699,7 @@ static face_t *FaceFromPortal(portal_t *p, int32_t pside) {
 	return f;
 }
 
-static int32_t c_faces;
+static _Thread_local int32_t c_faces;
 
 /**
  * @brief Create faces from portals and the brush sides they reference.
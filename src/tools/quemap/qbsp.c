@@ -28,6 +28,7 @@
 #include "portal.h"
 #include "prtfile.h"
 #include "tjunction.h"
+#include "vis.h"
 #include "writebsp.h"
 #include "qbsp.h"
 
@@ -42,6 +43,7 @@ bool no_merge = false;
 bool no_phong = false;
 bool no_prune = false;
 bool no_tjunc = false;
+bool no_vis = false;
 bool no_weld = false;
 bool only_ents = false;
 
@@ -88,15 +90,36 @@ static void ProcessWorldModel(const entity_t *e, bsp_model_t *out) {
 
 	if (!leaked) {
 		WritePortalFile(tree);
+
+		if (!no_vis) {
+			CalcVis(tree);
+		}
 	}
 
 	FreeTree(tree);
 }
 
 /**
- * @brief
+ * @brief An inline model, built concurrently with the world and other inline models.
  */
-static void ProcessInlineModel(const entity_t *e, bsp_model_t *out) {
+typedef struct {
+	const entity_t *entity;
+	tree_t *tree;
+	GString *output;
+	thread_counter_t counter;
+} inline_model_t;
+
+/**
+ * @brief Builds the tree for an inline model, deferring its output. Inline models are
+ * independent of one another, so only their emission must be serialized.
+ */
+static void BuildInlineModel(void *data) {
+
+	inline_model_t *model = data;
+
+	GString *output = DeferOutput(model->output);
+
+	const entity_t *e = model->entity;
 
 	csg_brush_t *brushes = MakeBrushes(e->first_brush, e->num_brushes);
 	if (!no_csg) {
@@ -123,16 +146,48 @@ static void ProcessInlineModel(const entity_t *e, bsp_model_t *out) {
 		FixTJunctions(tree);
 	}
 
-	out->head_node = EmitNodes(tree);
+	model->tree = tree;
 
-	FreeTree(tree);
+	DeferOutput(output);
 }
 
 /**
- * @brief
+ * @brief Emits an inline model once its tree is built.
+ */
+static void ProcessInlineModel(inline_model_t *model, bsp_model_t *out) {
+
+	Thread_Join(&model->counter);
+
+	Com_Print("%s", model->output->str);
+
+	out->head_node = EmitNodes(model->tree);
+
+	FreeTree(model->tree);
+}
+
+/**
+ * @brief Processes the world and all inline models. Inline model trees are built
+ * concurrently with the world, but all models are emitted, and their output printed,
+ * in entity order.
  */
 static void ProcessModels(void) {
 
+	inline_model_t *models = Mem_Malloc(sizeof(inline_model_t) * num_entities);
+
+	for (int32_t i = 1; i < num_entities; i++) {
+		inline_model_t *model = models + i;
+
+		model->entity = entities + i;
+
+		if (!model->entity->num_brush_sides) {
+			continue;
+		}
+
+		model->output = g_string_new(NULL);
+
+		Thread_Submit(BuildInlineModel, model, &model->counter);
+	}
+
 	for (int32_t i = 0; i < num_entities; i++) {
 		const entity_t *e = entities + i;
 
@@ -147,12 +202,20 @@ static void ProcessModels(void) {
 		if (i == 0) {
 			ProcessWorldModel(e, mod);
 		} else {
-			ProcessInlineModel(e, mod);
+			ProcessInlineModel(models + i, mod);
 		}
 		EndModel(mod);
 
 		Com_Print("\n");
 	}
+
+	for (int32_t i = 1; i < num_entities; i++) {
+		if (models[i].output) {
+			g_string_free(models[i].output, true);
+		}
+	}
+
+	Mem_Free(models);
 }
 
 /**
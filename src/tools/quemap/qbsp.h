@@ -34,6 +34,7 @@ extern bool no_merge;
 extern bool no_phong;
 extern bool no_prune;
 extern bool no_tjunc;
+extern bool no_vis;
 extern bool no_weld;
 extern bool only_ents;
 
@@ -22,6 +22,8 @@
 #include "qlight.h"
 
 bool antialias = false;
+bool occlusion_bvh = false;
+bool incremental = false;
 
 // we use the collision detection facilities for lighting
 static cm_bsp_model_t *bsp_models[MAX_BSP_MODELS];
@@ -391,6 +393,331 @@ cm_trace_t Light_Trace(const vec3_t start, const vec3_t end, int32_t head_node,
 	return trace;
 }
 
+/**
+ * @brief The vector types for packet tracing, one lane per ray. The compiler lowers these
+ * to SSE or AVX where available, and to scalar code otherwise.
+ */
+typedef float light_float_t __attribute__((vector_size(LIGHT_PACKET_SIZE * sizeof(float))));
+typedef int32_t light_int_t __attribute__((vector_size(LIGHT_PACKET_SIZE * sizeof(int32_t))));
+
+/**
+ * @brief Packet trace data, with ray start and end points in structure-of-arrays form.
+ */
+typedef struct {
+	/**
+	 * @brief The ray start and end points.
+	 */
+	light_float_t start[3], end[3];
+
+	/**
+	 * @brief The absolute bounds of the packet, spanning all rays.
+	 */
+	box3_t abs_bounds;
+
+	/**
+	 * @brief The contents mask to collide with.
+	 */
+	int32_t contents;
+
+	/**
+	 * @brief All bits are set in the lanes of occluded and unused rays.
+	 */
+	light_int_t occluded;
+
+	/**
+	 * @brief The brush cache, to avoid multiple tests against the same brush.
+	 */
+	int32_t brush_cache[128];
+} light_packet_data_t;
+
+/**
+ * @return True if any lane of the mask is set.
+ */
+static inline bool Light_PacketAny(const light_int_t mask) {
+
+	for (int32_t i = 0; i < LIGHT_PACKET_SIZE; i++) {
+		if (mask[i]) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief Yields the lanes of `a` where `mask` is set, and of `b` elsewhere. This is a macro
+ * so that vectors wider than the target's registers never cross a function boundary.
+ */
+#define LIGHT_PACKET_SELECT(mask, a, b) \
+	((light_float_t) (((mask) & (light_int_t) (a)) | (~(mask) & (light_int_t) (b))))
+
+/**
+ * @brief Yields the signed distances of the points `p` to `plane`.
+ */
+#define LIGHT_PACKET_DISTANCE(p, plane) \
+	(AXIAL(plane) ? (p)[(plane)->type] - (plane)->dist : \
+		(p)[0] * (plane)->normal.x + (p)[1] * (plane)->normal.y + (p)[2] * (plane)->normal.z - (plane)->dist)
+
+/**
+ * @brief Clips all unoccluded rays of the packet to the given brush. This is the vector
+ * form of Light_TraceToBrush, reduced to occlusion.
+ */
+static inline void Light_PacketTraceToBrush(light_packet_data_t *data, const cm_bsp_brush_t *brush) {
+
+	if (!brush->num_brush_sides) {
+		return;
+	}
+
+	if (!Box3_Intersects(data->abs_bounds, brush->bounds)) {
+		return;
+	}
+
+	const light_float_t zero = { 0.f };
+
+	light_float_t enter = zero - 1.f;
+	light_float_t leave = zero + 1.f;
+	light_float_t nudged = zero - 1.f;
+
+	light_int_t start_outside = { 0 }, end_outside = { 0 };
+	light_int_t miss = data->occluded;
+
+	const cm_bsp_brush_side_t *s = brush->brush_sides + brush->num_brush_sides - 1;
+	for (int32_t i = brush->num_brush_sides - 1; i >= 0; i--, s--) {
+
+		const cm_bsp_plane_t *p = s->plane;
+
+		const light_float_t d1 = data->start[0] * p->normal.x + data->start[1] * p->normal.y + data->start[2] * p->normal.z - p->dist;
+		const light_float_t d2 = data->end[0] * p->normal.x + data->end[1] * p->normal.y + data->end[2] * p->normal.z - p->dist;
+
+		start_outside |= d1 > 0.f;
+		end_outside |= d2 > 0.f;
+
+		// rays completely in front of any plane do not intersect with the brush
+		miss |= (d1 > 0.f) & (d2 >= d1);
+
+		if (!Light_PacketAny(~miss)) {
+			return;
+		}
+
+		// rays completely behind the plane do not intersect with this side
+		const light_int_t intersects = ~miss & ~((d1 <= 0.f) & (d2 <= d1));
+
+		const light_float_t d2d1_dist = d1 - d2;
+		const light_float_t f = d1 / d2d1_dist;
+
+		const light_int_t entering = intersects & (d1 > d2) & (f > enter);
+		enter = LIGHT_PACKET_SELECT(entering, f, enter);
+		nudged = LIGHT_PACKET_SELECT(entering, (d1 - TRACE_EPSILON) / d2d1_dist, nudged);
+
+		const light_int_t leaving = intersects & (d1 <= d2) & (f < leave);
+		leave = LIGHT_PACKET_SELECT(leaving, f, leave);
+	}
+
+	// rays starting inside the brush are occluded, as are those that pierce it
+	const light_int_t pierced = (enter < leave) & (enter > -1.f) & (enter < 1.f + TRACE_EPSILON) & (nudged < 1.f);
+
+	data->occluded |= ~miss & (~start_outside | pierced);
+}
+
+/**
+ * @brief
+ */
+static inline void Light_PacketTraceToLeaf(light_packet_data_t *data, int32_t leaf_num) {
+
+	const cm_bsp_leaf_t *leaf = &Cm_Bsp()->leafs[leaf_num];
+
+	if (!(leaf->contents & data->contents)) {
+		return;
+	}
+
+	for (int32_t i = 0; i < leaf->num_leaf_brushes; i++) {
+		const int32_t brush_num = Cm_Bsp()->leaf_brushes[leaf->first_leaf_brush + i];
+
+		const int32_t hash = brush_num & (lengthof(data->brush_cache) - 1);
+		if (data->brush_cache[hash] == brush_num) {
+			continue; // already checked this brush against all unoccluded rays
+		}
+
+		data->brush_cache[hash] = brush_num;
+
+		const cm_bsp_brush_t *b = &Cm_Bsp()->brushes[brush_num];
+
+		if (!(b->contents & data->contents)) {
+			continue;
+		}
+
+		Light_PacketTraceToBrush(data, b);
+
+		if (!Light_PacketAny(~data->occluded)) {
+			return;
+		}
+	}
+}
+
+/**
+ * @brief Recurses the packet down the BSP. Each ray carries its own interval `[t0, t1]`,
+ * and a child node is visited if any active ray's interval reaches it.
+ */
+static void Light_PacketTraceToNode(light_packet_data_t *data, int32_t num,
+									const light_float_t *start, const light_float_t *end, const light_int_t *mask) {
+
+	light_float_t t0 = *start, t1 = *end;
+	light_int_t active = *mask;
+
+	while (true) {
+
+		if (num < 0) {
+			Light_PacketTraceToLeaf(data, -1 - num);
+			return;
+		}
+
+		active &= ~data->occluded;
+
+		if (!Light_PacketAny(active)) {
+			return;
+		}
+
+		const cm_bsp_node_t *node = Cm_Bsp()->nodes + num;
+
+		const light_float_t ds = LIGHT_PACKET_DISTANCE(data->start, node->plane);
+		const light_float_t de = LIGHT_PACKET_DISTANCE(data->end, node->plane);
+
+		const light_float_t d0 = ds + (de - ds) * t0;
+		const light_float_t d1 = ds + (de - ds) * t1;
+
+		const light_int_t front = active & ((d0 >= 0.f) | (d1 >= 0.f));
+		const light_int_t back = active & ((d0 < 0.f) | (d1 < 0.f));
+
+		if (!Light_PacketAny(back)) {
+			num = node->children[0];
+			active = front;
+			continue;
+		}
+
+		if (!Light_PacketAny(front)) {
+			num = node->children[1];
+			active = back;
+			continue;
+		}
+
+		// split the intervals of the rays that cross the plane
+		const light_int_t cross = front & back;
+		const light_int_t cross_forward = cross & (d0 >= 0.f);
+		const light_int_t cross_backward = cross & (d0 < 0.f);
+
+		light_float_t tc = ds / (ds - de);
+		tc = LIGHT_PACKET_SELECT(tc < t0, t0, tc);
+		tc = LIGHT_PACKET_SELECT(tc > t1, t1, tc);
+
+		const light_float_t front_t0 = LIGHT_PACKET_SELECT(cross_backward, tc, t0);
+		const light_float_t front_t1 = LIGHT_PACKET_SELECT(cross_forward, tc, t1);
+
+		Light_PacketTraceToNode(data, node->children[0], &front_t0, &front_t1, &front);
+
+		num = node->children[1];
+
+		t0 = LIGHT_PACKET_SELECT(cross_forward, tc, t0);
+		t1 = LIGHT_PACKET_SELECT(cross_backward, tc, t1);
+		active = back;
+	}
+}
+
+/**
+ * @brief Traces up to LIGHT_PACKET_SIZE rays from a common start point for occlusion only.
+ * The rays walk the BSP together, and each brush they reach is clipped against all of them
+ * at once. Like Light_Trace, rays are clipped to the world and to the given head node.
+ * @return A bit mask of the occluded rays, equivalent to `Light_Trace(...).fraction < 1.f`.
+ */
+uint32_t Light_Occlusion(const vec3_t start, const vec3_t *ends, int32_t count, int32_t head_node, int32_t mask) {
+
+	assert(count <= LIGHT_PACKET_SIZE);
+
+	if (occlusion_bvh) {
+		uint32_t occluded = 0;
+
+		for (int32_t i = 0; i < count; i++) {
+			if (OccludedBVH(head_node, start, ends[i], mask)) {
+				occluded |= 1u << i;
+			}
+		}
+
+		return occluded;
+	}
+
+	light_packet_data_t data;
+
+	data.abs_bounds = Box3_FromPoints(&start, 1);
+	data.contents = mask;
+
+	for (int32_t i = 0; i < LIGHT_PACKET_SIZE; i++) {
+		const vec3_t end = i < count ? ends[i] : start;
+
+		for (int32_t j = 0; j < 3; j++) {
+			data.start[j][i] = start.xyz[j];
+			data.end[j][i] = end.xyz[j];
+		}
+
+		data.occluded[i] = i < count ? 0 : -1;
+		data.abs_bounds = Box3_Append(data.abs_bounds, end);
+	}
+
+	memset(data.brush_cache, 0xff, sizeof(data.brush_cache));
+
+	const light_float_t t0 = { 0.f }, t1 = t0 + 1.f;
+	const light_int_t active = ~data.occluded;
+
+	Light_PacketTraceToNode(&data, 0, &t0, &t1, &active);
+
+	if (head_node) {
+		Light_PacketTraceToNode(&data, head_node, &t0, &t1, &active);
+	}
+
+	uint32_t occluded = 0;
+
+	for (int32_t i = 0; i < count; i++) {
+		if (data.occluded[i]) {
+			occluded |= 1u << i;
+		}
+	}
+
+	return occluded;
+}
+
+/**
+ * @brief Adds a lumen to the packet, to be applied to the luxel if the point is visible.
+ */
+void Light_PacketAdd(light_packet_t *packet, const vec3_t point, const lumen_t *lumen) {
+
+	packet->points[packet->count] = point;
+	packet->lumens[packet->count] = *lumen;
+
+	if (++packet->count == LIGHT_PACKET_SIZE) {
+		Light_PacketFlush(packet);
+	}
+}
+
+/**
+ * @brief Traces the pending points of the packet, illuminating the luxel with the lumens
+ * of those that are visible.
+ */
+void Light_PacketFlush(light_packet_t *packet) {
+
+	if (packet->count == 0) {
+		return;
+	}
+
+	const uint32_t occluded = Light_Occlusion(packet->luxel->origin, packet->points, packet->count,
+											  packet->head_node, CONTENTS_SOLID);
+
+	for (int32_t i = 0; i < packet->count; i++) {
+		if (!(occluded & (1u << i))) {
+			Luxel_Illuminate(packet->luxel, &packet->lumens[i]);
+		}
+	}
+
+	packet->count = 0;
+}
+
 /**
  * @brief
  */
@@ -406,17 +733,27 @@ static void LightWorld(void) {
 		bsp_models[i] = Cm_Model(va("*%d", i));
 	}
 
+	// build the occlusion BVH, if requested
+	if (occlusion_bvh) {
+		BuildOcclusionBVH();
+	}
+
 	// build lightmaps
 	BuildLightmaps();
 
 	// build lightgrid
 	const size_t num_lightgrid = BuildLightgrid();
 
+	// load the results of the previous compile, if requested
+	if (incremental) {
+		LoadLightCache();
+	}
+
 	// build lights out of entities and emissive faces
 	BuildDirectLights();
 
 	// calculate direct lighting
-	Work("Direct lightmaps", DirectLightmap, bsp_file.num_faces);
+	WorkByCost("Direct lightmaps", DirectLightmap, bsp_file.num_faces, LightmapCost);
 	Work("Direct lightgrid", DirectLightgrid, (int32_t) num_lightgrid);
 
 	// indirect lighting
@@ -424,16 +761,22 @@ static void LightWorld(void) {
 	BuildIndirectLights();
 
 	// calculate indirect lighting
-	Work("Indirect lightmaps", IndirectLightmap, bsp_file.num_faces);
+	WorkByCost("Indirect lightmaps", IndirectLightmap, bsp_file.num_faces, LightmapCost);
 	Work("Indirect lightgrid", IndirectLightgrid, (int32_t) num_lightgrid);
 
 	// caustic effects
-	Work("Caustics lightmap", CausticsLightmap, bsp_file.num_faces);
+	WorkByCost("Caustics lightmap", CausticsLightmap, bsp_file.num_faces, LightmapCost);
 	Work("Caustics lightgrid", CausticsLightgrid, (int32_t) num_lightgrid);
 
 	// save the light sources to the BSP
 	EmitLights();
 
+	// save the results for the next compile
+	if (incremental) {
+		WriteLightCache();
+		FreeLightCache();
+	}
+
 	// free the light sources
 	FreeLights();
 
@@ -447,7 +790,7 @@ static void LightWorld(void) {
 	FreeFog();
 
 	// finalize it and write it to per-face textures
-	Work("Finalizing lightmaps", FinalizeLightmap, bsp_file.num_faces);
+	WorkByCost("Finalizing lightmaps", FinalizeLightmap, bsp_file.num_faces, LightmapCost);
 
 	// generate atlased lightmaps
 	EmitLightmap();
@@ -466,6 +809,9 @@ static void LightWorld(void) {
 
 	// free the lightgrid
 	Mem_FreeTag(MEM_TAG_LIGHTGRID);
+
+	// free the occlusion BVH
+	FreeOcclusionBVH();
 }
 
 /**
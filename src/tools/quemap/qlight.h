@@ -21,7 +21,9 @@
 
 #pragma once
 
+#include "bvh.h"
 #include "fog.h"
+#include "lightcache.h"
 #include "light.h"
 #include "lightgrid.h"
 #include "lightmap.h"
@@ -30,8 +32,35 @@
 #include "writebsp.h"
 
 extern bool antialias;
+extern bool occlusion_bvh;
+extern bool incremental;
+
+/**
+ * @brief The number of rays traced together by Light_Occlusion, matching the width of the
+ * target's vector registers.
+ */
+#if defined(__AVX__)
+	#define LIGHT_PACKET_SIZE 8
+#else
+	#define LIGHT_PACKET_SIZE 4
+#endif
+
+/**
+ * @brief Lumens awaiting an occlusion test from a common luxel, so that they may be traced
+ * together in a single packet.
+ */
+typedef struct {
+	luxel_t *luxel;
+	int32_t head_node;
+	vec3_t points[LIGHT_PACKET_SIZE];
+	lumen_t lumens[LIGHT_PACKET_SIZE];
+	int32_t count;
+} light_packet_t;
 
 int32_t Light_PointContents(const vec3_t p, int32_t head_node);
 cm_trace_t Light_Trace(const vec3_t start, const vec3_t end, int32_t head_node, int32_t mask);
+uint32_t Light_Occlusion(const vec3_t start, const vec3_t *ends, int32_t count, int32_t head_node, int32_t mask);
+void Light_PacketAdd(light_packet_t *packet, const vec3_t point, const lumen_t *lumen);
+void Light_PacketFlush(light_packet_t *packet);
 
 int32_t LIGHT_Main(void);
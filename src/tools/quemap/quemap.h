@@ -47,6 +47,7 @@ enum {
 	MEM_TAG_TREE,
 	MEM_TAG_PORTAL,
 	MEM_TAG_FACE,
+	MEM_TAG_VIS,
 	MEM_TAG_QLIGHT,
 	MEM_TAG_LIGHT,
 	MEM_TAG_LIGHTMAP,
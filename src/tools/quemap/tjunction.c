@@ -19,22 +19,42 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  */
 
+#include <SDL_timer.h>
+
 #include "tjunction.h"
 #include "portal.h"
 #include "qbsp.h"
 
-static SDL_atomic_t c_tjunctions;
-static GPtrArray *faces;
-static SDL_SpinLock *faces_locks;
-static int32_t largest_winding = 0;
+/**
+ * @brief The faces of a single tree, as t-junctions may be fixed for several trees at once.
+ */
+typedef struct {
+	GPtrArray *faces;
+	SDL_SpinLock *faces_locks;
+	int32_t largest_winding;
+	SDL_atomic_t c_tjunctions;
+} tjunctions_t;
 
 /**
  * @brief
  */
-static void FixTJunctions_(int32_t face_num) {
+static void FixTJunctions_(int32_t face_num, void *data) {
 	static _Thread_local cm_winding_t *face_winding, *f_winding;
+	static _Thread_local int32_t largest_winding;
+
+	tjunctions_t *tjunctions = data;
+
+	GPtrArray *faces = tjunctions->faces;
+	SDL_SpinLock *faces_locks = tjunctions->faces_locks;
+
+	if (largest_winding < tjunctions->largest_winding) {
+		if (face_winding) {
+			Cm_FreeWinding(face_winding);
+			Cm_FreeWinding(f_winding);
+		}
+
+		largest_winding = tjunctions->largest_winding;
 
-	if (!face_winding) {
 		face_winding = Cm_AllocWinding(largest_winding);
 		f_winding = Cm_AllocWinding(largest_winding);
 	}
@@ -116,7 +136,7 @@ static void FixTJunctions_(int32_t face_num) {
 
 				SDL_AtomicUnlock(face_lock);
 
-				SDL_AtomicAdd(&c_tjunctions, 1);
+				SDL_AtomicAdd(&tjunctions->c_tjunctions, 1);
 				break;
 			}
 		}
@@ -126,11 +146,11 @@ static void FixTJunctions_(int32_t face_num) {
 /**
  * @brief
  */
-static void FixTJunctions_r(node_t *node) {
+static void FixTJunctions_r(tjunctions_t *tjunctions, node_t *node) {
 
 	if (node->plane != PLANE_LEAF) {
-		FixTJunctions_r(node->children[0]);
-		FixTJunctions_r(node->children[1]);
+		FixTJunctions_r(tjunctions, node->children[0]);
+		FixTJunctions_r(tjunctions, node->children[1]);
 	}
 
 	for (face_t *face = node->faces; face; face = face->next) {
@@ -139,13 +159,13 @@ static void FixTJunctions_r(node_t *node) {
 			continue;
 		}
 		
-		if (g_ptr_array_find(faces, face, NULL)) {
+		if (g_ptr_array_find(tjunctions->faces, face, NULL)) {
 			continue;
 		}
 		
-		g_ptr_array_add(faces, face);
+		g_ptr_array_add(tjunctions->faces, face);
 
-		largest_winding = MAX(largest_winding, face->w->num_points);
+		tjunctions->largest_winding = MAX(tjunctions->largest_winding, face->w->num_points);
 	}
 }
 
@@ -155,19 +175,25 @@ static void FixTJunctions_r(node_t *node) {
 void FixTJunctions(tree_t *tree) {
 
 	Com_Verbose("--- FixTJunctions ---\n");
-	SDL_AtomicSet(&c_tjunctions, 0);
 
-	faces = g_ptr_array_new();
-	FixTJunctions_r(tree->head_node);
+	const uint32_t start = SDL_GetTicks();
+
+	tjunctions_t tjunctions = {
+		.faces = g_ptr_array_new()
+	};
+
+	FixTJunctions_r(&tjunctions, tree->head_node);
+
+	tjunctions.largest_winding = sizeof(cm_winding_t) + (sizeof(vec3_t) * tjunctions.largest_winding);
 
-	largest_winding = sizeof(cm_winding_t) + (sizeof(vec3_t) * largest_winding);
+	tjunctions.faces_locks = Mem_Malloc(sizeof(SDL_SpinLock) * tjunctions.faces->len);
 
-	faces_locks = Mem_Malloc(sizeof(SDL_SpinLock) * faces->len);
+	Thread_ParallelFor(tjunctions.faces->len, 0, FixTJunctions_, &tjunctions);
 
-	Work("Fixing t-junctions", FixTJunctions_, faces->len);
+	Com_Print("\r%-24s [100%%] %d ms\n", "Fixing t-junctions", SDL_GetTicks() - start);
 
-	Com_Verbose("%5i fixed tjunctions\n", SDL_AtomicGet(&c_tjunctions));
+	Com_Verbose("%5i fixed tjunctions\n", SDL_AtomicGet(&tjunctions.c_tjunctions));
 
-	Mem_Free(faces_locks);
-	g_ptr_array_free(faces, true);
+	Mem_Free(tjunctions.faces_locks);
+	g_ptr_array_free(tjunctions.faces, true);
 }
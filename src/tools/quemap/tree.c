@@ -190,26 +190,85 @@ static int32_t SelectSplitSideHeuristic(const brush_side_t *side, const csg_brus
 	return value;
 }
 
+/**
+ * @brief Nodes with at least this many brushes evaluate their candidate split sides, and
+ * build their child subtrees, in parallel.
+ */
+#define TREE_PARALLEL_BRUSHES 64
+
+/**
+ * @brief A candidate split side and its heuristic value.
+ */
+typedef struct {
+	const brush_side_t *side;
+	int32_t value;
+} split_candidate_t;
+
+/**
+ * @brief The candidates of a single SelectSplitSide, for parallel evaluation.
+ */
+typedef struct {
+	const node_t *node;
+	const csg_brush_t *brushes;
+	split_candidate_t *candidates;
+} split_candidates_t;
+
+/**
+ * @brief Evaluates a single candidate split side. Sides which do not split the node
+ * volume are assigned INT32_MIN, so that they are never selected.
+ */
+static void EvaluateSplitSide(int32_t index, void *data) {
+
+	const split_candidates_t *split = data;
+	split_candidate_t *candidate = &split->candidates[index];
+
+	csg_brush_t *front, *back;
+	SplitBrush(split->node->volume, candidate->side->plane ^ 1, &front, &back);
+	const bool valid_split = (front && back);
+	if (front) {
+		FreeBrush(front);
+	}
+	if (back) {
+		FreeBrush(back);
+	}
+
+	if (valid_split) {
+		candidate->value = SelectSplitSideHeuristic(candidate->side, split->brushes);
+	} else {
+		candidate->value = INT32_MIN;
+	}
+}
+
 /**
  * @return The original brush side from brushes with the highest heuristic value.
+ * @remarks Candidates are gathered and selected in brush order, so that ties resolve
+ * identically whether or not they were evaluated in parallel.
  */
 static const brush_side_t *SelectSplitSide(node_t *node, csg_brush_t *brushes) {
 
-	const brush_side_t *best_side = NULL;
-	int32_t best_value = INT32_MIN;
-
-	GPtrArray *cache = g_ptr_array_new();
+	int32_t num_brushes = 0, num_candidates = 0;
 
 	bool have_structural = false;
 	for (const csg_brush_t *brush = brushes; brush; brush = brush->next) {
 		if (!(brush->original->contents & CONTENTS_DETAIL)) {
 			if (brush->original->contents & CONTENTS_MASK_VISIBLE) {
 				have_structural = true;
-				break;
 			}
 		}
+		num_candidates += brush->num_brush_sides;
+		num_brushes++;
 	}
 
+	split_candidates_t split = {
+		.node = node,
+		.brushes = brushes,
+		.candidates = Mem_Malloc(sizeof(split_candidate_t) * Maxi(num_candidates, 1))
+	};
+
+	GHashTable *planes = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+	num_candidates = 0;
+
 	for (const csg_brush_t *brush = brushes; brush; brush = brush->next) {
 
 		if (brush->original->contents & CONTENTS_DETAIL) {
@@ -230,35 +289,38 @@ static const brush_side_t *SelectSplitSide(node_t *node, csg_brush_t *brushes) {
 
 			assert(side->winding);
 
-			const int32_t plane = side->plane ^ 1;
-			if (g_ptr_array_find(cache, (gconstpointer) (intptr_t) plane, NULL)) {
+			// only the first side on each plane is evaluated, since every other side
+			// on that plane splits the node volume identically
+			if (!g_hash_table_add(planes, GINT_TO_POINTER(side->plane ^ 1))) {
 				continue;
 			}
 
-			csg_brush_t *front, *back;
-			SplitBrush(node->volume, plane, &front, &back);
-			const bool valid_split = (front && back);
-			if (front) {
-				FreeBrush(front);
-			}
-			if (back) {
-				FreeBrush(back);
-			}
-			if (!valid_split) {
-				continue;
-			}
+			split.candidates[num_candidates++].side = side;
+		}
+	}
 
-			const int32_t value = SelectSplitSideHeuristic(side, brushes);
-			if (value > best_value) {
-				best_side = side->original;
-				best_value = value;
-			}
+	g_hash_table_destroy(planes);
 
-			g_ptr_array_add(cache, (gpointer) (intptr_t) plane);
+	if (num_brushes >= TREE_PARALLEL_BRUSHES) {
+		Thread_ParallelFor(num_candidates, 1, EvaluateSplitSide, &split);
+	} else {
+		for (int32_t i = 0; i < num_candidates; i++) {
+			EvaluateSplitSide(i, &split);
 		}
 	}
 
-	g_ptr_array_free(cache, true);
+	const brush_side_t *best_side = NULL;
+	int32_t best_value = INT32_MIN;
+
+	for (int32_t i = 0; i < num_candidates; i++) {
+		const split_candidate_t *candidate = &split.candidates[i];
+		if (candidate->value > best_value) {
+			best_side = candidate->side->original;
+			best_value = candidate->value;
+		}
+	}
+
+	Mem_Free(split.candidates);
 
 	return best_side;
 }
@@ -313,8 +375,30 @@ static void SplitBrushes(csg_brush_t *brushes, const node_t *node, csg_brush_t *
 	}
 }
 
+/**
+ * @brief A subtree to be built by a job.
+ */
+typedef struct {
+	node_t *node;
+	csg_brush_t *brushes;
+} build_tree_t;
+
+static node_t *BuildTree_r(node_t *node, csg_brush_t *brushes);
+
+/**
+ * @brief Job entry point for building a subtree.
+ */
+static void BuildTreeJob(void *data) {
+
+	const build_tree_t *build = data;
+
+	BuildTree_r(build->node, build->brushes);
+}
+
 /**
  * @brief
+ * @remarks Each subtree depends only on its node volume and brushes, so subtrees may be
+ * built concurrently without affecting the resulting tree.
  */
 static node_t *BuildTree_r(node_t *node, csg_brush_t *brushes) {
 	csg_brush_t *children[2];
@@ -341,9 +425,31 @@ static node_t *BuildTree_r(node_t *node, csg_brush_t *brushes) {
 
 	SplitBrush(node->volume, node->plane, &node->children[0]->volume, &node->children[1]->volume);
 
-	// recursively process children
-	for (int32_t i = 0; i < 2; i++) {
-		node->children[i] = BuildTree_r(node->children[i], children[i]);
+	// large subtrees are independent of one another, so the back child is built as a job
+	// while this thread builds the front child
+	int32_t num_back_brushes = 0;
+	for (const csg_brush_t *b = children[1]; b; b = b->next) {
+		if (++num_back_brushes == TREE_PARALLEL_BRUSHES) {
+			break;
+		}
+	}
+
+	if (num_back_brushes == TREE_PARALLEL_BRUSHES) {
+		build_tree_t back = {
+			.node = node->children[1],
+			.brushes = children[1]
+		};
+
+		thread_counter_t counter = 0;
+		Thread_Submit(BuildTreeJob, &back, &counter);
+
+		BuildTree_r(node->children[0], children[0]);
+
+		Thread_Join(&counter);
+	} else {
+		for (int32_t i = 0; i < 2; i++) {
+			BuildTree_r(node->children[i], children[i]);
+		}
 	}
 
 	return node;
@@ -407,7 +513,7 @@ tree_t *BuildTree(csg_brush_t *brushes) {
 	return tree;
 }
 
-static int32_t c_pruned;
+static _Thread_local int32_t c_pruned;
 
 /**
  * @brief
@@ -477,7 +583,7 @@ void PruneNodes(tree_t *tree) {
 	Com_Verbose("%5i pruned nodes\n", c_pruned);
 }
 
-static int32_t c_merged_faces;
+static _Thread_local int32_t c_merged_faces;
 
 /**
  * @brief
@@ -0,0 +1,418 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "bsp.h"
+#include "portal.h"
+#include "qbsp.h"
+#include "vis.h"
+
+/**
+ * @brief Vis portals are one-way: they are stored in the cluster they leave, and their
+ * plane faces into the cluster they lead to.
+ */
+typedef struct {
+	vec3_t normal;
+	double dist;
+	const cm_winding_t *winding;
+	int32_t from_cluster; // the cluster this portal leaves
+	int32_t cluster; // the cluster this portal leads to
+	byte *front; // portals at least partially in front of this one
+	byte *flood; // portals that may be seen through this one
+} vis_portal_t;
+
+/**
+ * @brief Vis clusters reference the portals leaving them.
+ */
+typedef struct {
+	int32_t first_portal;
+	int32_t num_portals;
+} vis_cluster_t;
+
+static struct {
+	GArray *portals;
+	int32_t num_portals;
+	int32_t portal_bytes;
+
+	vis_cluster_t *clusters;
+	int32_t num_clusters;
+	int32_t cluster_bytes;
+
+	byte *pvs; // uncompressed, [num_clusters][cluster_bytes]
+	byte *phs; // uncompressed, [num_clusters][cluster_bytes]
+} vis;
+
+#define VIS_PORTAL(i) (&g_array_index(vis.portals, vis_portal_t, i))
+
+/**
+ * @brief
+ */
+static void CountClusters_r(const node_t *node) {
+
+	if (node->plane == PLANE_LEAF) {
+		vis.num_clusters = Maxi(vis.num_clusters, node->cluster + 1);
+		return;
+	}
+
+	CountClusters_r(node->children[0]);
+	CountClusters_r(node->children[1]);
+}
+
+/**
+ * @brief Emits a pair of one-way vis portals for each portal separating two clusters.
+ */
+static void CreateVisPortals_r(const node_t *node, GArray *portals) {
+
+	// decision node
+	if (node->plane != PLANE_LEAF && !(node->split_side->contents & CONTENTS_DETAIL)) {
+		CreateVisPortals_r(node->children[0], portals);
+		CreateVisPortals_r(node->children[1], portals);
+		return;
+	}
+
+	if (node->contents & CONTENTS_SOLID) {
+		return;
+	}
+
+	int32_t s;
+	for (const portal_t *p = node->portals; p; p = p->next[s]) {
+		s = (p->nodes[1] == node);
+
+		if (!p->winding || p->nodes[0] != node) {
+			continue;
+		}
+
+		if (!Portal_VisFlood(p)) {
+			continue;
+		}
+
+		if (p->nodes[0]->cluster < 0 || p->nodes[1]->cluster < 0) {
+			continue;
+		}
+
+		vis_portal_t front = { .winding = p->winding }, back = { .winding = p->winding };
+
+		// resolve the plane from the winding, as the portal file does, and orient the
+		// clusters so that the front cluster is on the front side of that plane
+		Cm_PlaneForWinding(p->winding, &back.normal, &back.dist);
+
+		int32_t clusters[2] = { p->nodes[0]->cluster, p->nodes[1]->cluster };
+		if (Vec3_Dot(p->plane.normal, back.normal) < 0.99f) {
+			clusters[0] = p->nodes[1]->cluster;
+			clusters[1] = p->nodes[0]->cluster;
+		}
+
+		// the front cluster's portal faces back, into the back cluster
+		front.normal = Vec3_Negate(back.normal);
+		front.dist = -back.dist;
+		front.from_cluster = clusters[0];
+		front.cluster = clusters[1];
+
+		// and the back cluster's portal faces front, into the front cluster
+		back.from_cluster = clusters[1];
+		back.cluster = clusters[0];
+
+		g_array_append_val(portals, front);
+		g_array_append_val(portals, back);
+	}
+}
+
+/**
+ * @brief Sorts vis portals by the cluster they leave.
+ */
+static gint VisPortalCmp(gconstpointer a, gconstpointer b) {
+
+	const int32_t ca = ((const vis_portal_t *) a)->from_cluster;
+	const int32_t cb = ((const vis_portal_t *) b)->from_cluster;
+
+	return ca - cb;
+}
+
+/**
+ * @brief Resolves the portals that are at least partially in front of the specified portal,
+ * and then floods through them to find all portals that may possibly be seen through it.
+ */
+static void BasePortalVis(int32_t portal_num) {
+
+	vis_portal_t *p = VIS_PORTAL(portal_num);
+
+	for (int32_t i = 0; i < vis.num_portals; i++) {
+
+		if (i == portal_num) {
+			continue;
+		}
+
+		const vis_portal_t *tp = VIS_PORTAL(i);
+
+		// some point of the other portal must be in front of this one
+		int32_t j;
+		for (j = 0; j < tp->winding->num_points; j++) {
+			if (Vec3_Dot(tp->winding->points[j], p->normal) - p->dist > ON_EPSILON) {
+				break;
+			}
+		}
+
+		if (j == tp->winding->num_points) {
+			continue;
+		}
+
+		// and some point of this portal must be behind the other one
+		for (j = 0; j < p->winding->num_points; j++) {
+			if (Vec3_Dot(p->winding->points[j], tp->normal) - tp->dist < -ON_EPSILON) {
+				break;
+			}
+		}
+
+		if (j == p->winding->num_points) {
+			continue;
+		}
+
+		p->front[i >> 3] |= 1 << (i & 7);
+	}
+
+	// flood through the front portals, starting with the cluster this portal leads to
+	int32_t *stack = Mem_TagMalloc(sizeof(int32_t) * (vis.num_clusters + vis.num_portals), MEM_TAG_VIS);
+	int32_t depth = 0;
+
+	stack[depth++] = p->cluster;
+
+	while (depth) {
+		const vis_cluster_t *cluster = &vis.clusters[stack[--depth]];
+
+		for (int32_t i = 0; i < cluster->num_portals; i++) {
+			const int32_t n = cluster->first_portal + i;
+			const byte bit = 1 << (n & 7);
+
+			if (!(p->front[n >> 3] & bit)) {
+				continue;
+			}
+
+			if (p->flood[n >> 3] & bit) {
+				continue;
+			}
+
+			p->flood[n >> 3] |= bit;
+			stack[depth++] = VIS_PORTAL(n)->cluster;
+		}
+	}
+
+	Mem_Free(stack);
+}
+
+/**
+ * @brief Merges the portals that may be seen from each of the cluster's portals, and then
+ * converts those portals to the clusters they lead to.
+ */
+static void ClusterPVS(int32_t cluster_num) {
+
+	const vis_cluster_t *cluster = &vis.clusters[cluster_num];
+
+	byte *portals = Mem_TagMalloc(vis.portal_bytes, MEM_TAG_VIS);
+
+	for (int32_t i = 0; i < cluster->num_portals; i++) {
+		const int32_t n = cluster->first_portal + i;
+		const vis_portal_t *p = VIS_PORTAL(n);
+
+		for (int32_t j = 0; j < vis.portal_bytes; j++) {
+			portals[j] |= p->flood[j];
+		}
+
+		portals[n >> 3] |= 1 << (n & 7);
+	}
+
+	byte *pvs = vis.pvs + cluster_num * vis.cluster_bytes;
+
+	for (int32_t i = 0; i < vis.num_portals; i++) {
+		if (portals[i >> 3] & (1 << (i & 7))) {
+			const int32_t c = VIS_PORTAL(i)->cluster;
+			pvs[c >> 3] |= 1 << (c & 7);
+		}
+	}
+
+	pvs[cluster_num >> 3] |= 1 << (cluster_num & 7);
+
+	Mem_Free(portals);
+}
+
+/**
+ * @brief The hearable set of a cluster is the union of the visible sets of every
+ * cluster it can see.
+ */
+static void ClusterPHS(int32_t cluster_num) {
+
+	const byte *pvs = vis.pvs + cluster_num * vis.cluster_bytes;
+	byte *phs = vis.phs + cluster_num * vis.cluster_bytes;
+
+	memcpy(phs, pvs, vis.cluster_bytes);
+
+	for (int32_t i = 0; i < vis.num_clusters; i++) {
+		if (pvs[i >> 3] & (1 << (i & 7))) {
+			const byte *other = vis.pvs + i * vis.cluster_bytes;
+			for (int32_t j = 0; j < vis.cluster_bytes; j++) {
+				phs[j] |= other[j];
+			}
+		}
+	}
+}
+
+/**
+ * @brief Run-length encodes the zero bytes of the specified set into `out`.
+ * @return The length of the compressed set.
+ */
+static int32_t CompressVis(const byte *in, byte *out) {
+
+	byte *out_p = out;
+
+	for (int32_t i = 0; i < vis.cluster_bytes; i++) {
+		*out_p++ = in[i];
+
+		if (in[i]) {
+			continue;
+		}
+
+		int32_t count = 1;
+		while (i + 1 < vis.cluster_bytes && in[i + 1] == 0 && count < 255) {
+			count++;
+			i++;
+		}
+
+		*out_p++ = count;
+	}
+
+	return (int32_t) (out_p - out);
+}
+
+/**
+ * @brief Compresses the visible and hearable sets into the visibility lump.
+ */
+static void EmitVis(void) {
+
+	GByteArray *data = g_byte_array_new();
+
+	const int32_t header_size = (int32_t) (sizeof(int32_t) + vis.num_clusters * sizeof(int32_t) * 2);
+	g_byte_array_set_size(data, header_size);
+
+	byte *row = Mem_TagMalloc(vis.cluster_bytes * 2 + 1, MEM_TAG_VIS);
+
+	int32_t visible = 0, hearable = 0;
+
+	for (int32_t i = 0; i < vis.num_clusters; i++) {
+
+		const byte *pvs = vis.pvs + i * vis.cluster_bytes;
+		const byte *phs = vis.phs + i * vis.cluster_bytes;
+
+		for (int32_t j = 0; j < vis.num_clusters; j++) {
+			visible += (pvs[j >> 3] >> (j & 7)) & 1;
+			hearable += (phs[j >> 3] >> (j & 7)) & 1;
+		}
+
+		bsp_vis_t *header = (bsp_vis_t *) data->data;
+
+		header->bit_offsets[i][BSP_VIS_PVS] = data->len;
+		g_byte_array_append(data, row, CompressVis(pvs, row));
+
+		header = (bsp_vis_t *) data->data;
+
+		header->bit_offsets[i][BSP_VIS_PHS] = data->len;
+		g_byte_array_append(data, row, CompressVis(phs, row));
+	}
+
+	((bsp_vis_t *) data->data)->num_clusters = vis.num_clusters;
+
+	Mem_Free(row);
+
+	if (data->len >= MAX_BSP_VIS_SIZE) {
+		Com_Error(ERROR_FATAL, "MAX_BSP_VIS_SIZE\n");
+	}
+
+	bsp_file.vis_size = data->len;
+
+	Bsp_AllocLump(&bsp_file, BSP_LUMP_VIS, bsp_file.vis_size);
+	memcpy(bsp_file.vis, data->data, bsp_file.vis_size);
+
+	Com_Verbose("%5i clusters, %i visible, %i hearable on average\n", vis.num_clusters,
+				visible / Maxi(vis.num_clusters, 1), hearable / Maxi(vis.num_clusters, 1));
+
+	g_byte_array_free(data, true);
+}
+
+/**
+ * @brief Calculates the potentially visible and hearable sets of each cluster from the
+ * vis portals created by WritePortalFile. A portal may see another only if the latter is
+ * at least partially in front of it, and that relationship is flooded through the portal
+ * graph. This is conservative, never culling anything that could actually be seen.
+ */
+void CalcVis(tree_t *tree) {
+
+	Com_Verbose("--- CalcVis ---\n");
+
+	memset(&vis, 0, sizeof(vis));
+
+	CountClusters_r(tree->head_node);
+
+	if (vis.num_clusters == 0) {
+		return;
+	}
+
+	vis.portals = g_array_new(false, false, sizeof(vis_portal_t));
+
+	CreateVisPortals_r(tree->head_node, vis.portals);
+
+	g_array_sort(vis.portals, VisPortalCmp);
+
+	vis.num_portals = vis.portals->len;
+	vis.portal_bytes = (vis.num_portals + 7) >> 3;
+
+	vis.clusters = Mem_TagMalloc(sizeof(vis_cluster_t) * vis.num_clusters, MEM_TAG_VIS);
+	vis.cluster_bytes = (vis.num_clusters + 7) >> 3;
+
+	for (int32_t i = 0; i < vis.num_portals; i++) {
+		vis_portal_t *p = VIS_PORTAL(i);
+		vis_cluster_t *cluster = &vis.clusters[p->from_cluster];
+
+		if (cluster->num_portals == 0) {
+			cluster->first_portal = i;
+		}
+
+		cluster->num_portals++;
+
+		p->front = Mem_TagMalloc(vis.portal_bytes, MEM_TAG_VIS);
+		p->flood = Mem_TagMalloc(vis.portal_bytes, MEM_TAG_VIS);
+	}
+
+	Com_Verbose("%5i vis portals\n", vis.num_portals);
+
+	vis.pvs = Mem_TagMalloc(vis.num_clusters * vis.cluster_bytes, MEM_TAG_VIS);
+	vis.phs = Mem_TagMalloc(vis.num_clusters * vis.cluster_bytes, MEM_TAG_VIS);
+
+	Work("Portal vis", BasePortalVis, vis.num_portals);
+	Work("Cluster vis", ClusterPVS, vis.num_clusters);
+	Work("Cluster hearing", ClusterPHS, vis.num_clusters);
+
+	EmitVis();
+
+	g_array_free(vis.portals, true);
+
+	Mem_FreeTag(MEM_TAG_VIS);
+
+	memset(&vis, 0, sizeof(vis));
+
+	Com_Verbose("--- CalcVis complete ---\n");
+}
@@ -23,101 +23,203 @@
 
 #include "quemap.h"
 
+/**
+ * @brief Each claim takes roughly this fraction of the remaining work per thread, so that
+ * claims start large and shrink towards single iterations as the work runs out.
+ */
+#define WORK_GRAIN_DIVISOR 4
+
 typedef struct {
-	SDL_mutex *lock; // mutex on all running work
 	const char *name; // the work name
 	WorkFunc func; // the work function
-	int32_t index; // current work cycle
+	const int32_t *order; // optional dispatch order, most expensive first
 	int32_t count; // total work cycles
-	int32_t percent; // last fraction of work completed
+	int32_t num_workers; // the number of threads participating
+	atomic_int index; // next unclaimed work cycle
+	atomic_int completed; // completed work cycles
+	atomic_int percent; // last fraction of work completed
+	atomic_int claims; // number of chunks claimed
+	atomic_llong busy; // performance counter ticks spent in the work function
+	SDL_SpinLock print_lock; // held by the thread printing progress
 } work_t;
 
 static work_t work;
 
 /**
- * @brief Return an iteration of work, updating progress when appropriate.
+ * @brief Claims a chunk of work iterations.
+ * @return The number of iterations claimed, starting at `start`, or 0 if none remain.
  */
-static int32_t GetWork(void) {
+static int32_t GetWork(int32_t *start) {
 
-	int32_t w = -1;
-	SDL_LockMutex(work.lock);
+	int32_t index = atomic_load(&work.index);
 
-	if (Com_WasInit(QUEMAP)) {
-		if (work.index < work.count) {
+	while (index < work.count) {
 
-			// update work percent and output progress
-			const int32_t p = ceilf(100.0 * work.index / work.count);
-			if (p != work.percent) {
-				if (work.name) {
-					Com_Print("\r%-24s [%3d%%]", work.name, p);
-				}
-				work.percent = p;
-			}
+		const int32_t remaining = work.count - index;
+		const int32_t chunk = Maxi(1, remaining / (work.num_workers * WORK_GRAIN_DIVISOR));
 
-			// assign the next work iteration
-			w = work.index++;
+		if (atomic_compare_exchange_weak(&work.index, &index, index + chunk)) {
+			atomic_fetch_add(&work.claims, 1);
+			*start = index;
+			return chunk;
 		}
 	}
 
-	SDL_UnlockMutex(work.lock);
-	return w;
+	return 0;
+}
+
+/**
+ * @brief Updates the work percent and outputs progress, if no other thread is already
+ * doing so.
+ */
+static void UpdateProgress(int32_t completed) {
+
+	if (!work.name) {
+		return;
+	}
+
+	const int32_t p = ceilf(100.0 * completed / work.count);
+
+	if (p <= atomic_load(&work.percent)) {
+		return;
+	}
+
+	if (SDL_AtomicTryLock(&work.print_lock)) {
+
+		if (p > atomic_load(&work.percent)) {
+			Com_Print("\r%-24s [%3d%%]", work.name, p);
+			atomic_store(&work.percent, p);
+		}
+
+		SDL_AtomicUnlock(&work.print_lock);
+	}
 }
 
 /**
- * @brief Shared work entry point by all threads. Retrieve and perform
+ * @brief Shared work entry point by all threads. Claim and perform
  * chunks of work iteratively until work is finished.
  */
 static void RunWorkFunc(void *p) {
 
-	while (true) {
-		const int32_t w = GetWork();
-		if (w == -1) {
-			break;
+	int32_t start, chunk;
+
+	// this thread may have joined on unrelated, deferred work before claiming ours
+	GString *output = DeferOutput(NULL);
+
+	while (Com_WasInit(QUEMAP) && (chunk = GetWork(&start))) {
+
+		const uint64_t ticks = SDL_GetPerformanceCounter();
+
+		for (int32_t i = start; i < start + chunk; i++) {
+			work.func(work.order ? work.order[i] : i);
 		}
-		work.func(w);
+
+		atomic_fetch_add(&work.busy, (long long) (SDL_GetPerformanceCounter() - ticks));
+
+		UpdateProgress(atomic_fetch_add(&work.completed, chunk) + chunk);
 	}
+
+	DeferOutput(output);
 }
 
 /**
- * @brief Entry point for all thread work requests.
+ * @brief A work iteration and its estimated cost, for sorting.
  */
-void Work(const char *name, WorkFunc func, int32_t count) {
+typedef struct {
+	int32_t index;
+	int64_t cost;
+} work_cost_t;
+
+/**
+ * @brief Sorts work iterations by descending cost.
+ */
+static int32_t WorkCostCmp(const void *a, const void *b) {
+
+	const int64_t ca = ((const work_cost_t *) a)->cost;
+	const int64_t cb = ((const work_cost_t *) b)->cost;
+
+	return ca < cb ? 1 : ca > cb ? -1 : 0;
+}
+
+/**
+ * @brief Dispatches the work across all threads, and prints its statistics.
+ */
+static void Work_(const char *name, WorkFunc func, int32_t count, const int32_t *order) {
 
 	memset(&work, 0, sizeof(work));
 
-	work.lock = SDL_CreateMutex();
 	work.name = name;
-	work.count = count;
 	work.func = func;
-	work.index = 0;
+	work.order = order;
+	work.count = count;
+	work.num_workers = Thread_Count() + 1;
 	work.percent = -1;
 
-	const uint32_t start = SDL_GetTicks();
+	const uint64_t start = SDL_GetPerformanceCounter();
 
-	const int32_t thread_count = Thread_Count();
+	thread_counter_t counter = 0;
 
-	if (thread_count == 0) {
-		RunWorkFunc(0);
-	} else {
-		thread_t *threads[thread_count];
+	for (int32_t i = 1; i < work.num_workers; i++) {
+		Thread_Submit(RunWorkFunc, NULL, &counter);
+	}
 
-		for (int32_t i = 0; i < thread_count; i++) {
-			threads[i] = Thread_Create(RunWorkFunc, NULL, 0);
-		}
+	RunWorkFunc(NULL);
+
+	Thread_Join(&counter);
 
-		for (int32_t i = 0; i < thread_count; i++) {
-			Thread_Wait(threads[i]);
+	const double frequency = SDL_GetPerformanceFrequency();
+	const double seconds = (SDL_GetPerformanceCounter() - start) / frequency;
+
+	if (work.name) {
+		if (work.count && atomic_load(&work.completed) == work.count && atomic_load(&work.percent) < 100) {
+			Com_Print("\r%-24s [%3d%%]", work.name, 100);
 		}
+
+		Com_Print(" %d ms\n", (int32_t) (seconds * 1000.0));
 	}
 
-	SDL_DestroyMutex(work.lock);
-	work.lock = NULL;
+	if (work.name && work.count) {
+		const double busy = atomic_load(&work.busy) / frequency;
 
-	const uint32_t end = SDL_GetTicks();
+		Com_Verbose("%-24s %d items, %.0f items/s, %d chunks, %.0f%% utilization\n", "",
+					count, seconds > 0.0 ? count / seconds : 0.0, atomic_load(&work.claims),
+					seconds > 0.0 ? 100.0 * busy / (seconds * work.num_workers) : 100.0);
+	}
+}
 
-	if (work.name) {
-		Com_Print(" %d ms\n", end - start);
+/**
+ * @brief Entry point for all thread work requests.
+ */
+void Work(const char *name, WorkFunc func, int32_t count) {
+	Work_(name, func, count, NULL);
+}
+
+/**
+ * @brief Entry point for thread work requests whose iterations vary greatly in cost.
+ * The most expensive iterations are dispatched first, so that the cheapest remain to
+ * balance the threads as the work finishes.
+ */
+void WorkByCost(const char *name, WorkFunc func, int32_t count, WorkCostFunc cost) {
+
+	work_cost_t *costs = Mem_Malloc(sizeof(work_cost_t) * Maxi(count, 1));
+	int32_t *order = Mem_Malloc(sizeof(int32_t) * Maxi(count, 1));
+
+	for (int32_t i = 0; i < count; i++) {
+		costs[i].index = i;
+		costs[i].cost = cost(i);
 	}
+
+	qsort(costs, count, sizeof(work_cost_t), WorkCostCmp);
+
+	for (int32_t i = 0; i < count; i++) {
+		order[i] = costs[i].index;
+	}
+
+	Mem_Free(costs);
+
+	Work_(name, func, count, order);
+
+	Mem_Free(order);
 }
 
 /**
@@ -130,6 +232,11 @@ void Progress(const char *progress, int32_t percent) {
 	static int32_t index = 0;
 	static int32_t last_percent;
 
+	// progress may be reported from any thread, but is only printed by the main thread
+	if (SDL_ThreadID() != thread_main || DeferredOutput()) {
+		return;
+	}
+
 	if (Mon_IsConnected() && percent != 0 && percent != 100) {
 		static uint32_t last_ticks;
 		if (SDL_GetTicks() - last_ticks < 200) {
@@ -148,3 +255,27 @@ void Progress(const char *progress, int32_t percent) {
 		}
 	}
 }
+
+static _Thread_local GString *deferred_output;
+
+/**
+ * @brief Defers all console output from the calling thread to the given buffer, so that
+ * work running concurrently may be reported in a deterministic order.
+ * @param output The buffer to collect output in, or NULL to resume printing.
+ * @return The previous buffer, which the caller should restore when finished.
+ */
+GString *DeferOutput(GString *output) {
+
+	GString *previous = deferred_output;
+
+	deferred_output = output;
+
+	return previous;
+}
+
+/**
+ * @return The buffer collecting the calling thread's output, or NULL.
+ */
+GString *DeferredOutput(void) {
+	return deferred_output;
+}
@@ -24,6 +24,10 @@
 #include "common/thread.h"
 
 typedef void (*WorkFunc)(int32_t);
+typedef int64_t (*WorkCostFunc)(int32_t);
 
 void Work(const char *name, WorkFunc func, int32_t count);
+void WorkByCost(const char *name, WorkFunc func, int32_t count, WorkCostFunc cost);
 void Progress(const char *name, int32_t percent);
+GString *DeferOutput(GString *output);
+GString *DeferredOutput(void);